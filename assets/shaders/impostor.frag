@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec2 tex_coord;
+
+out vec4 frag_color;
+
+uniform sampler2D atlas;
+
+void main() {
+    vec4 color = texture(atlas, tex_coord);
+    /// the background of the views is transparent
+    if(color.a < 0.5) discard;
+    /// the atlas was baked over transparent black, so its mip levels hold premultiplied colors
+    frag_color = vec4(color.rgb / color.a, 1.0);
+}
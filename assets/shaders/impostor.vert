@@ -0,0 +1,24 @@
+#version 330 core
+
+/// the corner of the quad (from -1 to 1 on each axis)
+layout(location = 0) in vec2 corner;
+/// per instance: the world position of the center of the quad (xyz) and its half size (w)
+layout(location = 1) in vec4 center_size;
+/// per instance: the rectangle of the view in the atlas (xy: min corner, zw: size)
+layout(location = 2) in vec4 cell;
+
+out vec2 tex_coord;
+
+uniform mat4 VP;
+uniform vec3 camera_position;
+
+void main() {
+    /// the quad stays upright and turns around the up axis to face the camera (like the views baked in the atlas)
+    vec3 up = vec3(0.0, 1.0, 0.0);
+    vec3 right = cross(up, camera_position - center_size.xyz);
+    /// when the camera is right above the instance, any horizontal direction will do
+    right = dot(right, right) > 1e-8 ? normalize(right) : vec3(1.0, 0.0, 0.0);
+    vec3 position = center_size.xyz + (corner.x * right + corner.y * up) * center_size.w;
+    gl_Position = VP * vec4(position, 1.0);
+    tex_coord = cell.xy + (corner * 0.5 + 0.5) * cell.zw;
+}
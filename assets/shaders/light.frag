@@ -22,18 +22,30 @@ in Varyings {
 //final color of the vertex that will be drawn on the screen
 out vec4 frag_color;
 
+//Each map of the material is either a layer in a texture array or a constant color
+//(the texture arrays are shared between materials whose images have the same size, and single color images are never uploaded)
+struct MaterialMap {
+    sampler2DArray array;
+    //the index of the layer in the array or -1 to use the constant color instead
+    int layer;
+    vec4 color;
+};
+
 struct Material {
     //measure of ability to reflect light
-    sampler2D albedo;
+    MaterialMap albedo;
     //reflection of light from a surface in a specific direction.
-    sampler2D specular;
+    MaterialMap specular;
     //to create more realistic shadows 
-    sampler2D ambient_occlusion;
-    sampler2D roughness;
+    MaterialMap ambient_occlusion;
+    MaterialMap roughness;
     //materials or objects that emit their own light. 
-    sampler2D emissive;
+    MaterialMap emissive;
 };
 
+//read a material map at the fragment's texture coordinates
+#define SAMPLE_MAP(map) ((map).layer < 0 ? (map).color : texture((map).array, vec3(fs_in.tex_coord, float((map).layer))))
+
 
 struct Light {
     //directional, point or spot light
@@ -66,9 +78,14 @@ struct Sky {
 
 //uniforms are variables that are sent from the CPU to the GPU
 //Uniform variables are used to pass data that is constant across all vertices in a draw call.
-uniform Light lights[MAX_LIGHTS];
-//number of light sources in the scene
-uniform int light_count;
+//The lights are in the per-frame block that the renderer streams through a uniform buffer (it must match the one in light.vert)
+layout(std140) uniform FrameData {
+    mat4 VP;
+    vec3 camera_position;
+    //number of light sources in the scene
+    int light_count;
+    Light lights[MAX_LIGHTS];
+};
 //ambient color struct
 uniform Sky sky;
 //The lit material
@@ -80,12 +97,12 @@ void main(){
     vec3 normal = normalize(fs_in.normal);
 
     //get diffuse, specular, roughness, ambient, emissive of the material from their sent textures
-    vec3 material_diffuse = texture(material.albedo, fs_in.tex_coord).rgb;
-    vec3 material_specular = texture(material.specular, fs_in.tex_coord).rgb;
-    vec3 material_ambient = material_diffuse * texture(material.ambient_occlusion, fs_in.tex_coord).r;
-    vec3 material_emissive = texture(material.emissive, fs_in.tex_coord).rgb;
+    vec3 material_diffuse = SAMPLE_MAP(material.albedo).rgb;
+    vec3 material_specular = SAMPLE_MAP(material.specular).rgb;
+    vec3 material_ambient = material_diffuse * SAMPLE_MAP(material.ambient_occlusion).r;
+    vec3 material_emissive = SAMPLE_MAP(material.emissive).rgb;
 
-    float material_roughness = texture(material.roughness, fs_in.tex_coord).r;
+    float material_roughness = SAMPLE_MAP(material.roughness).r;
     //compute the shininess of the material
     //This function clamps the value of "roughness" between 0.001 and 0.999. If the value of "roughness" is less than 0.001, it will be set to 0.001, and if it is greater than 0.999, it will be set to 0.999.
     //to avoid 0 and infinity
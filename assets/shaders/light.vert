@@ -17,21 +17,41 @@ layout(location = 3) in vec3 normal;
 
 //uniforms are variables that are sent from the CPU to the GPU
 
-// 1- Object to World.
-//The model matrix
-//to transform the vertices of a 3D object from its local coordinate system to the world coordinate system.
-uniform mat4 M;
-//Inverse transpose of model matrix
-//is used for normal transformation
-//because it removes any scaling and rotation applied to the model matrix and ensures that the resulting normal vector is perpendicular to the surface it represents.
-uniform mat4 M_IT;
-//(View-Projection) Matrix: Camera View Matrix*Projection Matrix.
-//It transforms objects from world space into screen space.
-// 2- World to Homogenous Clipspace.
-uniform mat4 VP;
-// The camera position matrix is used to translate objects in camera space based on the position of the camera.
-//used in frag shader to compute specular
-uniform vec3 camera_position;
+//The uniforms are grouped into blocks that the renderer streams through a uniform buffer (see "uniform-blocks.hpp")
+//The block layouts must match the C++ structs and the FrameData block must be identical in the fragment shader
+#define MAX_LIGHTS 16
+
+struct Light {
+    int type;
+    vec3 position;
+    vec3 direction;
+    vec3 diffuse;
+    vec3 specular;
+    vec3 attenuation;
+    vec2 cone_angles;
+};
+
+//The data shared by all the objects of a frame
+layout(std140) uniform FrameData {
+    //(View-Projection) Matrix: Camera View Matrix*Projection Matrix.
+    //It transforms objects from world space into screen space.
+    mat4 VP;
+    // The camera position is used to compute the vertex to eye vector (used in frag shader to compute specular)
+    vec3 camera_position;
+    int light_count;
+    Light lights[MAX_LIGHTS];
+};
+
+//The data of the object being drawn
+layout(std140) uniform ObjectData {
+    //The model matrix
+    //to transform the vertices of a 3D object from its local coordinate system to the world coordinate system.
+    mat4 M;
+    //Inverse transpose of model matrix
+    //is used for normal transformation
+    //because it removes any scaling and rotation applied to the model matrix and ensures that the resulting normal vector is perpendicular to the surface it represents.
+    mat4 M_IT;
+};
 
 
 //Varyings are "out" from a shader and "in" to another shader
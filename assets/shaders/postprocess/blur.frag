@@ -0,0 +1,26 @@
+#version 330
+
+// The texture holding the scene pixels
+uniform sampler2D tex;
+
+// The blur is separable: a 2D gaussian blur is a horizontal blur followed by a vertical blur
+// so it is applied in two stages, one with direction = (1, 0) and another with direction = (0, 1)
+uniform vec2 direction;
+
+// Read "assets/shaders/fullscreen.vert" to know what "tex_coord" holds;
+in vec2 tex_coord;
+out vec4 frag_color;
+
+// The weights of a 9-tap gaussian kernel merged into 5 taps by sampling between pixels
+// (bilinear filtering averages the two neighbouring pixels for us)
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main(){
+    vec2 step_vector = direction / vec2(textureSize(tex, 0));
+    frag_color = texture(tex, tex_coord) * weights[0];
+    for(int i = 1; i < 3; i++){
+        frag_color += texture(tex, tex_coord + step_vector * offsets[i]) * weights[i];
+        frag_color += texture(tex, tex_coord - step_vector * offsets[i]) * weights[i];
+    }
+}
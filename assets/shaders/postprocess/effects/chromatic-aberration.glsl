@@ -0,0 +1,16 @@
+// Chromatic aberration (same as "../chromatic-aberration.frag"): reads the red & blue channels from neighbouring pixels
+// This is a sampling effect: it reads its input more than once through "fetch" which applies the remapping effects that come before it
+
+// How far (in the texture space) is the distance (on the x-axis) between
+// the pixels from which the red/green (or green/blue) channels are sampled
+#define CHROMATIC_ABERRATION_STRENGTH 0.005
+
+vec4 chromatic_aberration_sample(vec2 uv){
+    vec4 center = fetch(uv);
+    return vec4(
+        fetch(uv - vec2(CHROMATIC_ABERRATION_STRENGTH, 0.0)).r,
+        center.g,
+        fetch(uv + vec2(CHROMATIC_ABERRATION_STRENGTH, 0.0)).b,
+        center.a
+    );
+}
@@ -0,0 +1,9 @@
+// Fisheye (same as "../fisheye.frag"): magnifies the pixels near the center of the screen
+// This is a UV-remapping effect: it only changes where the input is read
+vec2 fisheye_remap(vec2 uv){
+    vec2 center = vec2(0.5, 0.5); // center of the fisheye circle
+    float scale = -0.3;           // controls the amount of distortion applied to the texture.
+    // calculate the percentage of the distortion based on the pixel's position from the center
+    float percent = 1.0 + ((0.5 - distance(center, uv)) / 0.5) * scale;
+    return (uv - center) * percent + center;
+}
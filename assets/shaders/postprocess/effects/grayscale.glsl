@@ -0,0 +1,6 @@
+// Grayscale (same as "../grayscale.frag"): sets all the channels to their average
+// This is a per-pixel color effect
+vec4 grayscale_color(vec4 color, vec2 uv){
+    float gray = dot(color.rgb, vec3(1.0/3.0, 1.0/3.0, 1.0/3.0));
+    return vec4(vec3(gray), color.a);
+}
@@ -0,0 +1,8 @@
+// Vignette (same as "../vignette.frag"): darkens the corners of the screen
+// This is a per-pixel color effect: "uv" is the position of the pixel on the screen
+vec4 vignette_color(vec4 color, vec2 uv){
+    // convert from texture coordinate space ranges (from 0 to 1) to NDC space ranges (from -1 to 1)
+    vec2 ndc_coord = uv * 2.0 - 1.0;
+    // divide the color by 1 + the squared length of the pixel location in the NDC space
+    return color / (1.0 + dot(ndc_coord, ndc_coord));
+}
@@ -0,0 +1,35 @@
+#version 330
+
+// The low resolution scene
+uniform sampler2D tex;
+// The strength of the sharpening (0 to 1)
+uniform float sharpness;
+
+// Read "assets/shaders/fullscreen.vert" to know what "tex_coord" holds;
+in vec2 tex_coord;
+out vec4 frag_color;
+
+// This shader upscales the scene with bilinear filtering then restores some of the lost detail with an edge-aware sharpening filter
+// (a contrast adaptive sharpening): the sharpening is strong where the local contrast is low and fades out near strong edges
+// so that edges don't get halos and already sharp details don't get amplified.
+void main(){
+    vec2 texel = 1.0 / vec2(textureSize(tex, 0));
+
+    vec4 center = texture(tex, tex_coord);
+    vec3 north = texture(tex, tex_coord + vec2(0.0, texel.y)).rgb;
+    vec3 south = texture(tex, tex_coord - vec2(0.0, texel.y)).rgb;
+    vec3 east = texture(tex, tex_coord + vec2(texel.x, 0.0)).rgb;
+    vec3 west = texture(tex, tex_coord - vec2(texel.x, 0.0)).rgb;
+
+    // The local contrast is estimated from the range of the neighborhood
+    vec3 minimum = min(center.rgb, min(min(north, south), min(east, west)));
+    vec3 maximum = max(center.rgb, max(max(north, south), max(east, west)));
+    // The amount is 1 for flat regions and goes down to 0 as the neighborhood approaches the full [0, 1] range
+    vec3 amount = sqrt(clamp(min(minimum, 1.0 - maximum) / max(maximum, 1e-4), 0.0, 1.0));
+
+    // The negative weight of the neighbors (-1/8 is a soft sharpening, -1/5 is the strongest)
+    vec3 weight = amount * (-1.0 / mix(8.0, 5.0, sharpness));
+    vec3 color = (center.rgb + (north + south + east + west) * weight) / (1.0 + 4.0 * weight);
+
+    frag_color = vec4(clamp(color, 0.0, 1.0), center.a);
+}
@@ -191,7 +191,12 @@ if( ($tests.Count -eq 0) -or ($tests -contains $requirement)){
         "test-0.png",
         "test-1.png",
         "test-2.png",
-        "test-3.png"
+        "test-3.png",
+        "fused-0.png",
+        "fused-2.png",
+        "fused-3.png",
+        "test-4.png",
+        "fused-4.png"
     )
     Write-Output ""
     Write-Output "Comparing $requirement output:"
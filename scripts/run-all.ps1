@@ -1,9 +1,14 @@
-param([string[]] $tests)
+param([string[]] $tests, [switch] $headless)
 
 function Invoke-Tests {
     param([string[]] $configs)
     foreach ($config in $configs){
-        ./bin/GAME_APPLICATION -f=2 -c="$config"
+        # With -headless, the tests run without a window (e.g. on a Linux build machine without a display)
+        if ($headless) {
+            ./bin/GAME_APPLICATION -f=2 -c="$config" --headless
+        } else {
+            ./bin/GAME_APPLICATION -f=2 -c="$config"
+        }
     }
 }
 
@@ -195,7 +200,12 @@ if( ($tests.Count -eq 0) -or ($tests -contains "postprocess-test")){
         "config/postprocess-test/test-0.jsonc",
         "config/postprocess-test/test-1.jsonc",
         "config/postprocess-test/test-2.jsonc",
-        "config/postprocess-test/test-3.jsonc"
+        "config/postprocess-test/test-3.jsonc",
+        "config/postprocess-test/fused-0.jsonc",
+        "config/postprocess-test/fused-2.jsonc",
+        "config/postprocess-test/fused-3.jsonc",
+        "config/postprocess-test/test-4.jsonc",
+        "config/postprocess-test/fused-4.jsonc"
     )
     Write-Output ""
     Write-Output "Running postprocess-test:"
@@ -0,0 +1,50 @@
+param(
+    # The entity counts to measure (one benchmark run each)
+    [int[]] $entities = @(1000, 10000, 50000, 100000, 250000, 500000, 1000000),
+    # More generator settings as key=value separated by commas (e.g. "depth=3,moving=0.5")
+    [string] $settings = "",
+    [string] $config = "config/synthetic.jsonc",
+    [string] $output = "benchmarks/scaling",
+    # With -headless, the scenes are rendered offscreen. With -nullgl, nothing is rendered (only the CPU side is measured).
+    [switch] $headless,
+    [switch] $nullgl
+)
+
+# Runs the synthetic scene as a benchmark for every entity count, then gathers the reports into a CSV table (one row per count)
+New-Item -ItemType Directory -Force -Path $output | Out-Null
+$rows = @()
+foreach ($count in $entities){
+    $report = "$output/entities-$count.json"
+    $synthetic = "entities=$count"
+    if ($settings) { $synthetic = "$synthetic,$settings" }
+    $arguments = @("-c=$config", "--bench", "--bench-report=$report", "--synthetic=$synthetic")
+    if ($headless) { $arguments += "--headless" }
+    if ($nullgl) { $arguments += "--gl=null" }
+
+    # An old report must not be mistaken for the result of this run
+    Remove-Item $report -ErrorAction SilentlyContinue
+    Write-Output "Running $count entities"
+    ./bin/GAME_APPLICATION @arguments
+    if (-not (Test-Path $report)) {
+        Write-Output "No report for $count entities"
+        continue
+    }
+
+    $result = Get-Content $report -Raw | ConvertFrom-Json
+    $rows += [PSCustomObject]@{
+        entities = $count
+        loadTime = $result.sceneDescription.loadTime
+        frameP50 = $result.frameTime.p50
+        frameP95 = $result.frameTime.p95
+        cpuP50 = $result.cpuTime.p50
+        gpuP50 = if ($result.gpuTime) { $result.gpuTime.p50 } else { "" }
+        movementP50 = $result.systems.MovementSystem.p50
+        rendererP50 = $result.systems.ForwardRenderer.p50
+        drawCalls = $result.drawCalls.average
+        peakMemoryMB = $result.peakMemoryMB
+    }
+}
+
+$rows | Export-Csv -NoTypeInformation -Path "$output/scaling.csv"
+$rows | Format-Table
+Write-Output "The table is written to $output/scaling.csv"
@@ -0,0 +1,244 @@
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <flags/flags.h>
+#include <json/json.hpp>
+
+#include <application.hpp>
+#include <asset-loader.hpp>
+#include <ecs/world.hpp>
+#include <components/camera.hpp>
+#include <components/collision.hpp>
+#include <components/free-camera-controller.hpp>
+#include <components/lighting.hpp>
+#include <components/mesh-renderer.hpp>
+#include <components/movement.hpp>
+#include <systems/forward-renderer.hpp>
+#include <systems/free-camera-controller.hpp>
+#include <systems/movement.hpp>
+#include <systems/collision.hpp>
+#include <mesh/mesh-utils.hpp>
+#include <gl/null-context.hpp>
+#include <gl/state-cache.hpp>
+#include <profiling/scene-generator.hpp>
+
+#include "micro-benchmark.hpp"
+
+// The micro-benchmarks of the hot functions of the engine. Each one prints the time & the heap allocations per operation.
+// The OpenGL functions are the stubs of the null backend, so the benchmarks need neither a GPU nor a display and the
+// renderer benchmarks only measure its CPU side. Like the application, it must run from the root of the project (for the assets).
+
+namespace {
+
+    // A generated scene that only uses the two smallest meshes (cube & sphere) for the benchmarks that need mesh renderers
+    our::SceneGenerator makeGenerator(int entities, int depth, float moving){
+        our::SceneGenerator generator;
+        generator.settings.entities = entities;
+        generator.settings.depth = depth;
+        generator.settings.moving = moving;
+        generator.settings.meshes = 2;
+        generator.generate();
+        return generator;
+    }
+
+    void benchmarkTransforms(our::bench::Runner& runner){
+        runner.run("Transform::toMat4", [](our::bench::Runner& runner){
+            // Many different transforms, so the compiler can't compute the result once for all the calls
+            std::vector<our::Transform> transforms(1024);
+            std::mt19937 random(1);
+            std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+            for(auto& transform : transforms){
+                transform.position = {distribution(random), distribution(random), distribution(random)};
+                transform.rotation = {distribution(random), distribution(random), distribution(random)};
+                transform.scale = glm::vec3(1.0f + 0.1f * distribution(random));
+            }
+            size_t index = 0;
+            runner.measure([&](){
+                glm::mat4 matrix = transforms[index++ & 1023].toMat4();
+                our::bench::consume(&matrix);
+            });
+        });
+
+        for(int depth : {1, 4, 16}){
+            runner.run("Entity::getLocalToWorldMatrix/depth=" + std::to_string(depth), [depth](our::bench::Runner& runner){
+                our::World world;
+                our::Entity* entity = nullptr;
+                for(int level = 0; level < depth; ++level){
+                    our::Entity* child = world.add();
+                    child->parent = entity;
+                    child->localTransform.position = {1.0f, 0.0f, 0.0f};
+                    child->localTransform.rotation = {0.0f, 0.1f, 0.0f};
+                    entity = child;
+                }
+                runner.measure([&](){
+                    glm::mat4 matrix = entity->getLocalToWorldMatrix();
+                    our::bench::consume(&matrix);
+                });
+            });
+        }
+    }
+
+    void benchmarkComponents(our::bench::Runner& runner){
+        // An entity with 5 components. The lookup is linear, so the first & the last components are the best & the worst cases.
+        auto makeEntity = [](our::World& world){
+            our::Entity* entity = world.add();
+            entity->addComponent<our::MeshRendererComponent>();
+            entity->addComponent<our::MovementComponent>();
+            entity->addComponent<our::CollisionComponent>();
+            entity->addComponent<our::LightComponent>();
+            entity->addComponent<our::FreeCameraControllerComponent>();
+            return entity;
+        };
+        runner.run("Entity::getComponent/first", [&](our::bench::Runner& runner){
+            our::World world;
+            our::Entity* entity = makeEntity(world);
+            runner.measure([&](){ our::bench::consume(entity->getComponent<our::MeshRendererComponent>()); });
+        });
+        runner.run("Entity::getComponent/last", [&](our::bench::Runner& runner){
+            our::World world;
+            our::Entity* entity = makeEntity(world);
+            runner.measure([&](){ our::bench::consume(entity->getComponent<our::FreeCameraControllerComponent>()); });
+        });
+        runner.run("Entity::getComponent/missing", [&](our::bench::Runner& runner){
+            our::World world;
+            our::Entity* entity = makeEntity(world);
+            runner.measure([&](){ our::bench::consume(entity->getComponent<our::CameraComponent>()); });
+        });
+    }
+
+    void benchmarkDeserialization(our::bench::Runner& runner){
+        runner.run("World::deserialize/1000", [](our::bench::Runner& runner){
+            our::SceneGenerator generator = makeGenerator(0, 1, 0.0f);
+            our::deserializeAllAssets(generator.getAssets());
+            nlohmann::json data = nlohmann::json::array();
+            for(int index = 0; index < 1000; ++index){
+                data.push_back({
+                    {"name", "entity" + std::to_string(index)},
+                    {"position", {index % 32, 0, index / 32}},
+                    {"rotation", {0, index, 0}},
+                    {"scale", {1, 1, 1}},
+                    {"components", {
+                        {{"type", "Mesh Renderer"}, {"mesh", "cube"}, {"material", "material" + std::to_string(index % 8)}},
+                        {{"type", "Movement"}, {"angularVelocity", {0, 45, 0}}},
+                    }},
+                });
+            }
+            our::World world;
+            runner.measureEach([&](){ world.clear(); }, [&](){ world.deserialize(data); });
+            world.clear();
+            our::clearAllAssets();
+        });
+
+        // The levels of detail are a big part of the loading time of a mesh, so the loading is measured with & without them
+        for(int lods : {0, 4}){
+            runner.run("mesh_utils::loadOBJ/monkey,lods=" + std::to_string(lods), [lods](our::bench::Runner& runner){
+                our::Mesh* mesh = nullptr;
+                runner.measureEach([&](){ delete mesh; mesh = nullptr; }, [&](){ mesh = our::mesh_utils::loadOBJ("assets/models/monkey.obj", lods); });
+                delete mesh;
+            });
+        }
+    }
+
+    void benchmarkSystems(our::bench::Runner& runner){
+        for(int entities : {1000, 10000, 100000}){
+            runner.run("MovementSystem::update/" + std::to_string(entities), [entities](our::bench::Runner& runner){
+                our::SceneGenerator generator = makeGenerator(entities, 1, 0.5f);
+                our::deserializeAllAssets(generator.getAssets());
+                our::World world;
+                generator.populate(&world);
+                our::MovementSystem movementSystem;
+                runner.measure([&](){ movementSystem.update(&world, 1.0f / 60.0f); });
+                world.clear();
+                our::clearAllAssets();
+            });
+        }
+
+        // Every collider is tested against every other one, so the cost grows with the square of the count
+        for(int entities : {100, 400}){
+            runner.run("CollisionSystem::update/" + std::to_string(entities), [entities](our::bench::Runner& runner){
+                our::World world;
+                for(int index = 0; index < entities; ++index){
+                    our::Entity* entity = world.add();
+                    // The player is at the origin and the obstacles are far from it and from each other, so nothing collides
+                    // (a collision would change the state of the application, which doesn't exist here)
+                    entity->name = index == 0 ? "meshmesh" : "obstacle";
+                    entity->localTransform.position = {(float)(index % 20) * 10.0f, 0.0f, (float)(index / 20 + 1) * -10.0f};
+                    entity->addComponent<our::CollisionComponent>();
+                }
+                our::CollisionSystem collisionSystem;
+                collisionSystem.enter(nullptr);
+                runner.measure([&](){ collisionSystem.update(&world); });
+            });
+        }
+    }
+
+    void benchmarkRenderer(our::bench::Runner& runner){
+        for(int entities : {1000, 10000, 100000}){
+            auto prepare = [entities](our::World& world, our::ForwardRenderer& renderer){
+                our::SceneGenerator generator = makeGenerator(entities, 1, 0.1f);
+                our::deserializeAllAssets(generator.getAssets());
+                generator.populate(&world);
+                renderer.initialize({1280, 720}, nlohmann::json::object());
+            };
+            auto cleanup = [](our::World& world, our::ForwardRenderer& renderer){
+                renderer.destroy();
+                world.clear();
+                our::clearAllAssets();
+            };
+            // Building the packet goes through the entities, culls them, then builds & sorts the render commands
+            runner.run("ForwardRenderer::buildPacket/" + std::to_string(entities), [&](our::bench::Runner& runner){
+                our::World world;
+                our::ForwardRenderer renderer;
+                our::FramePacket packet;
+                prepare(world, renderer);
+                runner.measure([&](){ renderer.buildPacket(&world, packet); });
+                cleanup(world, renderer);
+            });
+            // Submitting the packet sets the state & the uniforms and issues the draw calls (to the stubs)
+            runner.run("ForwardRenderer::submit/" + std::to_string(entities), [&](our::bench::Runner& runner){
+                our::World world;
+                our::ForwardRenderer renderer;
+                our::FramePacket packet;
+                prepare(world, renderer);
+                renderer.buildPacket(&world, packet);
+                runner.measure([&](){ renderer.submit(packet); });
+                cleanup(world, renderer);
+            });
+        }
+    }
+
+}
+
+int main(int argc, char** argv) {
+
+    flags::args args(argc, argv); // Parse the command line arguments
+    // filter only runs the benchmarks whose name contains the given text (e.g. --filter=ForwardRenderer)
+    std::string filter = args.get<std::string>("filter", "");
+    // min-time is how long (in milliseconds) each benchmark runs at least. Longer runs give steadier results.
+    int min_time = args.get<int>("min-time", 500);
+    // json is the path of a report of all the results (to compare two builds)
+    std::string json_path = args.get<std::string>("json", "");
+
+    our::NullContext context;
+    if(!context.create({1280, 720})) return -1;
+    our::GLStateCache::current().invalidate();
+
+    our::bench::Runner runner(std::chrono::milliseconds(min_time), filter);
+    benchmarkTransforms(runner);
+    benchmarkComponents(runner);
+    benchmarkDeserialization(runner);
+    benchmarkSystems(runner);
+    benchmarkRenderer(runner);
+
+    context.destroy(false);
+
+    if(!json_path.empty()){
+        std::ofstream out(json_path);
+        if(!out){
+            std::cerr << "Couldn't open file: " << json_path << std::endl;
+            return -1;
+        }
+        out << runner.serialize().dump(4) << std::endl;
+    }
+    return 0;
+}
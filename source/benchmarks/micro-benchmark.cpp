@@ -0,0 +1,135 @@
+#include "micro-benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+    // Counted by the replacements of the global "operator new" below. The thread pool allocates too, so they are atomic.
+    std::atomic<std::uint64_t> allocationCount{0};
+    std::atomic<std::uint64_t> allocatedBytes{0};
+
+    void* allocate(std::size_t size){
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        if(void* pointer = std::malloc(size ? size : 1)) return pointer;
+        throw std::bad_alloc();
+    }
+}
+
+// Replacing the global allocation functions in the executable replaces them for the engine library too.
+// The nothrow versions call these by default, while the over-aligned versions are not counted (the engine doesn't use them).
+void* operator new(std::size_t size){ return allocate(size); }
+void* operator new[](std::size_t size){ return allocate(size); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+namespace our::bench {
+
+    std::uint64_t getAllocationCount(){ return allocationCount.load(std::memory_order_relaxed); }
+    std::uint64_t getAllocatedBytes(){ return allocatedBytes.load(std::memory_order_relaxed); }
+
+    // The pointer escapes to a volatile variable in another translation unit, which the compiler can't see through
+    static const void* volatile sink;
+    void consume(const void* value){ sink = value; }
+
+    void Runner::record(std::vector<double>& samples, std::uint64_t operations, std::uint64_t allocations, std::uint64_t bytes){
+        std::sort(samples.begin(), samples.end());
+        Result result;
+        result.name = current;
+        result.operations = operations;
+        result.nanoseconds = samples[samples.size() / 2];
+        result.allocations = (double)allocations / operations;
+        result.bytes = (double)bytes / operations;
+        results.push_back(result);
+        measured = true;
+    }
+
+    void Runner::measure(const std::function<void()>& operation){
+        using clock = std::chrono::steady_clock;
+        // The first call warms the caches up (and does the lazy initializations, if any), so it isn't counted
+        operation();
+
+        // Double the batch till it is long enough
+        std::uint64_t batch = 1;
+        auto target = minTime / 10;
+        while(true){
+            auto start = clock::now();
+            for(std::uint64_t index = 0; index < batch; ++index) operation();
+            if(clock::now() - start >= target || batch >= (1ull << 40)) break;
+            batch *= 2;
+        }
+
+        std::vector<double> samples;
+        std::uint64_t operations = 0;
+        std::uint64_t allocations = getAllocationCount(), bytes = getAllocatedBytes();
+        std::chrono::nanoseconds total{0};
+        while(total < minTime || samples.size() < 5){
+            auto start = clock::now();
+            for(std::uint64_t index = 0; index < batch; ++index) operation();
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            samples.push_back((double)elapsed.count() / batch);
+            operations += batch;
+            total += elapsed;
+        }
+        record(samples, operations, getAllocationCount() - allocations, getAllocatedBytes() - bytes);
+    }
+
+    void Runner::measureEach(const std::function<void()>& prepare, const std::function<void()>& operation){
+        using clock = std::chrono::steady_clock;
+        prepare();
+        operation();
+
+        std::vector<double> samples;
+        std::uint64_t allocations = 0, bytes = 0;
+        std::chrono::nanoseconds total{0};
+        while(total < minTime || samples.size() < 5){
+            prepare();
+            std::uint64_t allocationsBefore = getAllocationCount(), bytesBefore = getAllocatedBytes();
+            auto start = clock::now();
+            operation();
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            allocations += getAllocationCount() - allocationsBefore;
+            bytes += getAllocatedBytes() - bytesBefore;
+            samples.push_back((double)elapsed.count());
+            total += elapsed;
+        }
+        record(samples, samples.size(), allocations, bytes);
+    }
+
+    void Runner::run(const std::string& name, const std::function<void(Runner&)>& benchmark){
+        if(name.find(filter) == std::string::npos) return;
+        current = name;
+        measured = false;
+        benchmark(*this);
+        if(!measured){
+            std::cerr << "ERROR: The benchmark \"" << name << "\" didn't measure anything" << std::endl;
+            return;
+        }
+        const Result& result = results.back();
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-48s %14.1f ns/op %10.2f allocs/op %12.1f B/op %12llu ops",
+                      result.name.c_str(), result.nanoseconds, result.allocations, result.bytes, (unsigned long long)result.operations);
+        std::cout << line << std::endl;
+    }
+
+    nlohmann::json Runner::serialize() const {
+        nlohmann::json data = nlohmann::json::array();
+        for(auto& result : results){
+            data.push_back({
+                {"name", result.name},
+                {"operations", result.operations},
+                {"nsPerOp", result.nanoseconds},
+                {"allocsPerOp", result.allocations},
+                {"bytesPerOp", result.bytes},
+            });
+        }
+        return data;
+    }
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <json/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace our::bench {
+
+    // The heap allocations made by the whole process so far (every "operator new" is counted, see "micro-benchmark.cpp")
+    std::uint64_t getAllocationCount();
+    std::uint64_t getAllocatedBytes();
+
+    // Makes the compiler believe that the pointed value is read, so the computation of an unused result isn't optimized away
+    void consume(const void* value);
+
+    // The result of a benchmark. The times are the median over the samples, so a few slow samples (e.g. the OS
+    // preempting the thread) don't move them. The allocations are the average over all the operations.
+    struct Result {
+        std::string name;
+        std::uint64_t operations = 0;
+        double nanoseconds = 0;     // per operation
+        double allocations = 0;     // per operation
+        double bytes = 0;           // allocated per operation
+    };
+
+    // Runs the operation of a benchmark. A benchmark does its setup (which isn't measured), then calls one of the
+    // "measure" functions with the operation to time.
+    class Runner {
+        std::chrono::nanoseconds minTime;
+        std::string filter;
+        std::vector<Result> results;
+        std::string current;
+        bool measured = false;
+
+        void record(std::vector<double>& samples, std::uint64_t operations, std::uint64_t allocations, std::uint64_t bytes);
+
+    public:
+        // Only the benchmarks whose name contains the filter are run (all of them if it is empty)
+        Runner(std::chrono::nanoseconds minTime, std::string filter) : minTime(minTime), filter(std::move(filter)) {}
+
+        // For fast operations: the operation is called in batches that are long enough for the clock to be precise.
+        // The batch size is picked so that a batch lasts about a tenth of the minimum time, then batches are run till
+        // the minimum time is over. The operation must leave everything as it found it (or at least not slow down).
+        void measure(const std::function<void()>& operation);
+        // For slow operations that need to be prepared every time (e.g. deserializing into an empty world): the preparation
+        // is called before every call of the operation but only the operation itself is timed.
+        void measureEach(const std::function<void()>& prepare, const std::function<void()>& operation);
+
+        // Runs a benchmark (if it passes the filter) and prints its result. A benchmark that measures nothing is reported as an error.
+        void run(const std::string& name, const std::function<void(Runner&)>& benchmark);
+
+        const std::vector<Result>& getResults() const { return results; }
+        nlohmann::json serialize() const;
+    };
+
+}
@@ -9,6 +9,8 @@
 #include <queue>
 #include <tuple>
 #include <filesystem>
+#include <chrono>
+#include <algorithm>
 #include <flags/flags.h>
 
 // Include the Dear ImGui implementation headers
@@ -22,6 +24,11 @@
 #endif
 
 #include "texture/screenshot.hpp"
+#include "texture/image-compare.hpp"
+#include "asset-loader.hpp"
+#include "gl/state-cache.hpp"
+#include "shader/program-binary-cache.hpp"
+#include "profiling/cpu-profiler.hpp"
 
 std::string default_screenshot_filepath()
 {
@@ -29,7 +36,12 @@ std::string default_screenshot_filepath()
     auto time = std::time(nullptr);
 
     struct tm localtime;
+    // localtime_s is the Windows version, localtime_r is the POSIX one (both are the thread safe versions of localtime)
+#if defined(_WIN32)
     localtime_s(&localtime, &time);
+#else
+    localtime_r(&time, &localtime);
+#endif
     stream << "screenshots/screenshot-" << std::put_time(&localtime, "%Y-%m-%d-%H-%M-%S") << ".png";
     return stream.str();
 }
@@ -173,40 +185,56 @@ our::WindowConfiguration our::Application::getWindowConfiguration()
     return {title, {width, height}, isFullScreen};
 }
 
-// This is the main class function that run the whole application (Initialize, Game loop, House cleaning).
-// run_for_frames decides how many frames should be run before the application automatically closes.
-// if run_for_frames == 0, the application runs indefinitely till manually closed.
-int our::Application::run(int run_for_frames)
+// Creates the OpenGL context (with a window unless it runs headless or with the null backend) and loads the OpenGL functions
+bool our::Application::createContext(const WindowConfiguration &win_config)
 {
-
-    // Set the function to call when an error occurs.
-    glfwSetErrorCallback(glfw_error_callback);
-
-    // Initialize GLFW and exit if it failed
-    if (!glfwInit())
+    if (glBackend == GLBackend::Null)
     {
-        std::cerr << "Failed to Initialize GLFW" << std::endl;
-        return -1;
+        // The null backend doesn't talk to any driver, so it needs neither a window nor a display
+        if (!nullContext.create(win_config.size))
+            return false;
+    }
+    else if (headless)
+    {
+        // Without a display, GLFW can't be initialized. The context is created with EGL and the frames are rendered
+        // into an offscreen framebuffer of the window's size.
+        if (!headlessContext.create(win_config.size))
+            return false;
     }
+    else
+    {
+        // Set the function to call when an error occurs.
+        glfwSetErrorCallback(glfw_error_callback);
 
-    configureOpenGL(); // This function sets OpenGL window hints.
+        // Initialize GLFW and exit if it failed
+        if (!glfwInit())
+        {
+            std::cerr << "Failed to Initialize GLFW" << std::endl;
+            return false;
+        }
 
-    auto win_config = getWindowConfiguration(); // Returns the WindowConfiguration current struct instance.
+        configureOpenGL(); // This function sets OpenGL window hints.
 
-    // Create a window with the given "WindowConfiguration" attributes.
-    // If it should be fullscreen, monitor should point to one of the monitors (e.g. primary monitor), otherwise it should be null
-    GLFWmonitor *monitor = win_config.isFullscreen ? glfwGetPrimaryMonitor() : nullptr;
-    // The last parameter "share" can be used to share the resources (OpenGL objects) between multiple windows.
-    window = glfwCreateWindow(win_config.size.x, win_config.size.y, win_config.title.c_str(), monitor, nullptr);
-    if (!window)
-    {
-        std::cerr << "Failed to Create Window" << std::endl;
-        glfwTerminate();
-        return -1;
+        // Create a window with the given "WindowConfiguration" attributes.
+        // If it should be fullscreen, monitor should point to one of the monitors (e.g. primary monitor), otherwise it should be null
+        GLFWmonitor *monitor = win_config.isFullscreen ? glfwGetPrimaryMonitor() : nullptr;
+        // The last parameter "share" can be used to share the resources (OpenGL objects) between multiple windows.
+        window = glfwCreateWindow(win_config.size.x, win_config.size.y, win_config.title.c_str(), monitor, nullptr);
+        if (!window)
+        {
+            std::cerr << "Failed to Create Window" << std::endl;
+            glfwTerminate();
+            return false;
+        }
+        glfwMakeContextCurrent(window); // Tell GLFW to make the context of our window the main context on the current thread.
+
+        gladLoadGL(glfwGetProcAddress); // Load the OpenGL functions from the driver
     }
-    glfwMakeContextCurrent(window); // Tell GLFW to make the context of our window the main context on the current thread.
 
-    gladLoadGL(glfwGetProcAddress); // Load the OpenGL functions from the driver
+    // The context is brand new, so we shouldn't trust anything the state cache knows
+    GLStateCache::current().invalidate();
+    // In headless mode, the offscreen framebuffer is bound for both drawing and reading (as the window's framebuffer would be)
+    GLStateCache::current().bindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // Print information about the OpenGL context
     std::cout << "VENDOR          : " << glGetString(GL_VENDOR) << std::endl;
@@ -214,6 +242,18 @@ int our::Application::run(int run_for_frames)
     std::cout << "VERSION         : " << glGetString(GL_VERSION) << std::endl;
     std::cout << "GLSL VERSION    : " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
 
+    // The shader programs can be loaded from the program binary cache (enabled by "shaderCache" in the config or from the
+    // command line). It must be set up before any shader is created since it decides when the shaders are compiled.
+    ProgramBinaryCache &programCache = ProgramBinaryCache::shared();
+    if (app_config.contains("shaderCache"))
+        programCache.deserialize(app_config["shaderCache"]);
+    if (!shaderCacheDirectory.empty())
+    {
+        programCache.settings.enabled = true;
+        programCache.settings.directory = shaderCacheDirectory;
+    }
+    programCache.initialize();
+
 #if defined(ENABLE_OPENGL_DEBUG_MESSAGES)
     // if we have OpenGL debug messages enabled, set the message callback
     glDebugMessageCallback(opengl_callback, nullptr);
@@ -224,20 +264,288 @@ int our::Application::run(int run_for_frames)
     // as the command causing it is called. This is useful for debugging but slows down the code execution.
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 #endif
+    return true;
+}
+
+// Changes the size of the window (or of the framebuffer that takes its place). Returns false if it didn't get the requested size.
+bool our::Application::resizeSurface(glm::ivec2 size)
+{
+    if (glBackend == GLBackend::Null)
+    {
+        nullContext.resize(size);
+        return true;
+    }
+    if (headless)
+        return headlessContext.resize(size);
+    if (getWindowSize() == size)
+        return true;
+    // The window system may apply the new size a bit later, so we wait for it (for a second at most)
+    glfwSetWindowSize(window, size.x, size.y);
+    for (int attempt = 0; attempt < 100 && getWindowSize() != size; ++attempt)
+        glfwWaitEventsTimeout(0.01);
+    return getWindowSize() == size;
+}
+
+// Destroys the context (and the window, if any)
+void our::Application::destroyContext()
+{
+    screenshotCapture.destroy();
+    ProgramBinaryCache::shared().shutdown();
+    if (glBackend == GLBackend::Null)
+    {
+        // This prints what the null backend counted
+        nullContext.destroy();
+        return;
+    }
+    if (headless)
+    {
+        headlessContext.destroy();
+        return;
+    }
+
+    // Destroy the window
+    glfwDestroyWindow(window);
+    window = nullptr;
+
+    // And finally terminate GLFW
+    glfwTerminate();
+}
 
-    setupCallbacks();
+// Sets up the input and ImGui (this must be called after the context is created)
+void our::Application::initializeFrontend()
+{
+    if (window)
+        setupCallbacks();
     keyboard.enable(window);
     mouse.enable(window);
 
     // Start the ImGui context and set dark style (just my preference :D)
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
-    ImGuiIO &io = ImGui::GetIO();
     ImGui::StyleColorsDark();
 
-    // Initialize ImGui for GLFW and OpenGL
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    // Initialize ImGui for GLFW and OpenGL (without a window, there is no platform backend and we feed ImGui the display size ourselves)
+    if (window)
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330 core");
+}
+
+// Shuts ImGui down (this must be called before the context is destroyed)
+void our::Application::destroyFrontend()
+{
+    ImGui_ImplOpenGL3_Shutdown();
+    if (window)
+        ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+}
+
+// This is the main class function that run the whole application (Initialize, Game loop, House cleaning).
+// run_for_frames decides how many frames should be run before the application automatically closes.
+// if run_for_frames == 0, the application runs indefinitely till manually closed.
+int our::Application::run(int run_for_frames)
+{
+    auto win_config = getWindowConfiguration(); // Returns the WindowConfiguration current struct instance.
+    // The benchmark reports how long it took to reach the first frame
+    auto run_start_time = std::chrono::steady_clock::now();
+
+    if (!createContext(win_config))
+        return -1;
+
+    if (benchmarking)
+    {
+        if (app_config.contains("benchmark"))
+            benchmark.deserialize(app_config["benchmark"]);
+        if (!benchmarkReport.empty())
+            benchmark.settings.reportPath = benchmarkReport;
+        // The benchmark decides how many frames to run and the frames shouldn't wait for the vertical sync
+        run_for_frames = benchmark.getTotalFrames();
+        if (window)
+            glfwSwapInterval(0);
+    }
+
+    if (recordingRequested)
+    {
+        if (app_config.contains("recording"))
+            frameRecorder.deserialize(app_config["recording"]);
+        if (!recordingOutput.empty())
+            frameRecorder.settings.output = recordingOutput;
+        if (!frameRecorder.start(getFrameBufferSize()))
+        {
+            destroyContext();
+            return -1;
+        }
+        // With a fixed time step, the recording doesn't follow the real time so there is no reason to wait for the vertical sync
+        if (window && frameRecorder.settings.timeStep > 0)
+            glfwSwapInterval(0);
+    }
+
+    initializeFrontend();
+
+    runFrames(run_for_frames, run_start_time);
+
+    // The frames that are still being read back or encoded are written before the context is destroyed
+    frameRecorder.stop();
+
+    // Shutdown ImGui & destroy the context
+    destroyFrontend();
+    destroyContext();
+    return 0; // Good bye
+}
+
+// Runs every config of the batch in turn for a fixed number of frames, then compares the screenshots they requested to the expected ones.
+// Unlike running the application once per config, the context (and ImGui) is created once and reused, so a config only costs its
+// own loading and frames. Between two configs, the assets are cleared, the states are created again and the OpenGL state is put
+// back to the defaults of a new context so that every config starts as if it was run alone.
+// Returns the number of screenshots that didn't match (0 on success).
+int our::Application::runBatch(const nlohmann::json &batch_config, const std::vector<std::string> &groups)
+{
+    auto batch_start_time = std::chrono::steady_clock::now();
+    std::filesystem::path expected_directory = batch_config.value("expected", "expected");
+    std::filesystem::path errors_directory = batch_config.value("errors", "errors");
+    int frames = batch_config.value("frames", 2);
+
+    // All the configs are read first, so that the context can be created with the window size of the first one
+    // A config that can't be read is kept (with a null config) to be reported as a failure of its group
+    struct BatchRun
+    {
+        std::string group, path;
+        nlohmann::json config;
+        float tolerance;
+        int threshold;
+    };
+    std::vector<BatchRun> runs;
+    for (auto &group : batch_config.value("groups", nlohmann::json::array()))
+    {
+        std::string name = group.value("name", "");
+        if (!groups.empty() && std::find(groups.begin(), groups.end(), name) == groups.end())
+            continue;
+        for (auto &path : group.value("configs", nlohmann::json::array()))
+        {
+            BatchRun batch_run{name, path.get<std::string>(), nullptr, group.value("tolerance", 0.0f), group.value("threshold", 0)};
+            if (std::ifstream file_in(batch_run.path); file_in)
+                batch_run.config = nlohmann::json::parse(file_in, nullptr, true, true);
+            else
+                std::cerr << "Couldn't open file: " << batch_run.path << std::endl;
+            runs.push_back(std::move(batch_run));
+        }
+    }
+    auto first_run = std::find_if(runs.begin(), runs.end(), [](const BatchRun &batch_run)
+                                  { return batch_run.config.is_object(); });
+    if (first_run == runs.end())
+    {
+        std::cerr << "The batch has no config to run" << std::endl;
+        return -1;
+    }
+
+    // The batch runs tests (not benchmarks), so the frames get the real time steps as they would when running alone
+    benchmarking = false;
+    app_config = first_run->config;
+    if (!createContext(getWindowConfiguration()))
+        return -1;
+    initializeFrontend();
+    // The screenshots are kept as soon as they are read back (they are written to their files in the background meanwhile)
+    screenshotCapture.setReadCallback([this](const std::string &path, const our::Image &image)
+                                      { capturedScreenshots.push_back({path, image}); });
+
+    // The matches & the outputs of each group in the order of the batch
+    std::vector<std::tuple<std::string, int, int>> results;
+    for (auto &batch_run : runs)
+    {
+        if (results.empty() || std::get<0>(results.back()) != batch_run.group)
+        {
+            results.push_back({batch_run.group, 0, 0});
+            std::cout << std::endl
+                      << "Running " << batch_run.group << ":" << std::endl;
+        }
+        auto &[group, matches, total] = results.back();
+        if (!batch_run.config.is_object())
+        {
+            ++total;
+            continue;
+        }
+
+        app_config = batch_run.config;
+        auto win_config = getWindowConfiguration();
+        if (!resizeSurface(win_config.size))
+        {
+            std::cerr << "Failed to resize the window to " << win_config.size.x << "x" << win_config.size.y << " for: " << batch_run.path << std::endl;
+            ++total;
+            continue;
+        }
+        if (window)
+            glfwSetWindowTitle(window, win_config.title.c_str());
+
+        // Every config starts from the state of a new context with a cleared framebuffer
+        GLStateCache::current().restoreDefaults();
+        GLStateCache::current().bindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, win_config.size.x, win_config.size.y);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        closeRequested = false;
+        if (window)
+            glfwSetWindowShouldClose(window, GLFW_FALSE);
+
+        resetStates();
+        if (app_config.contains("start-scene"))
+            changeState(app_config["start-scene"].get<std::string>());
+        capturedScreenshots.clear();
+        runFrames(frames, std::chrono::steady_clock::now());
+        currentState = nextState = nullptr;
+        // Most states clear their assets when they are destroyed, but not all of them do (e.g. the ones that load none)
+        clearAllAssets();
+
+        for (auto &[path, image] : capturedScreenshots)
+        {
+            ++total;
+            auto file = std::filesystem::path(path).filename();
+            our::Image expected;
+            if (!our::load_image((expected_directory / group / file).string(), expected))
+                continue;
+            auto comparison = our::compare_images(expected, image, batch_run.tolerance);
+            if (our::images_match(comparison, batch_run.threshold))
+            {
+                ++matches;
+                continue;
+            }
+            if (!comparison.sizeMatches)
+            {
+                std::cout << "MISMATCH: " << path << " is " << image.size.x << "x" << image.size.y << " instead of "
+                          << expected.size.x << "x" << expected.size.y << std::endl;
+                continue;
+            }
+            std::cout << "MISMATCH: " << path << " has " << comparison.differentPixels << " different pixels (at most "
+                      << batch_run.threshold << " are allowed)" << std::endl;
+            auto error_path = (errors_directory / group / file).string();
+            if (!our::write_png(error_path, comparison.errors))
+                std::cerr << "Failed to save the error image to: " << error_path << std::endl;
+        }
+    }
+    screenshotCapture.setReadCallback(nullptr);
+    capturedScreenshots.clear();
+
+    destroyFrontend();
+    destroyContext();
+
+    int failures = 0;
+    std::cout << std::endl;
+    for (auto &[group, matches, total] : results)
+    {
+        std::cout << group << ": Matches: " << matches << "/" << total << std::endl;
+        failures += total - matches;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start_time).count();
+    if (failures == 0)
+        std::cout << "SUCCESS: All outputs are correct";
+    else
+        std::cout << "FAILURE: " << failures << (failures == 1 ? " output is" : " outputs are") << " incorrect";
+    std::cout << " (" << runs.size() << " configs in " << std::fixed << std::setprecision(2) << seconds << " seconds)" << std::endl;
+    return failures;
+}
+
+// Runs the current state (or the one that was requested) for the given number of frames (0 means till the application is closed)
+// then destroys it. The context and ImGui must be ready. "run_start_time" is when the run started (for the benchmark).
+void our::Application::runFrames(int run_for_frames, std::chrono::steady_clock::time_point run_start_time)
+{
+    ImGuiIO &io = ImGui::GetIO();
 
     // This part of the code extracts the list of requested screenshots and puts them into a priority queue
     using ScreenshotRequest = std::pair<int, std::string>;
@@ -260,6 +568,12 @@ int our::Application::run(int run_for_frames)
         }
     }
 
+    // If a trace was requested, start recording the profiler zones (the startup is recorded as part of frame 0)
+    our::profiler::setThreadName("main");
+    our::profiler::setFrame(0);
+    if (!tracePath.empty())
+        our::profiler::setEnabled(true);
+
     // If a scene change was requested, apply it
     if (nextState)
     {
@@ -268,26 +582,62 @@ int our::Application::run(int run_for_frames)
     }
     // Call onInitialize if the scene needs to do some custom initialization (such as file loading, object creation, etc).
     if (currentState)
+    {
+        PROFILE_ZONE("State::onInitialize");
         currentState->onInitialize();
+    }
+
+    // GLFW's timer needs GLFW to be initialized, so the headless mode uses the standard clock
+    auto start_time = std::chrono::steady_clock::now();
+    auto get_time = [this, start_time]()
+    {
+        if (window)
+            return glfwGetTime();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    };
 
     // The time at which the last frame started. But there was no frames yet, so we'll just pick the current time.
-    double last_frame_time = glfwGetTime();
+    double last_frame_time = get_time();
     int current_frame = 0;
 
     // Game loop
-    while (!glfwWindowShouldClose(window))
+    while (!shouldClose())
     {
         if (run_for_frames != 0 && current_frame >= run_for_frames)
             break;
-        glfwPollEvents(); // Read all the user events and call relevant callbacks.
+        auto frame_start_time = std::chrono::steady_clock::now();
+        if (benchmarking && current_frame == 0)
+            benchmark.setStartupTime(std::chrono::duration<double, std::milli>(frame_start_time - run_start_time).count());
+        // Once the requested range of frames is over, write the trace
+        if (!tracePath.empty() && current_frame > traceLastFrame)
+            writeTrace();
+        our::profiler::setFrame(current_frame);
+        PROFILE_ZONE("Frame");
 
-        // Start a new ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        {
+            PROFILE_ZONE("PollEvents");
+            if (window)
+                glfwPollEvents(); // Read all the user events and call relevant callbacks.
+        }
 
-        if (currentState)
-            currentState->onImmediateGui(); // Call to run any required Immediate GUI.
+        {
+            PROFILE_ZONE("ImGui");
+            // Start a new ImGui frame
+            ImGui_ImplOpenGL3_NewFrame();
+            if (window)
+            {
+                ImGui_ImplGlfw_NewFrame();
+            }
+            else
+            {
+                io.DisplaySize = ImVec2((float)getOffscreenSize().x, (float)getOffscreenSize().y);
+                io.DeltaTime = (float)glm::max(get_time() - last_frame_time, 1e-6);
+            }
+            ImGui::NewFrame();
+
+            if (currentState)
+                currentState->onImmediateGui(); // Call to run any required Immediate GUI.
+        }
 
         // If ImGui is using the mouse or keyboard, then we don't want the captured events to affect our keyboard and mouse objects.
         // For example, if you're focusing on an input and writing "W", the keyboard object shouldn't record this event.
@@ -303,11 +653,21 @@ int our::Application::run(int run_for_frames)
         glViewport(0, 0, frame_buffer_size.x, frame_buffer_size.y);
 
         // Get the current time (the time at which we are starting the current frame).
-        double current_frame_time = glfwGetTime();
+        double current_frame_time = get_time();
+
+        // In benchmark mode, the states get a fixed time step (if the benchmark has one) so that every run simulates the same frames
+        double delta_time = current_frame_time - last_frame_time;
+        if (benchmarking)
+            delta_time = benchmark.beginFrame(delta_time);
+        else if (frameRecorder.isRecording() && frameRecorder.settings.timeStep > 0)
+            delta_time = frameRecorder.settings.timeStep;
 
         // Call onDraw, in which we will draw the current frame, and send to it the time difference between the last and current frame
         if (currentState)
-            currentState->onDraw(current_frame_time - last_frame_time);
+        {
+            PROFILE_ZONE("State::onDraw");
+            currentState->onDraw(delta_time);
+        }
         last_frame_time = current_frame_time; // Then update the last frame start time (this frame is now the last frame)
 
 #if defined(ENABLE_OPENGL_DEBUG_MESSAGES)
@@ -316,44 +676,40 @@ int our::Application::run(int run_for_frames)
         glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 #endif
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Render the ImGui to the framebuffer
+        // ImGui changes the OpenGL state without going through the state cache, so the cache must forget what it knows
+        GLStateCache::current().invalidate();
 #if defined(ENABLE_OPENGL_DEBUG_MESSAGES)
         // Re-enable the debug messages
         glEnable(GL_DEBUG_OUTPUT);
         glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 #endif
 
+        // The screenshots read the default framebuffer (the offscreen one in headless mode)
+        GLStateCache::current().bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
         // If F12 is pressed, take a screenshot
+        // The screenshots are captured asynchronously: the pixels are read back and written to the file a few frames later
         if (keyboard.justPressed(GLFW_KEY_F12))
         {
             glViewport(0, 0, frame_buffer_size.x, frame_buffer_size.y);
-            std::string path = default_screenshot_filepath();
-            if (our::screenshot_png(path))
-            {
-                std::cout << "Screenshot saved to: " << path << std::endl;
-            }
-            else
-            {
-                std::cerr << "Failed to save a Screenshot" << std::endl;
-            }
+            screenshotCapture.capture(default_screenshot_filepath());
         }
         // There are any requested screenshots, take them
         while (requested_screenshots.size())
         {
             if (const auto &request = requested_screenshots.top(); request.first == current_frame)
             {
-                if (our::screenshot_png(request.second))
-                {
-                    std::cout << "Screenshot saved to: " << request.second << std::endl;
-                }
-                else
-                {
-                    std::cerr << "Failed to save a screenshot to: " << request.second << std::endl;
-                }
+                screenshotCapture.capture(request.second);
                 requested_screenshots.pop();
             }
             else
                 break;
         }
+        // Hand the screenshots the GPU finished reading over to the encoder
+        screenshotCapture.update();
+        // The recorded frames go through the same steps (but the recorder waits if it falls too far behind)
+        frameRecorder.captureFrame(current_frame);
+        frameRecorder.update();
 
         // GLuint id = 9202618;
 
@@ -364,8 +720,18 @@ int our::Application::run(int run_for_frames)
         // 1.0);
         // glClear(GL_COLOR_BUFFER_BIT); // on back buffer
 
+        // The CPU time of the frame is everything before the swap (which may wait for the GPU)
+        auto cpu_end_time = std::chrono::steady_clock::now();
+
         // Swap the frame buffers
-        glfwSwapBuffers(window);
+        {
+            PROFILE_ZONE("SwapBuffers");
+            // Without a window, there is nothing to present, but we still make sure the commands of the frame are sent to the GPU
+            if (window)
+                glfwSwapBuffers(window);
+            else
+                glFlush();
+        }
 
         // Update the keyboard and mouse data
         keyboard.update();
@@ -381,27 +747,71 @@ int our::Application::run(int run_for_frames)
             currentState = nextState;
             nextState = nullptr;
             // Initialize the new scene
+            PROFILE_ZONE("State::onInitialize");
             currentState->onInitialize();
         }
 
+        if (benchmarking)
+        {
+            auto frame_end_time = std::chrono::steady_clock::now();
+            benchmark.endFrame(std::chrono::duration<float, std::milli>(cpu_end_time - frame_start_time).count(),
+                               std::chrono::duration<float, std::milli>(frame_end_time - frame_start_time).count());
+        }
+
         ++current_frame;
     }
 
+    // The report is written while the context is alive since it describes the renderer
+    if (benchmarking)
+        writeBenchmarkReport();
+
+    // If the application closed before the end of the traced range, write what we have
+    if (!tracePath.empty())
+        writeTrace();
+
     // Call for cleaning up
     if (currentState)
         currentState->onDestroy();
 
-    // Shutdown ImGui & destroy the context
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    // The screenshots of the last frames may still be in flight
+    screenshotCapture.flush();
+}
 
-    // Destroy the window
-    glfwDestroyWindow(window);
+// Returns whether the window was asked to close (or the application in headless mode)
+bool our::Application::shouldClose()
+{
+    return window ? glfwWindowShouldClose(window) : closeRequested;
+}
 
-    // And finally terminate GLFW
-    glfwTerminate();
-    return 0; // Good bye
+// Writes the benchmark report with a description of the run
+void our::Application::writeBenchmarkReport()
+{
+    nlohmann::json environment;
+    // The name of the state that was benchmarked
+    for (auto &[name, state] : states)
+        if (state == currentState)
+            environment["scene"] = name;
+    environment["backend"] = glBackend == GLBackend::Null ? "null" : "driver";
+    environment["windowed"] = window != nullptr;
+    auto size = getFrameBufferSize();
+    environment["resolution"] = {size.x, size.y};
+    environment["renderer"] = (const char *)glGetString(GL_RENDERER);
+    environment["version"] = (const char *)glGetString(GL_VERSION);
+    if (benchmark.writeReport(environment))
+        std::cout << "Benchmark report saved to: " << benchmark.settings.reportPath << std::endl;
+    else
+        std::cerr << "Failed to save the benchmark report to: " << benchmark.settings.reportPath << std::endl;
+}
+
+// Writes the requested trace and stops recording
+void our::Application::writeTrace()
+{
+    if (our::profiler::writeChromeTrace(tracePath, traceFirstFrame, traceLastFrame))
+        std::cout << "Trace saved to: " << tracePath << std::endl;
+    else
+        std::cerr << "Failed to save the trace to: " << tracePath << std::endl;
+    tracePath.clear();
+    our::profiler::setEnabled(false);
 }
 
 // Sets-up the window callback functions from GLFW to our (Mouse/Keyboard) classes.
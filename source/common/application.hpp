@@ -5,13 +5,21 @@
 #include <GLFW/glfw3.h>
 #include <imgui.h>
 
+#include <chrono>
+#include <functional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <type_traits>
 #include <json/json.hpp>
 
 #include "input/keyboard.hpp"
 #include "input/mouse.hpp"
+#include "gl/headless-context.hpp"
+#include "gl/null-context.hpp"
+#include "profiling/benchmark.hpp"
+#include "texture/screenshot-capture.hpp"
+#include "texture/frame-recorder.hpp"
 
 namespace our {
 
@@ -22,6 +30,12 @@ namespace our {
         bool isFullscreen;
     };
 
+    // Where the OpenGL calls go: the driver (through a window or a headless context) or the null backend (nothing is rendered)
+    enum class GLBackend {
+        Driver,
+        Null
+    };
+
     class Application; // Forward declaration
 
     // This is the base class for all states
@@ -31,6 +45,7 @@ namespace our {
         Application* application;
         friend Application;
     public:
+        virtual ~State() = default;                     // The states are deleted through this class (e.g. by "resetStates").
         virtual void onInitialize(){}                   // Called once before the game loop.
         virtual void onImmediateGui(){}                 // Called every frame to draw the Immediate GUI (if any).
         virtual void onDraw(double deltaTime){}         // Called every frame in the game loop passing the time taken to draw the frame "Delta time".
@@ -60,9 +75,53 @@ namespace our {
         nlohmann::json app_config;           // A Json file that contains all application configuration
 
         std::unordered_map<std::string, State*> states;   // This will store all the states that the application can run
+        // How to create each state again, so that a batch can start every config with fresh states (see "resetStates")
+        std::unordered_map<std::string, std::function<State*()>> stateFactories;
         State * currentState = nullptr;         // This will store the current scene that is being run
         State * nextState = nullptr;            // If it is requested to go to another scene, this will contain a pointer to that scene
 
+        // If "tracePath" is not empty, the CPU profiler zones of the frames [traceFirstFrame, traceLastFrame] are written to it as a Chrome trace
+        std::string tracePath;
+        int traceFirstFrame = 0, traceLastFrame = 0;
+        // In headless mode, there is no window: the frames are rendered into the offscreen framebuffer of "headlessContext"
+        // and there is no user input. "closeRequested" replaces the window's close flag.
+        bool headless = false;
+        HeadlessContext headlessContext;
+        bool closeRequested = false;
+        // With the null backend, the OpenGL functions are stubs that only validate & count the calls (see "NullContext").
+        // There is no window either, so it behaves like the headless mode without needing any driver.
+        GLBackend glBackend = GLBackend::Driver;
+        NullContext nullContext;
+        // In benchmark mode, the application runs a fixed number of frames (see "Benchmark") and writes a report at the end.
+        // If "benchmarkReport" is not empty, it replaces the report path of the config.
+        bool benchmarking = false;
+        Benchmark benchmark;
+        std::string benchmarkReport;
+        void writeBenchmarkReport();
+        // The size of the framebuffer that takes the place of the window's when there is no window
+        glm::ivec2 getOffscreenSize() const { return glBackend == GLBackend::Null ? nullContext.getSize() : headlessContext.getSize(); }
+        bool shouldClose();
+        void writeTrace();
+        // Reads the screenshots back & writes them without stalling the frames
+        ScreenshotCapture screenshotCapture;
+        // In recording mode, the frames are written as an image sequence or a video (see "FrameRecorder").
+        // If "recordingOutput" is not empty, it replaces the output of the config.
+        bool recordingRequested = false;
+        std::string recordingOutput;
+        FrameRecorder frameRecorder;
+        // If "shaderCacheDirectory" is not empty, the program binary cache is enabled with this directory whatever the config says
+        std::string shaderCacheDirectory;
+        // In batch mode, the requested screenshots are kept in memory (besides being written) to be compared to the expected ones
+        std::vector<std::pair<std::string, Image>> capturedScreenshots;
+
+        // The steps of "run", which "runBatch" shares
+        bool createContext(const WindowConfiguration& win_config);
+        bool resizeSurface(glm::ivec2 size);
+        void destroyContext();
+        void initializeFrontend();
+        void destroyFrontend();
+        void runFrames(int run_for_frames, std::chrono::steady_clock::time_point run_start_time);
+
         
         // Virtual functions to be overrode and change the default behaviour of the application
         // according to the example needs.
@@ -80,6 +139,48 @@ namespace our {
         // This is the main class function that run the whole application (Initialize, Game loop, House cleaning).
         int run(int run_for_frames = 0);
 
+        // Runs the configs of a batch one after the other in the same context and compares their screenshots to the expected ones.
+        // The batch is a json object: {"expected": directory, "errors": directory, "frames": count per config,
+        // "groups": [{"name", "configs": [paths], "tolerance", "threshold"}]} where the tolerance & threshold mean the same as in
+        // "compare_images". If "groups" is not empty, only the groups with these names are run.
+        // The screenshots of a group are compared to the files with the same names in "expected/<group name>" and the error
+        // images of the mismatches are written to "errors/<group name>". Returns the number of mismatches.
+        int runBatch(const nlohmann::json& batch_config, const std::vector<std::string>& groups = {});
+
+        // Requests a Chrome trace of the CPU profiler zones recorded during the given range of frames (frame 0 includes the startup)
+        // The trace is written once the last frame ends (or when the application closes before that)
+        void captureTrace(const std::string& path, int firstFrame, int lastFrame){
+            tracePath = path;
+            traceFirstFrame = firstFrame;
+            traceLastFrame = lastFrame;
+        }
+
+        // Runs the application without a window (this must be called before "run")
+        void setHeadless(bool headless){ this->headless = headless; }
+        [[nodiscard]] bool isHeadless() const { return headless; }
+
+        // Picks where the OpenGL calls go (this must be called before "run")
+        void setGLBackend(GLBackend backend){ glBackend = backend; }
+        [[nodiscard]] GLBackend getGLBackend() const { return glBackend; }
+
+        // Runs the application as a benchmark (this must be called before "run"). The settings are read from "benchmark" in the app config.
+        void enableBenchmark(const std::string& reportPath = ""){
+            benchmarking = true;
+            benchmarkReport = reportPath;
+        }
+        // Records the frames while the application runs (this must be called before "run"). The settings are read from "recording" in the app config.
+        void enableRecording(const std::string& output = ""){
+            recordingRequested = true;
+            recordingOutput = output;
+        }
+        // Keeps the linked shader programs in the given directory to skip compiling them in the next runs (see "ProgramBinaryCache").
+        // Without this, the cache is only used if "shaderCache" in the app config enables it.
+        void enableShaderCache(const std::string& directory){
+            shaderCacheDirectory = directory;
+        }
+        // Returns the benchmark if the application runs as one (the states use it to follow the camera path & record their statistics)
+        Benchmark* getBenchmark(){ return benchmarking ? &benchmark : nullptr; }
+
         // Register a state for use by the application
         // The state is uniquely identified by its name
         // If the name is already used, the old name owner is deleted and the new state takes its place
@@ -93,11 +194,24 @@ namespace our {
             State* scene = new T();
             scene->application = this;
             states[name] = scene;
+            stateFactories[name] = [](){ return new T(); };
+        }
+
+        // Deletes all the states and creates new ones, so nothing a state remembers from a run can change the next one
+        void resetStates(){
+            currentState = nextState = nullptr;
+            for(auto& [name, state] : states){
+                delete state;
+                state = stateFactories[name]();
+                state->application = this;
+            }
         }
 
         // Tells the application to change its current state
         // The change will not be applied until the current frame ends
         void changeState(std::string name){
+            // A benchmark measures a single scene, so the scene can't change once it runs (e.g. the game going to the "lost" screen)
+            if(benchmarking && currentState) return;
             auto it = states.find(name);
             if(it != states.end()){
                 nextState = it->second;
@@ -106,7 +220,8 @@ namespace our {
 
         // Closes the Application
         void close(){
-            glfwSetWindowShouldClose(window, GLFW_TRUE);
+            if(window) glfwSetWindowShouldClose(window, GLFW_TRUE);
+            else closeRequested = true;
         }
 
         // Class Getters.
@@ -121,6 +236,7 @@ namespace our {
 
         // Get the size of the frame buffer of the window in pixels.
         glm::ivec2 getFrameBufferSize() {
+            if(!window) return getOffscreenSize();
             glm::ivec2 size;
             glfwGetFramebufferSize(window, &(size.x), &(size.y));
             return size;
@@ -129,6 +245,7 @@ namespace our {
         // Get the window size. In most cases, it is equal to the frame buffer size.
         // But on some platforms, the framebuffer size may be different from the window size.
         glm::ivec2 getWindowSize() {
+            if(!window) return getOffscreenSize();
             glm::ivec2 size;
             glfwGetWindowSize(window, &(size.x), &(size.y));
             return size;
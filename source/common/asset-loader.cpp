@@ -3,12 +3,14 @@
 #include "shader/shader.hpp"
 #include "texture/texture2d.hpp"
 #include "texture/texture-utils.hpp"
+#include "texture/texture-array.hpp"
 #include "texture/sampler.hpp"
 #include "mesh/mesh.hpp"
 #include "mesh/mesh-utils.hpp"
 #include "material/material.hpp"
 #include "deserialize-utils.hpp"
 #include "components/lighting.hpp"
+#include "profiling/cpu-profiler.hpp"
 
 namespace our {
 
@@ -17,6 +19,7 @@ namespace our {
     //    { shader_name : { "vs" : "path/to/vertex-shader", "fs" : "path/to/fragment-shader" }, ... }
     template<>
     void AssetLoader<ShaderProgram>::deserialize(const nlohmann::json& data) {
+        PROFILE_ZONE("AssetLoader<ShaderProgram>::deserialize");
         if(data.is_object()){
             for(auto& [name, desc] : data.items()){
                 std::string vsPath = desc.value("vs", "");
@@ -35,6 +38,7 @@ namespace our {
     //    { texture_name : "path/to/image", ... }
     template<>
     void AssetLoader<Texture2D>::deserialize(const nlohmann::json& data) {
+        PROFILE_ZONE("AssetLoader<Texture2D>::deserialize");
         if(data.is_object()){
             for(auto& [name, desc] : data.items()){
                 std::string path = desc.get<std::string>();
@@ -43,6 +47,33 @@ namespace our {
         }
     };
 
+    // This will load the textures defined in "data" into texture arrays (grouped by size)
+    // Images that hold a single color are not uploaded, they become constant colors instead
+    // data must be in the form:
+    //    { texture_name : "path/to/image", ... }
+    template<>
+    void AssetLoader<TextureLayer>::deserialize(const nlohmann::json& data) {
+        PROFILE_ZONE("AssetLoader<TextureLayer>::deserialize");
+        if(data.is_object()){
+            std::unordered_map<std::string, std::string> files;
+            for(auto& [name, desc] : data.items()){
+                files[name] = desc.get<std::string>();
+            }
+            std::vector<TextureArray*> arrays;
+            for(auto& [name, layer] : texture_utils::loadImagesIntoArrays(files, arrays)){
+                assets[name] = layer;
+            }
+            // The arrays are owned by their own asset loader. We name them by their size and the first image they hold.
+            for(auto array : arrays){
+                std::string arrayName = std::to_string(array->getSize().x) + "x" + std::to_string(array->getSize().y);
+                for(auto& [name, layer] : assets){
+                    if(layer->array == array && layer->layer == 0) arrayName += ":" + name;
+                }
+                AssetLoader<TextureArray>::add(arrayName, array);
+            }
+        }
+    };
+
     // This will load all the samplers defined in "data"
     // data must be in the form:
     //    { sampler_name : parameters, ... }
@@ -52,6 +83,7 @@ namespace our {
     //  For "MAX_ANISOTROPY", the value must be a float with a value >= 1.0f
     template<>
     void AssetLoader<Sampler>::deserialize(const nlohmann::json& data) {
+        PROFILE_ZONE("AssetLoader<Sampler>::deserialize");
         if(data.is_object()){
             for(auto& [name, desc] : data.items()){
                 auto sampler = new Sampler();
@@ -64,12 +96,19 @@ namespace our {
     // This will load all the meshes defined in "data"
     // data must be in the form:
     //    { mesh_name : "path/to/3d-model-file", ... }
+    // or, to generate simplified levels of detail for the mesh (none are generated by default since the level of detail
+    // selection is opt-in, see "lod" in the renderer config):
+    //    { mesh_name : { "path": "path/to/3d-model-file", "lods": 4 }, ... }
     template<>
     void AssetLoader<Mesh>::deserialize(const nlohmann::json& data) {
+        PROFILE_ZONE("AssetLoader<Mesh>::deserialize");
         if(data.is_object()){
             for(auto& [name, desc] : data.items()){
-                std::string path = desc.get<std::string>();
-                assets[name] = mesh_utils::loadOBJ(path);
+                if(desc.is_object()){
+                    assets[name] = mesh_utils::loadOBJ(desc.value("path", ""), desc.value("lods", 0));
+                } else {
+                    assets[name] = mesh_utils::loadOBJ(desc.get<std::string>());
+                }
             }
         }
     };
@@ -88,6 +127,7 @@ namespace our {
     //      ... more keys/values can be added depending on the material type (e.g. "texture", "sampler", "tint")
     template<>
     void AssetLoader<Material>::deserialize(const nlohmann::json& data) {
+        PROFILE_ZONE("AssetLoader<Material>::deserialize");
         if(data.is_object()){
             for(auto& [name, desc] : data.items()){
                 std::string type = desc.value("type", "");
@@ -100,6 +140,7 @@ namespace our {
     
     template<>
     void AssetLoader<LightComponent>::deserialize(const nlohmann::json& data) {
+        PROFILE_ZONE("AssetLoader<LightComponent>::deserialize");
 
         if(data.is_object()){
 
@@ -113,12 +154,40 @@ namespace our {
         }
     };
 
+    // Lighted materials sample their maps from texture arrays while the other materials use 2D textures.
+    // So we split the textures based on which materials use them so that no texture is uploaded twice unless it is used in both ways.
+    // Textures that are not used by any material are loaded as 2D textures.
+    static void splitTexturesByUsage(const nlohmann::json& assetData, nlohmann::json& textures2D, nlohmann::json& textureLayers){
+        textures2D = nlohmann::json::object();
+        textureLayers = nlohmann::json::object();
+        std::unordered_map<std::string, bool> usedAsLayer, usedAs2D;
+        if(const auto& materials = assetData.value("materials", nlohmann::json::object()); materials.is_object()){
+            for(auto& [name, desc] : materials.items()){
+                if(desc.value("type", "") == "lighted"){
+                    for(auto map : LightMaterial::MAP_NAMES)
+                        if(desc.contains(map)) usedAsLayer[desc[map].get<std::string>()] = true;
+                } else if(desc.contains("texture")) {
+                    usedAs2D[desc["texture"].get<std::string>()] = true;
+                }
+            }
+        }
+        for(auto& [name, desc] : assetData["textures"].items()){
+            if(usedAsLayer.count(name)) textureLayers[name] = desc;
+            if(usedAs2D.count(name) || !usedAsLayer.count(name)) textures2D[name] = desc;
+        }
+    }
+
     void deserializeAllAssets(const nlohmann::json& assetData){
+        PROFILE_ZONE("deserializeAllAssets");
         if(!assetData.is_object()) return;
         if(assetData.contains("shaders"))
             AssetLoader<ShaderProgram>::deserialize(assetData["shaders"]);
-        if(assetData.contains("textures"))
-            AssetLoader<Texture2D>::deserialize(assetData["textures"]);
+        if(assetData.contains("textures")){
+            nlohmann::json textures2D, textureLayers;
+            splitTexturesByUsage(assetData, textures2D, textureLayers);
+            AssetLoader<Texture2D>::deserialize(textures2D);
+            AssetLoader<TextureLayer>::deserialize(textureLayers);
+        }
         if(assetData.contains("samplers"))
             AssetLoader<Sampler>::deserialize(assetData["samplers"]);
         if(assetData.contains("meshes"))
@@ -132,6 +201,8 @@ namespace our {
     void clearAllAssets(){
         AssetLoader<ShaderProgram>::clear();
         AssetLoader<Texture2D>::clear();
+        AssetLoader<TextureLayer>::clear();
+        AssetLoader<TextureArray>::clear();
         AssetLoader<Sampler>::clear();
         AssetLoader<Mesh>::clear();
         AssetLoader<Material>::clear();
@@ -32,6 +32,18 @@ namespace our {
             }
             return nullptr;
         };
+        // This function adds an asset that was created outside "deserialize" (e.g. while loading another asset type)
+        // The asset loader takes the ownership of the asset. If the name is already used, the old asset is deleted.
+        static void add(const std::string& name, T* asset) {
+            if(auto it = assets.find(name); it != assets.end() && it->second != asset){
+                delete it->second;
+            }
+            assets[name] = asset;
+        }
+        // This function returns all the loaded assets (e.g. to compute statistics about them)
+        static const std::unordered_map<std::string, T*>& getAll() {
+            return assets;
+        }
         // This function deletes all the assets held by this class and clear the assets map 
         static void clear(){
             for(auto& [name, asset] : assets){
@@ -25,5 +25,8 @@ namespace our
         /// using the get function from the Asset Loader class, the target mesh data is loaded from the json file
         /// into the material
         material = AssetLoader<Material>::get(data["material"].get<std::string>());
+
+        if (data.contains("static") && data["static"].is_boolean())
+            staticHint = data["static"].get<bool>();
     }
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "../material/material.hpp"
 #include "../asset-loader.hpp"
 
+#include <optional>
+
 namespace our {
 
     // This component denotes that any renderer should draw the given mesh using the given material at the transformation of the owning entity.
@@ -12,6 +14,16 @@ namespace our {
     public:
         Mesh* mesh; // The mesh that should be drawn
         Material* material; // The material used to draw the mesh
+        // The level of detail picked for the last frame. The renderer only switches to another level once the size of the
+        // mesh on the screen is clearly past the switching point (hysteresis), so it needs to remember the current one.
+        int lod = 0;
+        // Whether the mesh was drawn as an impostor in the last frame (for the same hysteresis as the levels of detail)
+        bool impostor = false;
+        // Whether the entity never moves nor gets removed, which allows merging its mesh with others into a static batch.
+        // It is read from the optional "static" key. If it is not given, it is inferred from the entity (see "StaticBatcher::isStatic").
+        std::optional<bool> staticHint;
+        // Set by the static batcher if the mesh was merged into a batch, in which case the renderer doesn't draw it by itself
+        bool batched = false;
 
         // The ID of this component type is "Mesh Renderer"
         static std::string getID() { return "Mesh Renderer"; }
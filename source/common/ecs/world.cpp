@@ -1,4 +1,5 @@
 #include "world.hpp"
+#include "../profiling/cpu-profiler.hpp"
 
 namespace our {
 
@@ -6,6 +7,7 @@ namespace our {
     // If parent pointer is not null, the new entities will be have their parent set to that given pointer
     // If any of the entities has children, this function will be called recursively for these children
     void World::deserialize(const nlohmann::json& data, Entity* parent){
+        PROFILE_ZONE("World::deserialize");
         if(!data.is_array()) return;
         for(const auto& entityData : data)
         {
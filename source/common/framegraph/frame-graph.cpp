@@ -0,0 +1,195 @@
+#include "frame-graph.hpp"
+#include "../gl/state-cache.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace our {
+
+    FrameGraph::Resource FrameGraph::Builder::read(Resource resource){
+        auto& reads = graph.passes[pass].reads;
+        if(std::find(reads.begin(), reads.end(), resource) == reads.end()) reads.push_back(resource);
+        return resource;
+    }
+
+    FrameGraph::Resource FrameGraph::Builder::writeColor(Resource resource, bool clear, glm::vec4 clearColor){
+        auto& attachment = graph.passes[pass].color;
+        attachment.resource = resource;
+        attachment.clear = clear;
+        attachment.clearColor = clearColor;
+        // If the pass doesn't clear the target, it draws on top of the previous content so it depends on it
+        if(!clear && graph.hasEarlierWriter(resource, pass)) read(resource);
+        return resource;
+    }
+
+    FrameGraph::Resource FrameGraph::Builder::writeDepth(Resource resource, bool clear, float clearDepth){
+        auto& attachment = graph.passes[pass].depth;
+        attachment.resource = resource;
+        attachment.clear = clear;
+        attachment.clearDepth = clearDepth;
+        if(!clear && graph.hasEarlierWriter(resource, pass)) read(resource);
+        return resource;
+    }
+
+    void FrameGraph::Builder::sideEffect(){
+        graph.passes[pass].sideEffect = true;
+    }
+
+    FrameGraph::Resource FrameGraph::importBackbuffer(glm::ivec2 size){
+        resources.push_back({"backbuffer", {size, GL_RGBA8}, true, nullptr, -1, -1, 0, false});
+        return (Resource)resources.size() - 1;
+    }
+
+    FrameGraph::Resource FrameGraph::createTexture(const std::string& name, const RenderTargetDescription& description){
+        resources.push_back({name, description, false, nullptr, -1, -1, 0, false});
+        return (Resource)resources.size() - 1;
+    }
+
+    void FrameGraph::addPass(const std::string& name, const std::function<void(Builder&)>& setup, ExecuteFunction execute){
+        passes.push_back({name, std::move(execute), {}, {}, {}, false, 0, false});
+        Builder builder(*this, passes.size() - 1);
+        setup(builder);
+        compiled = false;
+    }
+
+    bool FrameGraph::hasEarlierWriter(Resource resource, size_t pass) const {
+        // Imported resources already hold content written outside the graph
+        if(resources[resource].imported) return true;
+        for(size_t index = 0; index < pass; ++index)
+            if(passes[index].color.resource == resource || passes[index].depth.resource == resource) return true;
+        return false;
+    }
+
+    bool FrameGraph::writesImported(const PassNode& pass) const {
+        for(auto attachment : {pass.color.resource, pass.depth.resource})
+            if(attachment != INVALID && resources[attachment].imported) return true;
+        return false;
+    }
+
+    void FrameGraph::compile(){
+        // Count the readers of each resource and the outputs of each pass
+        for(auto& resource : resources){
+            resource.readCount = 0;
+            resource.firstPass = resource.lastPass = -1;
+        }
+        for(auto& pass : passes){
+            pass.culled = false;
+            pass.referenceCount = 0;
+            if(pass.color.resource != INVALID) ++pass.referenceCount;
+            if(pass.depth.resource != INVALID && pass.depth.resource != pass.color.resource) ++pass.referenceCount;
+            for(auto resource : pass.reads) ++resources[resource].readCount;
+        }
+
+        // Then cull: starting from the resources that nobody reads, remove their producers unless they have side effects
+        // (writing to the backbuffer is a side effect). Removing a pass may leave other resources unread, so we continue from them.
+        std::vector<Resource> unread;
+        for(Resource resource = 0; resource < (Resource)resources.size(); ++resource)
+            if(resources[resource].readCount == 0 && !resources[resource].imported) unread.push_back(resource);
+        while(!unread.empty()){
+            Resource resource = unread.back();
+            unread.pop_back();
+            for(auto& pass : passes){
+                if(pass.culled || (pass.color.resource != resource && pass.depth.resource != resource)) continue;
+                if(--pass.referenceCount > 0 || pass.sideEffect || writesImported(pass)) continue;
+                pass.culled = true;
+                for(auto read : pass.reads)
+                    if(--resources[read].readCount == 0 && !resources[read].imported) unread.push_back(read);
+            }
+        }
+
+        // Finally, compute the lifetime of each resource from the passes that survived
+        for(int index = 0; index < (int)passes.size(); ++index){
+            auto& pass = passes[index];
+            if(pass.culled) continue;
+            auto touch = [&](Resource resource){
+                if(resource == INVALID) return;
+                auto& node = resources[resource];
+                if(node.firstPass < 0) node.firstPass = index;
+                node.lastPass = index;
+            };
+            for(auto read : pass.reads) touch(read);
+            touch(pass.color.resource);
+            touch(pass.depth.resource);
+        }
+        compiled = true;
+    }
+
+    void FrameGraph::bindAndClear(PassNode& pass, RenderTargetPool& pool){
+        Resource color = pass.color.resource, depth = pass.depth.resource;
+        if(color == INVALID && depth == INVALID) return;
+        GLStateCache& cache = GLStateCache::current();
+
+        // The backbuffer is the default framebuffer, otherwise we get the framebuffer matching the attachments from the pool
+        bool toBackbuffer = (color != INVALID && resources[color].imported) || (depth != INVALID && resources[depth].imported);
+        GLuint framebuffer = toBackbuffer ? 0 : pool.getFramebuffer(getTexture(color), getTexture(depth));
+        cache.bindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+        glm::ivec2 size = getSize(color != INVALID ? color : depth);
+        glViewport(0, 0, size.x, size.y);
+
+        // A clear is only needed the first time a target is written in this frame
+        bool clearColor = color != INVALID && pass.color.clear && !resources[color].written;
+        bool clearDepth = depth != INVALID && pass.depth.clear && !resources[depth].written;
+        GLbitfield mask = 0;
+        if(clearColor){
+            // The color & depth masks affect glClear too, so we make sure they allow writing
+            cache.setColorMask(glm::bvec4(true, true, true, true));
+            cache.setClearColor(pass.color.clearColor);
+            mask |= GL_COLOR_BUFFER_BIT;
+        }
+        if(clearDepth){
+            cache.setDepthMask(true);
+            cache.setClearDepth(pass.depth.clearDepth);
+            mask |= GL_DEPTH_BUFFER_BIT;
+        }
+        if(mask) glClear(mask);
+        if(color != INVALID) resources[color].written = true;
+        if(depth != INVALID) resources[depth].written = true;
+    }
+
+    void FrameGraph::execute(RenderTargetPool& pool, GPUTimer* timer){
+        if(!compiled) compile();
+        for(auto& resource : resources) resource.written = false;
+
+        for(int index = 0; index < (int)passes.size(); ++index){
+            auto& pass = passes[index];
+            if(pass.culled) continue;
+            // Acquire the textures of the resources whose lifetime starts at this pass
+            for(auto& resource : resources)
+                if(!resource.imported && resource.firstPass == index) resource.texture = pool.acquire(resource.description);
+
+            bindAndClear(pass, pool);
+            if(pass.execute) pass.execute(*this);
+            if(timer) timer->endPass(pass.name);
+
+            // Then give back the textures of the resources whose lifetime ends at this pass so that later passes can reuse them
+            for(auto& resource : resources){
+                if(!resource.imported && resource.lastPass == index && resource.texture){
+                    pool.release(resource.texture);
+                    resource.texture = nullptr;
+                }
+            }
+        }
+    }
+
+    void FrameGraph::reset(){
+        resources.clear();
+        passes.clear();
+        compiled = false;
+    }
+
+    Texture2D* FrameGraph::getTexture(Resource resource) const {
+        if(resource == INVALID) return nullptr;
+        return resources[resource].texture;
+    }
+
+    glm::ivec2 FrameGraph::getSize(Resource resource) const {
+        assert(resource != INVALID);
+        return resources[resource].description.size;
+    }
+
+    size_t FrameGraph::getCulledPassCount() const {
+        return std::count_if(passes.begin(), passes.end(), [](const PassNode& pass){ return pass.culled; });
+    }
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "render-target-pool.hpp"
+#include "../gl/gpu-timer.hpp"
+
+#include <glm/vec4.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace our {
+
+    // A frame graph describes the passes of a frame and the render targets each of them reads & writes.
+    // It is rebuilt every frame (building it is cheap) then compiled and executed:
+    // - Compiling culls the passes whose outputs are never used and computes the lifetime of each transient render target.
+    // - During execution, transient targets are taken from a RenderTargetPool right before their first use and given back after their last use,
+    //   so targets whose lifetimes don't overlap share the same texture (memory aliasing) and nothing is reallocated between frames.
+    // - Executing binds the framebuffer of each pass (only if it changed) and clears an attachment only if the pass asked for it
+    //   and it is the first write to that target in the frame.
+    class FrameGraph {
+    public:
+        // A handle to a render target declared in the graph
+        using Resource = int;
+        static constexpr Resource INVALID = -1;
+
+        // The builder is given to the setup function of each pass to declare what the pass reads and writes
+        class Builder {
+            FrameGraph& graph;
+            size_t pass;
+            friend FrameGraph;
+            Builder(FrameGraph& graph, size_t pass) : graph(graph), pass(pass) {}
+        public:
+            // Declares that the pass samples (or depth tests against) the given target
+            Resource read(Resource resource);
+            // Declares that the pass draws into the given target as its color attachment
+            Resource writeColor(Resource resource, bool clear = false, glm::vec4 clearColor = {0.0f, 0.0f, 0.0f, 1.0f});
+            // Declares that the pass draws into the given target as its depth attachment
+            Resource writeDepth(Resource resource, bool clear = false, float clearDepth = 1.0f);
+            // Marks the pass as having side effects outside the graph so that it is never culled
+            void sideEffect();
+        };
+
+        // The function that records the pass' OpenGL commands. The framebuffer is already bound and cleared when it is called.
+        using ExecuteFunction = std::function<void(FrameGraph&)>;
+
+    private:
+        struct ResourceNode {
+            std::string name;
+            RenderTargetDescription description;
+            bool imported;              // Imported resources (the backbuffer) are not owned by the graph
+            Texture2D* texture;         // The pooled texture (null for the backbuffer)
+            int firstPass, lastPass;    // The lifetime of the resource (in pass indices)
+            int readCount;              // How many (non-culled) passes read the resource
+            bool written;               // Whether any pass already wrote it during execution
+        };
+
+        struct Attachment {
+            Resource resource = INVALID;
+            bool clear = false;
+            glm::vec4 clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
+            float clearDepth = 1.0f;
+        };
+
+        struct PassNode {
+            std::string name;
+            ExecuteFunction execute;
+            std::vector<Resource> reads;
+            Attachment color, depth;
+            bool sideEffect;
+            int referenceCount;
+            bool culled;
+        };
+
+        std::vector<ResourceNode> resources;
+        std::vector<PassNode> passes;
+        bool compiled = false;
+
+        bool hasEarlierWriter(Resource resource, size_t pass) const;
+        bool writesImported(const PassNode& pass) const;
+        void bindAndClear(PassNode& pass, RenderTargetPool& pool);
+
+    public:
+        // Declares the default framebuffer (the window) as a resource. It can be used as both a color and a depth attachment.
+        Resource importBackbuffer(glm::ivec2 size);
+        // Declares a transient render target that will be allocated from the pool
+        Resource createTexture(const std::string& name, const RenderTargetDescription& description);
+
+        // Adds a pass. "setup" is called immediately to declare the pass' inputs and outputs.
+        void addPass(const std::string& name, const std::function<void(Builder&)>& setup, ExecuteFunction execute);
+
+        // Culls the unused passes and computes the lifetime of each resource
+        void compile();
+        // Runs the passes that survived culling in the order they were added
+        // Each transient resource gets a texture from the pool before its first pass and gives it back after its last pass
+        // If a timer is given, the end of each pass is marked on it to measure the GPU time of each pass
+        void execute(RenderTargetPool& pool, GPUTimer* timer = nullptr);
+        // Removes all the passes and resources so that the graph can be rebuilt for the next frame
+        void reset();
+
+        // Returns the texture of a resource (only valid during execution and null for the backbuffer)
+        Texture2D* getTexture(Resource resource) const;
+        // Returns the size of a resource
+        glm::ivec2 getSize(Resource resource) const;
+
+        // Statistics about the last compiled graph
+        size_t getPassCount() const { return passes.size(); }
+        size_t getCulledPassCount() const;
+    };
+
+}
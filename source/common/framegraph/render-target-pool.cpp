@@ -0,0 +1,111 @@
+#include "render-target-pool.hpp"
+#include "../gl/state-cache.hpp"
+
+#include <iostream>
+
+namespace our {
+
+    // Returns the number of bytes per pixel for the formats we use as render targets
+    static size_t bytesPerPixel(GLenum format){
+        switch(format){
+            case GL_R8: return 1;
+            case GL_RG8: return 2;
+            case GL_RGB8: return 3;
+            case GL_RGBA16F: return 8;
+            case GL_RGBA32F: return 16;
+            case GL_R11F_G11F_B10F: return 4;
+            case GL_DEPTH_COMPONENT16: return 2;
+            case GL_DEPTH_COMPONENT24: return 4; // Drivers usually pad 24-bit depth to 32 bits
+            case GL_DEPTH_COMPONENT32F: return 4;
+            case GL_DEPTH24_STENCIL8: return 4;
+            default: return 4;
+        }
+    }
+
+    Texture2D* RenderTargetPool::acquire(const RenderTargetDescription& description){
+        for(auto& entry : entries){
+            if(!entry.inUse && entry.description == description){
+                entry.inUse = true;
+                entry.lastUsedFrame = frame;
+                return entry.texture;
+            }
+        }
+        // No free texture matches, so we create one
+        Texture2D* texture = new Texture2D();
+        texture->bind();
+        glTexStorage2D(GL_TEXTURE_2D, description.levels, description.format, description.size.x, description.size.y);
+        entries.push_back({texture, description, true, frame});
+        return texture;
+    }
+
+    void RenderTargetPool::release(Texture2D* texture){
+        for(auto& entry : entries){
+            if(entry.texture == texture){
+                entry.inUse = false;
+                return;
+            }
+        }
+    }
+
+    GLuint RenderTargetPool::getFramebuffer(Texture2D* color, Texture2D* depth){
+        GLuint colorName = color ? color->getOpenGLName() : 0;
+        GLuint depthName = depth ? depth->getOpenGLName() : 0;
+        if(auto it = framebuffers.find({colorName, depthName}); it != framebuffers.end()){
+            return it->second;
+        }
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        GLStateCache::current().bindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        if(color){
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorName, 0);
+        } else {
+            // A framebuffer without color attachments must not expect the fragment shader to write colors
+            glDrawBuffer(GL_NONE);
+        }
+        if(depth){
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthName, 0);
+        }
+        if(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            std::cerr << "ERROR: Render target framebuffer is incomplete" << std::endl;
+        }
+        framebuffers[{colorName, depthName}] = framebuffer;
+        return framebuffer;
+    }
+
+    void RenderTargetPool::trim(unsigned unusedFrames){
+        for(auto it = entries.begin(); it != entries.end();){
+            if(it->inUse || frame - it->lastUsedFrame < unusedFrames){ ++it; continue; }
+            GLuint name = it->texture->getOpenGLName();
+            for(auto fb = framebuffers.begin(); fb != framebuffers.end();){
+                if(fb->first.first == name || fb->first.second == name){
+                    GLStateCache::current().onFramebufferDeleted(fb->second);
+                    glDeleteFramebuffers(1, &fb->second);
+                    fb = framebuffers.erase(fb);
+                } else ++fb;
+            }
+            delete it->texture;
+            it = entries.erase(it);
+        }
+    }
+
+    void RenderTargetPool::destroy(){
+        for(auto& [attachments, framebuffer] : framebuffers){
+            GLStateCache::current().onFramebufferDeleted(framebuffer);
+            glDeleteFramebuffers(1, &framebuffer);
+        }
+        framebuffers.clear();
+        for(auto& entry : entries) delete entry.texture;
+        entries.clear();
+    }
+
+    size_t RenderTargetPool::getAllocatedBytes() const {
+        size_t bytes = 0;
+        for(auto& entry : entries){
+            size_t levelBytes = (size_t)entry.description.size.x * entry.description.size.y * bytesPerPixel(entry.description.format);
+            // A full mip chain adds about a third to the size of the first level
+            bytes += entry.description.levels > 1 ? levelBytes * 4 / 3 : levelBytes;
+        }
+        return bytes;
+    }
+
+}
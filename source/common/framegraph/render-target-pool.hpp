@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../texture/texture2d.hpp"
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace our {
+
+    // This describes a render target texture (its size, internal format and number of mip levels)
+    // Two transient textures with the same description can share the same memory if their lifetimes don't overlap
+    // Most targets need a single level. A full mip chain is only needed when a later pass downsamples the target by sampling its mip levels.
+    struct RenderTargetDescription {
+        glm::ivec2 size = {0, 0};
+        GLenum format = GL_RGBA8;
+        GLsizei levels = 1;
+
+        bool operator==(const RenderTargetDescription& other) const {
+            return size == other.size && format == other.format && levels == other.levels;
+        }
+
+        // Returns the number of levels of a full mip chain for the given size
+        static GLsizei fullMipChain(glm::ivec2 size) {
+            GLsizei levels = 1;
+            for(int largest = std::max(size.x, size.y); largest > 1; largest >>= 1) ++levels;
+            return levels;
+        }
+    };
+
+    // This class owns the textures used as transient render targets and the framebuffers that combine them
+    // Textures are never deleted when released, they go back to the pool to be reused by the next request with the same description
+    // (in the same frame by a pass that starts after the previous owner ended, or in later frames).
+    class RenderTargetPool {
+        struct Entry {
+            Texture2D* texture;
+            RenderTargetDescription description;
+            bool inUse;
+            unsigned lastUsedFrame;
+        };
+        std::vector<Entry> entries;
+        // A frame counter used to find the textures that haven't been used for a while
+        unsigned frame = 0;
+        // The framebuffers created for each combination of (color, depth) textures (0 means no attachment)
+        std::map<std::pair<GLuint, GLuint>, GLuint> framebuffers;
+    public:
+        // The pool doesn't free its objects on destruction since the OpenGL context may already be gone by then,
+        // so "destroy" must be called explicitly (the forward renderer does that in its own "destroy").
+        RenderTargetPool() = default;
+
+        // Returns a free texture that matches the description (a new texture is only created if none is free)
+        Texture2D* acquire(const RenderTargetDescription& description);
+        // Returns the texture to the pool so that it can be reused
+        void release(Texture2D* texture);
+        // Returns a framebuffer that has the given color & depth attachments (any of them can be null)
+        GLuint getFramebuffer(Texture2D* color, Texture2D* depth);
+
+        // Should be called once per frame (it is only used to know how long each texture has been unused)
+        void beginFrame() { ++frame; }
+        // Deletes the textures that are not in use and weren't acquired during the last "unusedFrames" frames (and the framebuffers that refer to them)
+        // This is useful when the sizes change over time (e.g. with dynamic resolution) so that old sizes don't keep their memory forever
+        void trim(unsigned unusedFrames = 0);
+        // Deletes all the textures and framebuffers
+        void destroy();
+
+        // Returns an estimate of the video memory used by the pooled textures in bytes
+        size_t getAllocatedBytes() const;
+        size_t getTextureCount() const { return entries.size(); }
+
+        RenderTargetPool(const RenderTargetPool&) = delete;
+        RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+    };
+
+}
@@ -0,0 +1,113 @@
+#include "gpu-timer.hpp"
+
+#include <algorithm>
+
+namespace our {
+
+    GLuint GPUTimer::query(FrameQueries& frame, size_t index){
+        // The query objects are created on demand and kept for the next frames that use this slot
+        while(frame.queries.size() <= index){
+            GLuint name;
+            glGenQueries(1, &name);
+            frame.queries.push_back(name);
+        }
+        return frame.queries[index];
+    }
+
+    void GPUTimer::collect(FrameQueries& frame){
+        if(!frame.pending) return;
+        frame.pending = false;
+        // The queries finish in order, so if the last one is available all of them are
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[frame.names.size()], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available){
+            // The GPU is more than FRAME_LATENCY frames behind. We drop the results instead of waiting for them.
+            ++droppedFrames;
+            return;
+        }
+        GLuint64 start, previous, current = 0;
+        glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &start);
+        previous = start;
+        for(size_t index = 0; index < frame.names.size(); ++index){
+            glGetQueryObjectui64v(frame.queries[index + 1], GL_QUERY_RESULT, &current);
+            addSample(frame.names[index], (float)((current - previous) * 1e-6));
+            previous = current;
+        }
+        addSample("frame", (float)((current - start) * 1e-6));
+    }
+
+    void GPUTimer::addSample(const std::string& name, float milliseconds){
+        auto it = std::find_if(histories.begin(), histories.end(), [&](const PassHistory& history){ return history.name == name; });
+        if(it == histories.end()){
+            // Keep "frame" as the last entry
+            auto position = histories.end();
+            if(!histories.empty() && histories.back().name == "frame") --position;
+            it = histories.insert(position, PassHistory{name});
+        }
+        it->samples[it->next] = milliseconds;
+        it->next = (it->next + 1) % HISTORY_SIZE;
+        it->count = std::min(it->count + 1, HISTORY_SIZE);
+    }
+
+    void GPUTimer::beginFrame(){
+        if(!enabled) return;
+        currentFrame = (currentFrame + 1) % FRAME_LATENCY;
+        FrameQueries& frame = frames[currentFrame];
+        // This slot was used FRAME_LATENCY frames ago, so its results are most probably ready
+        collect(frame);
+        frame.names.clear();
+        glQueryCounter(query(frame, 0), GL_TIMESTAMP);
+        inFrame = true;
+    }
+
+    void GPUTimer::endPass(const std::string& name){
+        if(!enabled || !inFrame) return;
+        FrameQueries& frame = frames[currentFrame];
+        frame.names.push_back(name);
+        glQueryCounter(query(frame, frame.names.size()), GL_TIMESTAMP);
+    }
+
+    void GPUTimer::endFrame(){
+        if(!enabled || !inFrame) return;
+        frames[currentFrame].pending = true;
+        inFrame = false;
+    }
+
+    std::vector<GPUTimer::PassStatistics> GPUTimer::getStatistics() const {
+        std::vector<PassStatistics> statistics;
+        std::vector<float> sorted;
+        for(auto& history : histories){
+            PassStatistics pass;
+            pass.name = history.name;
+            pass.samples = history.count;
+            if(history.count > 0){
+                sorted.assign(history.samples.begin(), history.samples.begin() + history.count);
+                std::sort(sorted.begin(), sorted.end());
+                pass.last = history.samples[(history.next + HISTORY_SIZE - 1) % HISTORY_SIZE];
+                pass.min = sorted.front();
+                float sum = 0;
+                for(float sample : sorted) sum += sample;
+                pass.average = sum / history.count;
+                pass.p99 = sorted[std::min(history.count - 1, (int)(history.count * 0.99f))];
+            }
+            statistics.push_back(pass);
+        }
+        return statistics;
+    }
+
+    void GPUTimer::clearHistory(){
+        histories.clear();
+        droppedFrames = 0;
+    }
+
+    void GPUTimer::destroy(){
+        for(auto& frame : frames){
+            if(!frame.queries.empty()) glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+            frame.queries.clear();
+            frame.names.clear();
+            frame.pending = false;
+        }
+        inFrame = false;
+    }
+
+}
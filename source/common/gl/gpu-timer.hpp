@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace our {
+
+    // This class measures how long the GPU spends on each pass of a frame using timestamp queries
+    // A timestamp is written when the frame starts and after each pass, so the duration of a pass is the difference
+    // between its timestamp and the previous one (this way, passes never nest and the pass durations add up to the frame).
+    // The results are only read when they are available which is a few frames later, so the CPU never waits for the GPU.
+    // To do that, the queries of each frame are kept in a ring of FRAME_LATENCY slots that is reused once the results are read.
+    class GPUTimer {
+    public:
+        // How many frames can be in flight before we reuse the queries of a frame
+        static constexpr int FRAME_LATENCY = 4;
+        // How many frames are kept to compute the statistics of each pass
+        static constexpr int HISTORY_SIZE = 240;
+
+        // The statistics of a pass over the last HISTORY_SIZE frames (in milliseconds)
+        struct PassStatistics {
+            std::string name;
+            float last = 0, min = 0, average = 0, p99 = 0;
+            int samples = 0;
+        };
+
+    private:
+        struct FrameQueries {
+            std::vector<GLuint> queries;        // queries[0] is the start of the frame, queries[i] is the end of the pass names[i - 1]
+            std::vector<std::string> names;
+            bool pending = false;
+        };
+        std::array<FrameQueries, FRAME_LATENCY> frames;
+        int currentFrame = 0;
+        bool inFrame = false;
+
+        struct PassHistory {
+            std::string name;
+            std::array<float, HISTORY_SIZE> samples{};
+            int next = 0, count = 0;
+        };
+        // The history of each pass (in the order they were first seen) + the whole frame
+        std::vector<PassHistory> histories;
+        // How many frames were dropped since their results weren't ready when their slot was needed again
+        int droppedFrames = 0;
+
+        void collect(FrameQueries& frame);
+        void addSample(const std::string& name, float milliseconds);
+        GLuint query(FrameQueries& frame, size_t index);
+
+    public:
+        // If disabled, no queries are issued
+        bool enabled = true;
+
+        // Marks the start of a frame. Results of older frames are collected here if they are ready.
+        void beginFrame();
+        // Marks the end of a pass. It must be called after the pass' commands are issued.
+        void endPass(const std::string& name);
+        // Marks the end of a frame
+        void endFrame();
+
+        // Returns the statistics of each pass in the order in which they were first seen. The last entry is the whole frame ("frame").
+        std::vector<PassStatistics> getStatistics() const;
+        int getDroppedFrames() const { return droppedFrames; }
+        // Removes the collected samples
+        void clearHistory();
+
+        // Deletes the queries. Like the other objects that own OpenGL objects in the renderer, this has to be called explicitly
+        // while the context is still alive.
+        void destroy();
+    };
+
+}
@@ -0,0 +1,141 @@
+#include "headless-context.hpp"
+#include "state-cache.hpp"
+
+#include <iostream>
+
+#if defined(ENABLE_HEADLESS)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace our {
+
+#if defined(ENABLE_HEADLESS)
+
+    bool HeadlessContext::create(glm::ivec2 size){
+        this->size = size;
+
+        // The surfaceless platform needs no display server. If the driver doesn't have it, we fall back to the default display.
+        EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(getPlatformDisplay) eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if(eglDisplay == EGL_NO_DISPLAY) eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        EGLint major, minor;
+        if(eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)){
+            std::cerr << "Failed to initialize EGL" << std::endl;
+            return false;
+        }
+        display = eglDisplay;
+
+        // We never create a surface, so the config only has to support desktop OpenGL
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, 0,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if(!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0 || !eglBindAPI(EGL_OPENGL_API)){
+            std::cerr << "Failed to find an EGL config for desktop OpenGL" << std::endl;
+            destroy();
+            return false;
+        }
+
+        // The same version & profile as the windowed context
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+            EGL_NONE
+        };
+        EGLContext eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+        if(eglContext == EGL_NO_CONTEXT){
+            std::cerr << "Failed to create an OpenGL 3.3 core context with EGL" << std::endl;
+            destroy();
+            return false;
+        }
+        context = eglContext;
+        // Making a context current without a surface needs EGL_KHR_surfaceless_context (which Mesa always has)
+        if(!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)){
+            std::cerr << "Failed to make the EGL context current (is EGL_KHR_surfaceless_context supported?)" << std::endl;
+            destroy();
+            return false;
+        }
+        if(!gladLoadGL((GLADloadfunc)eglGetProcAddress)){
+            std::cerr << "Failed to load the OpenGL functions" << std::endl;
+            destroy();
+            return false;
+        }
+
+        // The offscreen framebuffer has the same formats as the window's (RGBA8 color with a 24-bit depth & 8-bit stencil buffer)
+        glGenRenderbuffers(1, &colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            std::cerr << "ERROR: The headless framebuffer is incomplete" << std::endl;
+            destroy();
+            return false;
+        }
+        glViewport(0, 0, size.x, size.y);
+
+        // From now on, binding the framebuffer 0 binds the offscreen framebuffer
+        GLStateCache::current().setDefaultFramebuffer(framebuffer);
+        return true;
+    }
+
+    bool HeadlessContext::resize(glm::ivec2 size){
+        if(!framebuffer) return false;
+        if(size == this->size) return true;
+        this->size = size;
+        // The renderbuffers stay attached to the framebuffer, only their storage is reallocated
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glViewport(0, 0, size.x, size.y);
+        return true;
+    }
+
+    void HeadlessContext::destroy(){
+        if(context){
+            if(framebuffer){
+                GLStateCache::current().setDefaultFramebuffer(0);
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glDeleteFramebuffers(1, &framebuffer);
+                glDeleteRenderbuffers(1, &colorBuffer);
+                glDeleteRenderbuffers(1, &depthBuffer);
+                framebuffer = colorBuffer = depthBuffer = 0;
+            }
+            eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+            context = nullptr;
+        }
+        if(display){
+            eglTerminate((EGLDisplay)display);
+            display = nullptr;
+        }
+    }
+
+#else
+
+    bool HeadlessContext::create(glm::ivec2 size){
+        std::cerr << "The headless mode is not available: the application was built without EGL" << std::endl;
+        return false;
+    }
+
+    bool HeadlessContext::resize(glm::ivec2 size){ return false; }
+
+    void HeadlessContext::destroy(){}
+
+#endif
+
+}
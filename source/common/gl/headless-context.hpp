@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+
+namespace our {
+
+    // An OpenGL context that doesn't need a window nor a display (e.g. for tests and benchmarks on build machines).
+    // The context is created with EGL on the surfaceless platform (Mesa supports it with llvmpipe when there is no GPU)
+    // and everything is rendered into an offscreen framebuffer that takes the place of the window's default framebuffer:
+    // the state cache redirects every bind of framebuffer 0 to it, so the renderer and the screenshots work as usual.
+    // The headless mode is only compiled in if EGL was found (ENABLE_HEADLESS), otherwise "create" always fails.
+    class HeadlessContext {
+        void* display = nullptr;
+        void* context = nullptr;
+        GLuint framebuffer = 0, colorBuffer = 0, depthBuffer = 0;
+        glm::ivec2 size = {0, 0};
+
+    public:
+        // Creates an OpenGL 3.3 core context and an offscreen framebuffer of the given size, makes them current and loads the
+        // OpenGL functions. Returns false (after printing the reason) if any of this failed.
+        bool create(glm::ivec2 size);
+        // Reallocates the offscreen framebuffer with a new size (its content is lost). Returns false if it failed.
+        bool resize(glm::ivec2 size);
+        // Deletes the framebuffer and the context
+        void destroy();
+
+        glm::ivec2 getSize() const { return size; }
+        GLuint getFramebuffer() const { return framebuffer; }
+    };
+
+}
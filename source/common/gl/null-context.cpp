@@ -0,0 +1,1178 @@
+#include "null-context.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace our {
+
+    namespace {
+
+        // The model of the OpenGL objects. Only what the validation (or a query) needs is kept.
+        struct BufferObject {
+            std::vector<unsigned char> data;
+            bool immutable = false;         // Created by glBufferStorage
+            bool mapped = false;
+            GLbitfield mapAccess = 0;
+        };
+        struct TextureObject {
+            GLenum target = 0;              // The target the texture was first bound to (a texture can't change its target)
+            bool immutable = false;         // Created by glTexStorage*
+            std::vector<glm::ivec3> levels; // The size of each mip level
+        };
+        struct VertexArrayObject {
+            GLuint elementBuffer = 0;       // The element buffer binding is a part of the vertex array state
+        };
+        struct FramebufferObject {
+            std::unordered_map<GLenum, GLuint> attachments;
+        };
+        struct ShaderObject {
+            GLenum type = 0;
+            bool hasSource = false, compiled = false;
+            // A shader that is deleted while attached lives until it is detached (or its program is deleted)
+            bool deletePending = false;
+        };
+        struct ProgramObject {
+            std::vector<GLuint> shaders;
+            bool linked = false;
+            std::string log; // Why the last link failed
+            // Nothing is compiled, so each name gets a location (or an index) the first time it is queried
+            std::unordered_map<std::string, GLint> uniforms, attributes;
+            std::unordered_map<std::string, GLuint> blocks;
+        };
+
+        constexpr GLuint TEXTURE_UNITS = 32;
+        // After that many errors, the errors are only counted (a broken frame loop would flood the output otherwise)
+        constexpr std::uint64_t MAX_PRINTED_ERRORS = 32;
+
+        struct State {
+            // The call counter of each function (in the order they were first called)
+            std::vector<std::string> functionNames;
+            std::vector<std::uint64_t> calls;
+            std::uint64_t drawCalls = 0, errors = 0;
+
+            // A single counter for all the kinds of objects, so that passing a texture where a buffer is expected is caught too
+            GLuint nextName = 1;
+            std::uintptr_t nextSync = 1;
+            GLint nextUniformLocation = 0;
+
+            std::unordered_map<GLuint, BufferObject> buffers;
+            std::unordered_map<GLuint, TextureObject> textures;
+            std::unordered_map<GLuint, VertexArrayObject> vertexArrays; // The vertex array 0 holds the bindings made while no vertex array is bound
+            std::unordered_map<GLuint, FramebufferObject> framebuffers;
+            std::unordered_set<GLuint> renderbuffers, samplers, queries;
+            std::unordered_map<GLuint, ShaderObject> shaders;
+            std::unordered_map<GLuint, ProgramObject> programs;
+            std::unordered_set<std::uintptr_t> syncs;
+            // The program that owns each uniform location (the locations are unique among all the programs)
+            std::unordered_map<GLint, GLuint> uniformOwners;
+
+            // The bindings
+            std::unordered_map<GLenum, GLuint> bufferBindings; // The non-indexed buffer targets (except the element array buffer)
+            GLuint vertexArray = 0, program = 0, drawFramebuffer = 0, readFramebuffer = 0, renderbuffer = 0;
+            GLuint activeTexture = 0;
+            std::array<std::unordered_map<GLenum, GLuint>, TEXTURE_UNITS> textureBindings;
+            std::array<GLuint, TEXTURE_UNITS> samplerBindings{};
+
+            // The few pieces of the pipeline state that can be queried back (ImGui saves & restores them)
+            std::unordered_set<GLenum> enabled;
+            GLint viewport[4] = {0, 0, 0, 0}, scissor[4] = {0, 0, 0, 0};
+            GLenum blendSourceRGB = GL_ONE, blendDestinationRGB = GL_ZERO, blendSourceAlpha = GL_ONE, blendDestinationAlpha = GL_ZERO;
+            GLenum blendEquationRGB = GL_FUNC_ADD, blendEquationAlpha = GL_FUNC_ADD;
+            GLenum polygonMode = GL_FILL;
+            GLint packAlignment = 4, unpackAlignment = 4;
+        };
+        State state;
+
+        std::size_t registerFunction(const char* name){
+            state.functionNames.emplace_back(name);
+            state.calls.push_back(0);
+            return state.calls.size() - 1;
+        }
+
+        // Every stub starts with this: it counts the call and names the function for the error messages
+        #define NULL_GL_CALL(name) \
+            static const std::size_t counter = registerFunction(#name); \
+            ++state.calls[counter]; \
+            [[maybe_unused]] constexpr const char* function = #name
+
+        std::string hex(GLenum value){
+            std::ostringstream stream;
+            stream << "0x" << std::hex << std::uppercase << value;
+            return stream.str();
+        }
+
+        void error(const char* function, const std::string& message){
+            if(state.errors < MAX_PRINTED_ERRORS)
+                std::cerr << "ERROR: (null GL) " << function << ": " << message << std::endl;
+            else if(state.errors == MAX_PRINTED_ERRORS)
+                std::cerr << "ERROR: (null GL) Too many errors, the next ones are only counted" << std::endl;
+            ++state.errors;
+        }
+
+        // Returns the buffer bound to the target or reports an error (and returns null) if there is none
+        BufferObject* boundBuffer(const char* function, GLenum target){
+            GLuint name = target == GL_ELEMENT_ARRAY_BUFFER ? state.vertexArrays[state.vertexArray].elementBuffer : state.bufferBindings[target];
+            if(name == 0){
+                error(function, "No buffer is bound to the target " + hex(target));
+                return nullptr;
+            }
+            return &state.buffers[name];
+        }
+
+        // Returns whether the range is inside the buffer (and reports an error if it isn't)
+        bool checkRange(const char* function, const BufferObject& buffer, GLintptr offset, GLsizeiptr size){
+            if(offset < 0 || size < 0 || (std::size_t)(offset + size) > buffer.data.size()){
+                error(function, "The range [" + std::to_string(offset) + ", " + std::to_string(offset + size) + ") is outside the buffer of " +
+                    std::to_string(buffer.data.size()) + " bytes");
+                return false;
+            }
+            return true;
+        }
+
+        // Returns the texture bound to the target of the active unit or reports an error (and returns null) if there is none
+        TextureObject* boundTexture(const char* function, GLenum target){
+            GLuint name = state.textureBindings[state.activeTexture][target];
+            if(name == 0){
+                error(function, "No texture is bound to the target " + hex(target) + " of the unit " + std::to_string(state.activeTexture));
+                return nullptr;
+            }
+            return &state.textures[name];
+        }
+
+        GLuint& boundFramebuffer(GLenum target){
+            return target == GL_READ_FRAMEBUFFER ? state.readFramebuffer : state.drawFramebuffer;
+        }
+
+        template<typename Objects>
+        void generate(GLsizei count, GLuint* names, Objects& objects){
+            for(GLsizei index = 0; index < count; ++index){
+                names[index] = state.nextName++;
+                objects[names[index]];
+            }
+        }
+        void generate(GLsizei count, GLuint* names, std::unordered_set<GLuint>& objects){
+            for(GLsizei index = 0; index < count; ++index){
+                names[index] = state.nextName++;
+                objects.insert(names[index]);
+            }
+        }
+
+        // Reports an error if the name is neither 0 nor a live object (binding an object that was never generated is an error in the core profile)
+        template<typename Objects>
+        bool checkName(const char* function, const Objects& objects, GLuint name, const char* kind){
+            if(name != 0 && objects.find(name) == objects.end()){
+                error(function, std::to_string(name) + " is not the name of a " + kind);
+                return false;
+            }
+            return true;
+        }
+
+        // Checks what every draw call needs: a linked program and a vertex array
+        bool checkDraw(const char* function){
+            ++state.drawCalls;
+            if(state.program == 0){
+                error(function, "No program is in use");
+                return false;
+            }
+            if(state.vertexArray == 0){
+                error(function, "No vertex array is bound");
+                return false;
+            }
+            return true;
+        }
+
+        // Checks that the location belongs to the program in use (the location -1 is silently ignored like OpenGL does)
+        void checkUniform(const char* function, GLint location){
+            if(location == -1) return;
+            if(state.program == 0){
+                error(function, "No program is in use");
+                return;
+            }
+            auto it = state.uniformOwners.find(location);
+            if(it == state.uniformOwners.end() || it->second != state.program)
+                error(function, "The location " + std::to_string(location) + " doesn't belong to the program " + std::to_string(state.program));
+        }
+
+        // The bytes of a pixel of the given format & type (for glReadPixels)
+        GLsizei pixelSize(GLenum format, GLenum type){
+            GLsizei components = 4;
+            switch(format){
+                case GL_RED: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX: components = 1; break;
+                case GL_RG: components = 2; break;
+                case GL_RGB: case GL_BGR: components = 3; break;
+            }
+            switch(type){
+                case GL_FLOAT: case GL_UNSIGNED_INT: case GL_INT: return components * 4;
+                case GL_HALF_FLOAT: case GL_UNSIGNED_SHORT: case GL_SHORT: return components * 2;
+                default: return components;
+            }
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Queries
+
+        const GLubyte* GLAD_API_PTR null_glGetString(GLenum name){
+            NULL_GL_CALL(glGetString);
+            switch(name){
+                case GL_VENDOR: return (const GLubyte*)"our";
+                case GL_RENDERER: return (const GLubyte*)"Null GL (nothing is rendered)";
+                // glad reads the version to decide which functions to load, so we claim 4.5 to get the same code paths as a modern driver
+                case GL_VERSION: return (const GLubyte*)"4.5 Null GL";
+                case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"4.50";
+            }
+            error(function, "Unknown name " + hex(name));
+            return nullptr;
+        }
+
+        // glad needs at least one extension (it fails to load otherwise), so we report the one the engine checks for
+        const char* const EXTENSIONS[] = {"GL_ARB_buffer_storage"};
+
+        const GLubyte* GLAD_API_PTR null_glGetStringi(GLenum name, GLuint index){
+            NULL_GL_CALL(glGetStringi);
+            if(name != GL_EXTENSIONS || index >= std::size(EXTENSIONS)){
+                error(function, "Invalid name or index");
+                return nullptr;
+            }
+            return (const GLubyte*)EXTENSIONS[index];
+        }
+
+        void GLAD_API_PTR null_glGetIntegerv(GLenum name, GLint* data){
+            NULL_GL_CALL(glGetIntegerv);
+            switch(name){
+                case GL_NUM_EXTENSIONS: *data = (GLint)std::size(EXTENSIONS); break;
+                case GL_MAJOR_VERSION: *data = 4; break;
+                case GL_MINOR_VERSION: *data = 5; break;
+                case GL_MAX_TEXTURE_SIZE: *data = 16384; break;
+                case GL_MAX_ARRAY_TEXTURE_LAYERS: *data = 2048; break;
+                case GL_MAX_TEXTURE_IMAGE_UNITS: case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: *data = TEXTURE_UNITS; break;
+                case GL_MAX_UNIFORM_BLOCK_SIZE: *data = 65536; break;
+                case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: *data = 256; break;
+                // Nothing is compiled, so there is no program binary to save (the program binary cache disables itself)
+                case GL_NUM_PROGRAM_BINARY_FORMATS: *data = 0; break;
+                case GL_VIEWPORT: std::copy(state.viewport, state.viewport + 4, data); break;
+                case GL_SCISSOR_BOX: std::copy(state.scissor, state.scissor + 4, data); break;
+                case GL_ACTIVE_TEXTURE: *data = GL_TEXTURE0 + state.activeTexture; break;
+                case GL_CURRENT_PROGRAM: *data = state.program; break;
+                case GL_TEXTURE_BINDING_2D: *data = state.textureBindings[state.activeTexture][GL_TEXTURE_2D]; break;
+                case GL_TEXTURE_BINDING_2D_ARRAY: *data = state.textureBindings[state.activeTexture][GL_TEXTURE_2D_ARRAY]; break;
+                case GL_SAMPLER_BINDING: *data = state.samplerBindings[state.activeTexture]; break;
+                case GL_ARRAY_BUFFER_BINDING: *data = state.bufferBindings[GL_ARRAY_BUFFER]; break;
+                case GL_ELEMENT_ARRAY_BUFFER_BINDING: *data = state.vertexArrays[state.vertexArray].elementBuffer; break;
+                case GL_VERTEX_ARRAY_BINDING: *data = state.vertexArray; break;
+                case GL_DRAW_FRAMEBUFFER_BINDING: *data = state.drawFramebuffer; break;
+                case GL_READ_FRAMEBUFFER_BINDING: *data = state.readFramebuffer; break;
+                case GL_POLYGON_MODE: data[0] = data[1] = state.polygonMode; break;
+                case GL_BLEND_SRC_RGB: *data = state.blendSourceRGB; break;
+                case GL_BLEND_DST_RGB: *data = state.blendDestinationRGB; break;
+                case GL_BLEND_SRC_ALPHA: *data = state.blendSourceAlpha; break;
+                case GL_BLEND_DST_ALPHA: *data = state.blendDestinationAlpha; break;
+                case GL_BLEND_EQUATION_RGB: *data = state.blendEquationRGB; break;
+                case GL_BLEND_EQUATION_ALPHA: *data = state.blendEquationAlpha; break;
+                case GL_CLIP_ORIGIN: *data = GL_LOWER_LEFT; break;
+                case GL_PACK_ALIGNMENT: *data = state.packAlignment; break;
+                case GL_UNPACK_ALIGNMENT: *data = state.unpackAlignment; break;
+                // The rest of the state isn't modelled, so it reads as zeros
+                default: *data = 0; break;
+            }
+        }
+
+        GLenum GLAD_API_PTR null_glGetError(){
+            NULL_GL_CALL(glGetError);
+            // The errors are reported when the calls are made, so there is nothing left to return here
+            return GL_NO_ERROR;
+        }
+
+        void GLAD_API_PTR null_glDebugMessageCallback(GLDEBUGPROC, const void*){
+            NULL_GL_CALL(glDebugMessageCallback);
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Pipeline state
+
+        void GLAD_API_PTR null_glEnable(GLenum capability){
+            NULL_GL_CALL(glEnable);
+            state.enabled.insert(capability);
+        }
+        void GLAD_API_PTR null_glDisable(GLenum capability){
+            NULL_GL_CALL(glDisable);
+            state.enabled.erase(capability);
+        }
+        GLboolean GLAD_API_PTR null_glIsEnabled(GLenum capability){
+            NULL_GL_CALL(glIsEnabled);
+            return state.enabled.count(capability) ? GL_TRUE : GL_FALSE;
+        }
+        void GLAD_API_PTR null_glViewport(GLint x, GLint y, GLsizei width, GLsizei height){
+            NULL_GL_CALL(glViewport);
+            if(width < 0 || height < 0) error(function, "Negative size");
+            state.viewport[0] = x; state.viewport[1] = y; state.viewport[2] = width; state.viewport[3] = height;
+        }
+        void GLAD_API_PTR null_glScissor(GLint x, GLint y, GLsizei width, GLsizei height){
+            NULL_GL_CALL(glScissor);
+            state.scissor[0] = x; state.scissor[1] = y; state.scissor[2] = width; state.scissor[3] = height;
+        }
+        void GLAD_API_PTR null_glClear(GLbitfield){
+            NULL_GL_CALL(glClear);
+        }
+        void GLAD_API_PTR null_glClearColor(GLfloat, GLfloat, GLfloat, GLfloat){
+            NULL_GL_CALL(glClearColor);
+        }
+        void GLAD_API_PTR null_glClearDepth(GLdouble){
+            NULL_GL_CALL(glClearDepth);
+        }
+        void GLAD_API_PTR null_glColorMask(GLboolean, GLboolean, GLboolean, GLboolean){
+            NULL_GL_CALL(glColorMask);
+        }
+        void GLAD_API_PTR null_glDepthMask(GLboolean){
+            NULL_GL_CALL(glDepthMask);
+        }
+        void GLAD_API_PTR null_glDepthFunc(GLenum){
+            NULL_GL_CALL(glDepthFunc);
+        }
+        void GLAD_API_PTR null_glCullFace(GLenum){
+            NULL_GL_CALL(glCullFace);
+        }
+        void GLAD_API_PTR null_glFrontFace(GLenum){
+            NULL_GL_CALL(glFrontFace);
+        }
+        void GLAD_API_PTR null_glPolygonMode(GLenum, GLenum mode){
+            NULL_GL_CALL(glPolygonMode);
+            state.polygonMode = mode;
+        }
+        void GLAD_API_PTR null_glBlendFunc(GLenum source, GLenum destination){
+            NULL_GL_CALL(glBlendFunc);
+            state.blendSourceRGB = state.blendSourceAlpha = source;
+            state.blendDestinationRGB = state.blendDestinationAlpha = destination;
+        }
+        void GLAD_API_PTR null_glBlendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha){
+            NULL_GL_CALL(glBlendFuncSeparate);
+            state.blendSourceRGB = sourceRGB; state.blendDestinationRGB = destinationRGB;
+            state.blendSourceAlpha = sourceAlpha; state.blendDestinationAlpha = destinationAlpha;
+        }
+        void GLAD_API_PTR null_glBlendEquation(GLenum mode){
+            NULL_GL_CALL(glBlendEquation);
+            state.blendEquationRGB = state.blendEquationAlpha = mode;
+        }
+        void GLAD_API_PTR null_glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha){
+            NULL_GL_CALL(glBlendEquationSeparate);
+            state.blendEquationRGB = modeRGB; state.blendEquationAlpha = modeAlpha;
+        }
+        void GLAD_API_PTR null_glBlendColor(GLfloat, GLfloat, GLfloat, GLfloat){
+            NULL_GL_CALL(glBlendColor);
+        }
+        void GLAD_API_PTR null_glClipControl(GLenum, GLenum){
+            NULL_GL_CALL(glClipControl);
+        }
+        void GLAD_API_PTR null_glPixelStorei(GLenum name, GLint value){
+            NULL_GL_CALL(glPixelStorei);
+            if(name != GL_PACK_ALIGNMENT && name != GL_UNPACK_ALIGNMENT) return;
+            if(value != 1 && value != 2 && value != 4 && value != 8){
+                error(function, "Invalid alignment " + std::to_string(value));
+                return;
+            }
+            if(name == GL_PACK_ALIGNMENT) state.packAlignment = value;
+            else if(name == GL_UNPACK_ALIGNMENT) state.unpackAlignment = value;
+        }
+        void GLAD_API_PTR null_glDrawBuffer(GLenum){
+            NULL_GL_CALL(glDrawBuffer);
+        }
+        void GLAD_API_PTR null_glFlush(){
+            NULL_GL_CALL(glFlush);
+        }
+        void GLAD_API_PTR null_glFinish(){
+            NULL_GL_CALL(glFinish);
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Buffers
+
+        void GLAD_API_PTR null_glGenBuffers(GLsizei count, GLuint* names){
+            NULL_GL_CALL(glGenBuffers);
+            generate(count, names, state.buffers);
+        }
+        void GLAD_API_PTR null_glDeleteBuffers(GLsizei count, const GLuint* names){
+            NULL_GL_CALL(glDeleteBuffers);
+            for(GLsizei index = 0; index < count; ++index){
+                if(names[index] == 0 || !state.buffers.erase(names[index])) continue;
+                // Deleting a bound buffer unbinds it
+                for(auto& [target, bound] : state.bufferBindings) if(bound == names[index]) bound = 0;
+                auto& vertexArray = state.vertexArrays[state.vertexArray];
+                if(vertexArray.elementBuffer == names[index]) vertexArray.elementBuffer = 0;
+            }
+        }
+        void GLAD_API_PTR null_glBindBuffer(GLenum target, GLuint buffer){
+            NULL_GL_CALL(glBindBuffer);
+            if(!checkName(function, state.buffers, buffer, "buffer")) return;
+            if(target == GL_ELEMENT_ARRAY_BUFFER) state.vertexArrays[state.vertexArray].elementBuffer = buffer;
+            else state.bufferBindings[target] = buffer;
+        }
+        void GLAD_API_PTR null_glBindBufferRange(GLenum target, GLuint, GLuint buffer, GLintptr offset, GLsizeiptr size){
+            NULL_GL_CALL(glBindBufferRange);
+            if(buffer == 0 || !checkName(function, state.buffers, buffer, "buffer")) return;
+            if(!checkRange(function, state.buffers[buffer], offset, size)) return;
+            if(target == GL_UNIFORM_BUFFER && offset % 256 != 0)
+                error(function, "The offset " + std::to_string(offset) + " isn't a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT");
+            // Binding to an indexed point binds to the generic point too
+            state.bufferBindings[target] = buffer;
+        }
+        void GLAD_API_PTR null_glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum){
+            NULL_GL_CALL(glBufferData);
+            BufferObject* buffer = boundBuffer(function, target);
+            if(!buffer) return;
+            if(buffer->immutable){
+                error(function, "The buffer is immutable");
+                return;
+            }
+            buffer->data.assign(size, 0);
+            if(data) std::memcpy(buffer->data.data(), data, size);
+            buffer->mapped = false;
+        }
+        void GLAD_API_PTR null_glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield){
+            NULL_GL_CALL(glBufferStorage);
+            BufferObject* buffer = boundBuffer(function, target);
+            if(!buffer) return;
+            if(buffer->immutable){
+                error(function, "The buffer is already immutable");
+                return;
+            }
+            buffer->immutable = true;
+            buffer->data.assign(size, 0);
+            if(data) std::memcpy(buffer->data.data(), data, size);
+        }
+        void GLAD_API_PTR null_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data){
+            NULL_GL_CALL(glBufferSubData);
+            BufferObject* buffer = boundBuffer(function, target);
+            if(!buffer || !checkRange(function, *buffer, offset, size)) return;
+            if(buffer->mapped && !(buffer->mapAccess & GL_MAP_PERSISTENT_BIT)){
+                error(function, "The buffer is mapped");
+                return;
+            }
+            std::memcpy(buffer->data.data() + offset, data, size);
+        }
+        void GLAD_API_PTR null_glGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void* data){
+            NULL_GL_CALL(glGetBufferSubData);
+            BufferObject* buffer = boundBuffer(function, target);
+            if(!buffer || !checkRange(function, *buffer, offset, size)) return;
+            std::memcpy(data, buffer->data.data() + offset, size);
+        }
+        void* GLAD_API_PTR null_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access){
+            NULL_GL_CALL(glMapBufferRange);
+            BufferObject* buffer = boundBuffer(function, target);
+            if(!buffer || !checkRange(function, *buffer, offset, length)) return nullptr;
+            if(buffer->mapped){
+                error(function, "The buffer is already mapped");
+                return nullptr;
+            }
+            buffer->mapped = true;
+            buffer->mapAccess = access;
+            // The model keeps the contents of the buffer, so the mapping is just a pointer into it
+            return buffer->data.data() + offset;
+        }
+        GLboolean GLAD_API_PTR null_glUnmapBuffer(GLenum target){
+            NULL_GL_CALL(glUnmapBuffer);
+            BufferObject* buffer = boundBuffer(function, target);
+            if(!buffer) return GL_FALSE;
+            if(!buffer->mapped){
+                error(function, "The buffer isn't mapped");
+                return GL_FALSE;
+            }
+            buffer->mapped = false;
+            return GL_TRUE;
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Vertex arrays
+
+        void GLAD_API_PTR null_glGenVertexArrays(GLsizei count, GLuint* names){
+            NULL_GL_CALL(glGenVertexArrays);
+            generate(count, names, state.vertexArrays);
+        }
+        void GLAD_API_PTR null_glDeleteVertexArrays(GLsizei count, const GLuint* names){
+            NULL_GL_CALL(glDeleteVertexArrays);
+            for(GLsizei index = 0; index < count; ++index){
+                if(names[index] == 0 || !state.vertexArrays.erase(names[index])) continue;
+                if(state.vertexArray == names[index]) state.vertexArray = 0;
+            }
+        }
+        void GLAD_API_PTR null_glBindVertexArray(GLuint vertexArray){
+            NULL_GL_CALL(glBindVertexArray);
+            if(checkName(function, state.vertexArrays, vertexArray, "vertex array")) state.vertexArray = vertexArray;
+        }
+        void GLAD_API_PTR null_glEnableVertexAttribArray(GLuint){
+            NULL_GL_CALL(glEnableVertexAttribArray);
+            if(state.vertexArray == 0) error(function, "No vertex array is bound");
+        }
+        void GLAD_API_PTR null_glVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*){
+            NULL_GL_CALL(glVertexAttribPointer);
+            if(state.vertexArray == 0) error(function, "No vertex array is bound");
+            else if(state.bufferBindings[GL_ARRAY_BUFFER] == 0) error(function, "No buffer is bound to GL_ARRAY_BUFFER");
+        }
+        void GLAD_API_PTR null_glVertexAttribDivisor(GLuint, GLuint){
+            NULL_GL_CALL(glVertexAttribDivisor);
+            if(state.vertexArray == 0) error(function, "No vertex array is bound");
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Textures & samplers
+
+        void GLAD_API_PTR null_glGenTextures(GLsizei count, GLuint* names){
+            NULL_GL_CALL(glGenTextures);
+            generate(count, names, state.textures);
+        }
+        void GLAD_API_PTR null_glDeleteTextures(GLsizei count, const GLuint* names){
+            NULL_GL_CALL(glDeleteTextures);
+            for(GLsizei index = 0; index < count; ++index){
+                if(names[index] == 0 || !state.textures.erase(names[index])) continue;
+                for(auto& unit : state.textureBindings)
+                    for(auto& [target, bound] : unit) if(bound == names[index]) bound = 0;
+            }
+        }
+        void GLAD_API_PTR null_glActiveTexture(GLenum unit){
+            NULL_GL_CALL(glActiveTexture);
+            if(unit < GL_TEXTURE0 || unit >= GL_TEXTURE0 + TEXTURE_UNITS){
+                error(function, "Invalid texture unit " + hex(unit));
+                return;
+            }
+            state.activeTexture = unit - GL_TEXTURE0;
+        }
+        void GLAD_API_PTR null_glBindTexture(GLenum target, GLuint texture){
+            NULL_GL_CALL(glBindTexture);
+            if(!checkName(function, state.textures, texture, "texture")) return;
+            if(texture != 0){
+                TextureObject& object = state.textures[texture];
+                if(object.target == 0) object.target = target;
+                else if(object.target != target){
+                    error(function, "The texture " + std::to_string(texture) + " was created for the target " + hex(object.target));
+                    return;
+                }
+            }
+            state.textureBindings[state.activeTexture][target] = texture;
+        }
+        void GLAD_API_PTR null_glTexImage2D(GLenum target, GLint level, GLint, GLsizei width, GLsizei height, GLint, GLenum, GLenum, const void*){
+            NULL_GL_CALL(glTexImage2D);
+            TextureObject* texture = boundTexture(function, target);
+            if(!texture) return;
+            if(texture->immutable){
+                error(function, "The texture is immutable");
+                return;
+            }
+            if(texture->levels.size() <= (std::size_t)level) texture->levels.resize(level + 1);
+            texture->levels[level] = {width, height, 1};
+        }
+        // Fills the mip chain of an immutable texture
+        void allocateLevels(const char* function, TextureObject* texture, GLsizei levels, glm::ivec3 size, bool array){
+            if(texture->immutable){
+                error(function, "The texture is already immutable");
+                return;
+            }
+            texture->immutable = true;
+            texture->levels.clear();
+            for(GLsizei level = 0; level < levels; ++level){
+                texture->levels.push_back(size);
+                size = glm::max(size / 2, glm::ivec3(1));
+                if(array) size.z = texture->levels[0].z;
+            }
+        }
+        void GLAD_API_PTR null_glTexStorage2D(GLenum target, GLsizei levels, GLenum, GLsizei width, GLsizei height){
+            NULL_GL_CALL(glTexStorage2D);
+            if(TextureObject* texture = boundTexture(function, target)) allocateLevels(function, texture, levels, {width, height, 1}, false);
+        }
+        void GLAD_API_PTR null_glTexStorage3D(GLenum target, GLsizei levels, GLenum, GLsizei width, GLsizei height, GLsizei depth){
+            NULL_GL_CALL(glTexStorage3D);
+            if(TextureObject* texture = boundTexture(function, target)) allocateLevels(function, texture, levels, {width, height, depth}, target == GL_TEXTURE_2D_ARRAY);
+        }
+        void GLAD_API_PTR null_glTexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, GLenum, GLenum, const void*){
+            NULL_GL_CALL(glTexSubImage3D);
+            TextureObject* texture = boundTexture(function, target);
+            if(!texture) return;
+            if(level < 0 || (std::size_t)level >= texture->levels.size()){
+                error(function, "The level " + std::to_string(level) + " wasn't allocated");
+                return;
+            }
+            glm::ivec3 size = texture->levels[level];
+            if(x < 0 || y < 0 || z < 0 || x + width > size.x || y + height > size.y || z + depth > size.z)
+                error(function, "The region is outside the level " + std::to_string(level));
+        }
+        void GLAD_API_PTR null_glTexParameteri(GLenum target, GLenum, GLint){
+            NULL_GL_CALL(glTexParameteri);
+            boundTexture(function, target);
+        }
+        void GLAD_API_PTR null_glGenerateMipmap(GLenum target){
+            NULL_GL_CALL(glGenerateMipmap);
+            TextureObject* texture = boundTexture(function, target);
+            if(!texture) return;
+            if(texture->levels.empty()){
+                error(function, "The texture has no base level");
+                return;
+            }
+            if(texture->immutable) return;
+            glm::ivec3 size = texture->levels[0];
+            texture->levels.resize(1);
+            while(size.x > 1 || size.y > 1){
+                size = glm::max(size / 2, glm::ivec3(1));
+                texture->levels.push_back(size);
+            }
+        }
+        void GLAD_API_PTR null_glGetTexLevelParameteriv(GLenum target, GLint level, GLenum name, GLint* value){
+            NULL_GL_CALL(glGetTexLevelParameteriv);
+            *value = 0;
+            TextureObject* texture = boundTexture(function, target);
+            if(!texture || level < 0 || (std::size_t)level >= texture->levels.size()) return;
+            switch(name){
+                case GL_TEXTURE_WIDTH: *value = texture->levels[level].x; break;
+                case GL_TEXTURE_HEIGHT: *value = texture->levels[level].y; break;
+                case GL_TEXTURE_DEPTH: *value = texture->levels[level].z; break;
+            }
+        }
+
+        void GLAD_API_PTR null_glGenSamplers(GLsizei count, GLuint* names){
+            NULL_GL_CALL(glGenSamplers);
+            generate(count, names, state.samplers);
+        }
+        void GLAD_API_PTR null_glDeleteSamplers(GLsizei count, const GLuint* names){
+            NULL_GL_CALL(glDeleteSamplers);
+            for(GLsizei index = 0; index < count; ++index){
+                if(names[index] == 0 || !state.samplers.erase(names[index])) continue;
+                for(auto& bound : state.samplerBindings) if(bound == names[index]) bound = 0;
+            }
+        }
+        void GLAD_API_PTR null_glBindSampler(GLuint unit, GLuint sampler){
+            NULL_GL_CALL(glBindSampler);
+            if(unit >= TEXTURE_UNITS){
+                error(function, "Invalid texture unit " + std::to_string(unit));
+                return;
+            }
+            if(checkName(function, state.samplers, sampler, "sampler")) state.samplerBindings[unit] = sampler;
+        }
+        void GLAD_API_PTR null_glSamplerParameteri(GLuint sampler, GLenum, GLint){
+            NULL_GL_CALL(glSamplerParameteri);
+            if(sampler == 0) error(function, "0 is not the name of a sampler");
+            else checkName(function, state.samplers, sampler, "sampler");
+        }
+        void GLAD_API_PTR null_glSamplerParameterf(GLuint sampler, GLenum, GLfloat){
+            NULL_GL_CALL(glSamplerParameterf);
+            if(sampler == 0) error(function, "0 is not the name of a sampler");
+            else checkName(function, state.samplers, sampler, "sampler");
+        }
+        void GLAD_API_PTR null_glSamplerParameterfv(GLuint sampler, GLenum, const GLfloat*){
+            NULL_GL_CALL(glSamplerParameterfv);
+            if(sampler == 0) error(function, "0 is not the name of a sampler");
+            else checkName(function, state.samplers, sampler, "sampler");
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Framebuffers & renderbuffers
+
+        void GLAD_API_PTR null_glGenFramebuffers(GLsizei count, GLuint* names){
+            NULL_GL_CALL(glGenFramebuffers);
+            generate(count, names, state.framebuffers);
+        }
+        void GLAD_API_PTR null_glDeleteFramebuffers(GLsizei count, const GLuint* names){
+            NULL_GL_CALL(glDeleteFramebuffers);
+            for(GLsizei index = 0; index < count; ++index){
+                if(names[index] == 0 || !state.framebuffers.erase(names[index])) continue;
+                if(state.drawFramebuffer == names[index]) state.drawFramebuffer = 0;
+                if(state.readFramebuffer == names[index]) state.readFramebuffer = 0;
+            }
+        }
+        void GLAD_API_PTR null_glBindFramebuffer(GLenum target, GLuint framebuffer){
+            NULL_GL_CALL(glBindFramebuffer);
+            if(!checkName(function, state.framebuffers, framebuffer, "framebuffer")) return;
+            if(target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER) state.drawFramebuffer = framebuffer;
+            if(target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER) state.readFramebuffer = framebuffer;
+        }
+        // Returns the framebuffer object bound to the target or reports an error (and returns null) if the default framebuffer is bound
+        FramebufferObject* boundFramebufferObject(const char* function, GLenum target){
+            GLuint name = boundFramebuffer(target);
+            if(name == 0){
+                error(function, "The default framebuffer can't have attachments");
+                return nullptr;
+            }
+            return &state.framebuffers[name];
+        }
+        void GLAD_API_PTR null_glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum, GLuint texture, GLint){
+            NULL_GL_CALL(glFramebufferTexture2D);
+            FramebufferObject* framebuffer = boundFramebufferObject(function, target);
+            if(framebuffer && checkName(function, state.textures, texture, "texture")) framebuffer->attachments[attachment] = texture;
+        }
+        void GLAD_API_PTR null_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum, GLuint renderbuffer){
+            NULL_GL_CALL(glFramebufferRenderbuffer);
+            FramebufferObject* framebuffer = boundFramebufferObject(function, target);
+            if(framebuffer && checkName(function, state.renderbuffers, renderbuffer, "renderbuffer")) framebuffer->attachments[attachment] = renderbuffer;
+        }
+        GLenum GLAD_API_PTR null_glCheckFramebufferStatus(GLenum target){
+            NULL_GL_CALL(glCheckFramebufferStatus);
+            GLuint name = boundFramebuffer(target);
+            if(name == 0) return GL_FRAMEBUFFER_COMPLETE;
+            for(auto& [attachment, object] : state.framebuffers[name].attachments)
+                if(object != 0) return GL_FRAMEBUFFER_COMPLETE;
+            return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
+        }
+
+        void GLAD_API_PTR null_glGenRenderbuffers(GLsizei count, GLuint* names){
+            NULL_GL_CALL(glGenRenderbuffers);
+            generate(count, names, state.renderbuffers);
+        }
+        void GLAD_API_PTR null_glDeleteRenderbuffers(GLsizei count, const GLuint* names){
+            NULL_GL_CALL(glDeleteRenderbuffers);
+            for(GLsizei index = 0; index < count; ++index){
+                if(names[index] == 0 || !state.renderbuffers.erase(names[index])) continue;
+                if(state.renderbuffer == names[index]) state.renderbuffer = 0;
+            }
+        }
+        void GLAD_API_PTR null_glBindRenderbuffer(GLenum, GLuint renderbuffer){
+            NULL_GL_CALL(glBindRenderbuffer);
+            if(checkName(function, state.renderbuffers, renderbuffer, "renderbuffer")) state.renderbuffer = renderbuffer;
+        }
+        void GLAD_API_PTR null_glRenderbufferStorage(GLenum, GLenum, GLsizei, GLsizei){
+            NULL_GL_CALL(glRenderbufferStorage);
+            if(state.renderbuffer == 0) error(function, "No renderbuffer is bound");
+        }
+
+        void GLAD_API_PTR null_glReadPixels(GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels){
+            NULL_GL_CALL(glReadPixels);
+            if(width <= 0 || height <= 0) return;
+            // Nothing was rendered, so the pixels are zeros. The rows are padded to the pack alignment like OpenGL would do.
+            GLsizei rowSize = width * pixelSize(format, type);
+            GLsizei stride = (rowSize + state.packAlignment - 1) / state.packAlignment * state.packAlignment;
+            std::size_t bytes = (std::size_t)stride * (height - 1) + rowSize;
+            // If a pixel pack buffer is bound, "pixels" is an offset into it
+            if(state.bufferBindings[GL_PIXEL_PACK_BUFFER] != 0){
+                BufferObject& buffer = state.buffers[state.bufferBindings[GL_PIXEL_PACK_BUFFER]];
+                if(checkRange(function, buffer, (GLintptr)pixels, bytes)) std::memset(buffer.data.data() + (GLintptr)pixels, 0, bytes);
+                return;
+            }
+            std::memset(pixels, 0, bytes);
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Shaders & programs
+
+        // The only reason a shader can fail to compile here
+        constexpr const char* NO_SOURCE_LOG = "The shader has no source\n";
+
+        GLuint GLAD_API_PTR null_glCreateShader(GLenum type){
+            NULL_GL_CALL(glCreateShader);
+            GLuint name = state.nextName++;
+            state.shaders[name].type = type;
+            return name;
+        }
+        // Deletes the shader unless a program still holds it (then it is deleted once it is detached)
+        void releaseShader(GLuint shader){
+            auto it = state.shaders.find(shader);
+            if(it == state.shaders.end() || !it->second.deletePending) return;
+            for(auto& [name, program] : state.programs)
+                if(std::find(program.shaders.begin(), program.shaders.end(), shader) != program.shaders.end()) return;
+            state.shaders.erase(it);
+        }
+        void GLAD_API_PTR null_glDeleteShader(GLuint shader){
+            NULL_GL_CALL(glDeleteShader);
+            auto it = state.shaders.find(shader);
+            if(it == state.shaders.end()) return;
+            it->second.deletePending = true;
+            releaseShader(shader);
+        }
+        void GLAD_API_PTR null_glShaderSource(GLuint shader, GLsizei, const GLchar* const*, const GLint*){
+            NULL_GL_CALL(glShaderSource);
+            if(shader == 0) error(function, "0 is not the name of a shader");
+            else if(checkName(function, state.shaders, shader, "shader")) state.shaders[shader].hasSource = true;
+        }
+        void GLAD_API_PTR null_glCompileShader(GLuint shader){
+            NULL_GL_CALL(glCompileShader);
+            if(shader == 0 || !checkName(function, state.shaders, shader, "shader")) return;
+            ShaderObject& object = state.shaders[shader];
+            if(!object.hasSource) error(function, "The shader " + std::to_string(shader) + " has no source");
+            object.compiled = object.hasSource;
+        }
+        void GLAD_API_PTR null_glGetShaderiv(GLuint shader, GLenum name, GLint* value){
+            NULL_GL_CALL(glGetShaderiv);
+            *value = 0;
+            auto it = state.shaders.find(shader);
+            if(it == state.shaders.end()){
+                error(function, std::to_string(shader) + " is not the name of a shader");
+                return;
+            }
+            if(name == GL_COMPILE_STATUS) *value = it->second.compiled ? GL_TRUE : GL_FALSE;
+            else if(name == GL_INFO_LOG_LENGTH) *value = it->second.compiled ? 0 : (GLint)std::strlen(NO_SOURCE_LOG) + 1;
+            else if(name == GL_SHADER_TYPE) *value = it->second.type;
+        }
+        void GLAD_API_PTR null_glGetShaderInfoLog(GLuint shader, GLsizei size, GLsizei* length, GLchar* log){
+            NULL_GL_CALL(glGetShaderInfoLog);
+            auto it = state.shaders.find(shader);
+            std::string text = it == state.shaders.end() || it->second.compiled ? "" : NO_SOURCE_LOG;
+            GLsizei written = size > 0 ? std::min((GLsizei)text.size(), size - 1) : 0;
+            if(size > 0){
+                std::memcpy(log, text.data(), written);
+                log[written] = '\0';
+            }
+            if(length) *length = written;
+        }
+
+        GLuint GLAD_API_PTR null_glCreateProgram(){
+            NULL_GL_CALL(glCreateProgram);
+            GLuint name = state.nextName++;
+            state.programs[name];
+            return name;
+        }
+        void GLAD_API_PTR null_glDeleteProgram(GLuint program){
+            NULL_GL_CALL(glDeleteProgram);
+            // Like OpenGL, the program in use stays usable until another one is used (so the locations are kept too)
+            auto it = state.programs.find(program);
+            if(it == state.programs.end()) return;
+            std::vector<GLuint> shaders = std::move(it->second.shaders);
+            state.programs.erase(it);
+            for(GLuint shader : shaders) releaseShader(shader);
+        }
+        void GLAD_API_PTR null_glAttachShader(GLuint program, GLuint shader){
+            NULL_GL_CALL(glAttachShader);
+            if(program == 0 || shader == 0 || !checkName(function, state.programs, program, "program") || !checkName(function, state.shaders, shader, "shader")){
+                if(program == 0 || shader == 0) error(function, "0 is not the name of a program or a shader");
+                return;
+            }
+            auto& shaders = state.programs[program].shaders;
+            if(state.shaders[shader].deletePending){
+                error(function, "The shader " + std::to_string(shader) + " was deleted");
+                return;
+            }
+            if(std::find(shaders.begin(), shaders.end(), shader) != shaders.end()){
+                error(function, "The shader " + std::to_string(shader) + " is already attached");
+                return;
+            }
+            shaders.push_back(shader);
+        }
+        void GLAD_API_PTR null_glDetachShader(GLuint program, GLuint shader){
+            NULL_GL_CALL(glDetachShader);
+            if(program == 0 || !checkName(function, state.programs, program, "program")) return;
+            auto& shaders = state.programs[program].shaders;
+            auto it = std::find(shaders.begin(), shaders.end(), shader);
+            if(it == shaders.end()){
+                error(function, "The shader " + std::to_string(shader) + " isn't attached");
+                return;
+            }
+            shaders.erase(it);
+            releaseShader(shader);
+        }
+        void GLAD_API_PTR null_glLinkProgram(GLuint program){
+            NULL_GL_CALL(glLinkProgram);
+            if(program == 0 || !checkName(function, state.programs, program, "program")) return;
+            ProgramObject& object = state.programs[program];
+            // The link fails (without an error, like OpenGL) if any stage is missing or didn't compile
+            object.linked = !object.shaders.empty();
+            object.log = object.linked ? "" : "No shader is attached\n";
+            for(GLuint shader : object.shaders){
+                if(!state.shaders[shader].compiled){
+                    object.linked = false;
+                    object.log = "The shader " + std::to_string(shader) + " isn't compiled\n";
+                }
+            }
+        }
+        void GLAD_API_PTR null_glGetProgramiv(GLuint program, GLenum name, GLint* value){
+            NULL_GL_CALL(glGetProgramiv);
+            *value = 0;
+            auto it = state.programs.find(program);
+            if(it == state.programs.end()){
+                error(function, std::to_string(program) + " is not the name of a program");
+                return;
+            }
+            if(name == GL_LINK_STATUS) *value = it->second.linked ? GL_TRUE : GL_FALSE;
+            else if(name == GL_ATTACHED_SHADERS) *value = (GLint)it->second.shaders.size();
+            else if(name == GL_INFO_LOG_LENGTH) *value = it->second.log.empty() ? 0 : (GLint)it->second.log.size() + 1;
+        }
+        void GLAD_API_PTR null_glGetProgramInfoLog(GLuint program, GLsizei size, GLsizei* length, GLchar* log){
+            NULL_GL_CALL(glGetProgramInfoLog);
+            auto it = state.programs.find(program);
+            std::string text = it == state.programs.end() ? "" : it->second.log;
+            GLsizei written = size > 0 ? std::min((GLsizei)text.size(), size - 1) : 0;
+            if(size > 0){
+                std::memcpy(log, text.data(), written);
+                log[written] = '\0';
+            }
+            if(length) *length = written;
+        }
+        void GLAD_API_PTR null_glUseProgram(GLuint program){
+            NULL_GL_CALL(glUseProgram);
+            if(!checkName(function, state.programs, program, "program")) return;
+            if(program != 0 && !state.programs[program].linked){
+                error(function, "The program " + std::to_string(program) + " isn't linked");
+                return;
+            }
+            state.program = program;
+        }
+        // Returns the linked program or reports an error (and returns null)
+        ProgramObject* linkedProgram(const char* function, GLuint program){
+            auto it = state.programs.find(program);
+            if(it == state.programs.end() || !it->second.linked){
+                error(function, std::to_string(program) + " is not the name of a linked program");
+                return nullptr;
+            }
+            return &it->second;
+        }
+        GLint GLAD_API_PTR null_glGetUniformLocation(GLuint program, const GLchar* name){
+            NULL_GL_CALL(glGetUniformLocation);
+            ProgramObject* object = linkedProgram(function, program);
+            if(!object) return -1;
+            auto [it, inserted] = object->uniforms.try_emplace(name, state.nextUniformLocation);
+            if(inserted) state.uniformOwners[state.nextUniformLocation++] = program;
+            return it->second;
+        }
+        void GLAD_API_PTR null_glGetActiveUniform(GLuint program, GLuint index, GLsizei, GLsizei*, GLint*, GLenum*, GLchar*){
+            NULL_GL_CALL(glGetActiveUniform);
+            if(!linkedProgram(function, program)) return;
+            // Nothing is compiled, so no uniform is known to be active (GL_ACTIVE_UNIFORMS is 0) and every index is out of range
+            error(function, "The index " + std::to_string(index) + " is not the index of an active uniform");
+        }
+        GLint GLAD_API_PTR null_glGetAttribLocation(GLuint program, const GLchar* name){
+            NULL_GL_CALL(glGetAttribLocation);
+            ProgramObject* object = linkedProgram(function, program);
+            if(!object) return -1;
+            return object->attributes.try_emplace(name, (GLint)object->attributes.size()).first->second;
+        }
+        GLuint GLAD_API_PTR null_glGetUniformBlockIndex(GLuint program, const GLchar* name){
+            NULL_GL_CALL(glGetUniformBlockIndex);
+            ProgramObject* object = linkedProgram(function, program);
+            if(!object) return GL_INVALID_INDEX;
+            return object->blocks.try_emplace(name, (GLuint)object->blocks.size()).first->second;
+        }
+        void GLAD_API_PTR null_glUniformBlockBinding(GLuint program, GLuint index, GLuint){
+            NULL_GL_CALL(glUniformBlockBinding);
+            ProgramObject* object = linkedProgram(function, program);
+            if(object && index >= object->blocks.size()) error(function, "Invalid uniform block index " + std::to_string(index));
+        }
+
+        void GLAD_API_PTR null_glUniform1i(GLint location, GLint){
+            NULL_GL_CALL(glUniform1i);
+            checkUniform(function, location);
+        }
+        void GLAD_API_PTR null_glUniform1ui(GLint location, GLuint){
+            NULL_GL_CALL(glUniform1ui);
+            checkUniform(function, location);
+        }
+        void GLAD_API_PTR null_glUniform1f(GLint location, GLfloat){
+            NULL_GL_CALL(glUniform1f);
+            checkUniform(function, location);
+        }
+        void GLAD_API_PTR null_glUniform2f(GLint location, GLfloat, GLfloat){
+            NULL_GL_CALL(glUniform2f);
+            checkUniform(function, location);
+        }
+        void GLAD_API_PTR null_glUniform3f(GLint location, GLfloat, GLfloat, GLfloat){
+            NULL_GL_CALL(glUniform3f);
+            checkUniform(function, location);
+        }
+        void GLAD_API_PTR null_glUniform4f(GLint location, GLfloat, GLfloat, GLfloat, GLfloat){
+            NULL_GL_CALL(glUniform4f);
+            checkUniform(function, location);
+        }
+        void GLAD_API_PTR null_glUniformMatrix4fv(GLint location, GLsizei, GLboolean, const GLfloat*){
+            NULL_GL_CALL(glUniformMatrix4fv);
+            checkUniform(function, location);
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Draw calls
+
+        void GLAD_API_PTR null_glDrawArrays(GLenum, GLint, GLsizei){
+            NULL_GL_CALL(glDrawArrays);
+            checkDraw(function);
+        }
+        void GLAD_API_PTR null_glDrawArraysInstanced(GLenum, GLint, GLsizei, GLsizei){
+            NULL_GL_CALL(glDrawArraysInstanced);
+            checkDraw(function);
+        }
+        // The indexed draws also need an element buffer that holds the indices
+        void checkIndexedDraw(const char* function, GLsizei count, GLenum type, const void* indices){
+            if(!checkDraw(function)) return;
+            GLuint name = state.vertexArrays[state.vertexArray].elementBuffer;
+            if(name == 0){
+                error(function, "No element buffer is bound to the vertex array " + std::to_string(state.vertexArray));
+                return;
+            }
+            GLsizeiptr indexSize = type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4;
+            checkRange(function, state.buffers[name], (GLintptr)indices, count * indexSize);
+        }
+        void GLAD_API_PTR null_glDrawElements(GLenum, GLsizei count, GLenum type, const void* indices){
+            NULL_GL_CALL(glDrawElements);
+            checkIndexedDraw(function, count, type, indices);
+        }
+        void GLAD_API_PTR null_glDrawElementsInstanced(GLenum, GLsizei count, GLenum type, const void* indices, GLsizei){
+            NULL_GL_CALL(glDrawElementsInstanced);
+            checkIndexedDraw(function, count, type, indices);
+        }
+        void GLAD_API_PTR null_glDrawElementsBaseVertex(GLenum, GLsizei count, GLenum type, const void* indices, GLint){
+            NULL_GL_CALL(glDrawElementsBaseVertex);
+            checkIndexedDraw(function, count, type, indices);
+        }
+
+        // ------------------------------------------------------------------------------------------------------------------------
+        // Queries & syncs
+
+        void GLAD_API_PTR null_glGenQueries(GLsizei count, GLuint* names){
+            NULL_GL_CALL(glGenQueries);
+            generate(count, names, state.queries);
+        }
+        void GLAD_API_PTR null_glDeleteQueries(GLsizei count, const GLuint* names){
+            NULL_GL_CALL(glDeleteQueries);
+            for(GLsizei index = 0; index < count; ++index) state.queries.erase(names[index]);
+        }
+        void GLAD_API_PTR null_glQueryCounter(GLuint query, GLenum){
+            NULL_GL_CALL(glQueryCounter);
+            if(query == 0) error(function, "0 is not the name of a query");
+            else checkName(function, state.queries, query, "query");
+        }
+        // The results are always available and all the timestamps are zeros (so the GPU timings read as zeros)
+        void GLAD_API_PTR null_glGetQueryObjectiv(GLuint query, GLenum name, GLint* value){
+            NULL_GL_CALL(glGetQueryObjectiv);
+            checkName(function, state.queries, query, "query");
+            *value = name == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+        }
+        void GLAD_API_PTR null_glGetQueryObjectui64v(GLuint query, GLenum, GLuint64* value){
+            NULL_GL_CALL(glGetQueryObjectui64v);
+            checkName(function, state.queries, query, "query");
+            *value = 0;
+        }
+
+        GLsync GLAD_API_PTR null_glFenceSync(GLenum, GLbitfield){
+            NULL_GL_CALL(glFenceSync);
+            state.syncs.insert(state.nextSync);
+            return reinterpret_cast<GLsync>(state.nextSync++);
+        }
+        // Since nothing runs on a GPU, every fence is signaled as soon as it is created
+        GLenum GLAD_API_PTR null_glClientWaitSync(GLsync sync, GLbitfield, GLuint64){
+            NULL_GL_CALL(glClientWaitSync);
+            if(!state.syncs.count(reinterpret_cast<std::uintptr_t>(sync))){
+                error(function, "Invalid sync object");
+                return GL_WAIT_FAILED;
+            }
+            return GL_ALREADY_SIGNALED;
+        }
+        void GLAD_API_PTR null_glDeleteSync(GLsync sync){
+            NULL_GL_CALL(glDeleteSync);
+            if(sync && !state.syncs.erase(reinterpret_cast<std::uintptr_t>(sync))) error(function, "Invalid sync object");
+        }
+
+        #undef NULL_GL_CALL
+
+        // The functions we give to glad. Every other function is loaded as null, so calling it crashes right away
+        // (if the engine starts using a new function, it must be added here).
+        #define NULL_GL_ENTRY(name) {#name, reinterpret_cast<GLADapiproc>(&null_##name)}
+        const std::unordered_map<std::string, GLADapiproc> STUBS = {
+            NULL_GL_ENTRY(glGetString), NULL_GL_ENTRY(glGetStringi), NULL_GL_ENTRY(glGetIntegerv), NULL_GL_ENTRY(glGetError),
+            NULL_GL_ENTRY(glDebugMessageCallback),
+            NULL_GL_ENTRY(glEnable), NULL_GL_ENTRY(glDisable), NULL_GL_ENTRY(glIsEnabled), NULL_GL_ENTRY(glViewport), NULL_GL_ENTRY(glScissor),
+            NULL_GL_ENTRY(glClear), NULL_GL_ENTRY(glClearColor), NULL_GL_ENTRY(glClearDepth), NULL_GL_ENTRY(glColorMask),
+            NULL_GL_ENTRY(glDepthMask), NULL_GL_ENTRY(glDepthFunc), NULL_GL_ENTRY(glCullFace), NULL_GL_ENTRY(glFrontFace),
+            NULL_GL_ENTRY(glPolygonMode), NULL_GL_ENTRY(glBlendFunc), NULL_GL_ENTRY(glBlendFuncSeparate), NULL_GL_ENTRY(glBlendEquation),
+            NULL_GL_ENTRY(glBlendEquationSeparate), NULL_GL_ENTRY(glBlendColor), NULL_GL_ENTRY(glClipControl), NULL_GL_ENTRY(glPixelStorei),
+            NULL_GL_ENTRY(glDrawBuffer), NULL_GL_ENTRY(glFlush), NULL_GL_ENTRY(glFinish),
+            NULL_GL_ENTRY(glGenBuffers), NULL_GL_ENTRY(glDeleteBuffers), NULL_GL_ENTRY(glBindBuffer), NULL_GL_ENTRY(glBindBufferRange),
+            NULL_GL_ENTRY(glBufferData), NULL_GL_ENTRY(glBufferStorage), NULL_GL_ENTRY(glBufferSubData), NULL_GL_ENTRY(glGetBufferSubData),
+            NULL_GL_ENTRY(glMapBufferRange), NULL_GL_ENTRY(glUnmapBuffer),
+            NULL_GL_ENTRY(glGenVertexArrays), NULL_GL_ENTRY(glDeleteVertexArrays), NULL_GL_ENTRY(glBindVertexArray),
+            NULL_GL_ENTRY(glEnableVertexAttribArray), NULL_GL_ENTRY(glVertexAttribPointer), NULL_GL_ENTRY(glVertexAttribDivisor),
+            NULL_GL_ENTRY(glGenTextures), NULL_GL_ENTRY(glDeleteTextures), NULL_GL_ENTRY(glActiveTexture), NULL_GL_ENTRY(glBindTexture),
+            NULL_GL_ENTRY(glTexImage2D), NULL_GL_ENTRY(glTexStorage2D), NULL_GL_ENTRY(glTexStorage3D), NULL_GL_ENTRY(glTexSubImage3D),
+            NULL_GL_ENTRY(glTexParameteri), NULL_GL_ENTRY(glGenerateMipmap), NULL_GL_ENTRY(glGetTexLevelParameteriv),
+            NULL_GL_ENTRY(glGenSamplers), NULL_GL_ENTRY(glDeleteSamplers), NULL_GL_ENTRY(glBindSampler), NULL_GL_ENTRY(glSamplerParameteri),
+            NULL_GL_ENTRY(glSamplerParameterf), NULL_GL_ENTRY(glSamplerParameterfv),
+            NULL_GL_ENTRY(glGenFramebuffers), NULL_GL_ENTRY(glDeleteFramebuffers), NULL_GL_ENTRY(glBindFramebuffer),
+            NULL_GL_ENTRY(glFramebufferTexture2D), NULL_GL_ENTRY(glFramebufferRenderbuffer), NULL_GL_ENTRY(glCheckFramebufferStatus),
+            NULL_GL_ENTRY(glGenRenderbuffers), NULL_GL_ENTRY(glDeleteRenderbuffers), NULL_GL_ENTRY(glBindRenderbuffer),
+            NULL_GL_ENTRY(glRenderbufferStorage), NULL_GL_ENTRY(glReadPixels),
+            NULL_GL_ENTRY(glCreateShader), NULL_GL_ENTRY(glDeleteShader), NULL_GL_ENTRY(glShaderSource), NULL_GL_ENTRY(glCompileShader),
+            NULL_GL_ENTRY(glGetShaderiv), NULL_GL_ENTRY(glGetShaderInfoLog), NULL_GL_ENTRY(glCreateProgram), NULL_GL_ENTRY(glDeleteProgram),
+            NULL_GL_ENTRY(glAttachShader), NULL_GL_ENTRY(glDetachShader), NULL_GL_ENTRY(glLinkProgram), NULL_GL_ENTRY(glGetProgramiv),
+            NULL_GL_ENTRY(glGetProgramInfoLog), NULL_GL_ENTRY(glUseProgram), NULL_GL_ENTRY(glGetUniformLocation),
+            NULL_GL_ENTRY(glGetActiveUniform), NULL_GL_ENTRY(glGetAttribLocation), NULL_GL_ENTRY(glGetUniformBlockIndex), NULL_GL_ENTRY(glUniformBlockBinding),
+            NULL_GL_ENTRY(glUniform1i), NULL_GL_ENTRY(glUniform1ui), NULL_GL_ENTRY(glUniform1f), NULL_GL_ENTRY(glUniform2f),
+            NULL_GL_ENTRY(glUniform3f), NULL_GL_ENTRY(glUniform4f), NULL_GL_ENTRY(glUniformMatrix4fv),
+            NULL_GL_ENTRY(glDrawArrays), NULL_GL_ENTRY(glDrawArraysInstanced), NULL_GL_ENTRY(glDrawElements),
+            NULL_GL_ENTRY(glDrawElementsInstanced), NULL_GL_ENTRY(glDrawElementsBaseVertex),
+            NULL_GL_ENTRY(glGenQueries), NULL_GL_ENTRY(glDeleteQueries), NULL_GL_ENTRY(glQueryCounter),
+            NULL_GL_ENTRY(glGetQueryObjectiv), NULL_GL_ENTRY(glGetQueryObjectui64v),
+            NULL_GL_ENTRY(glFenceSync), NULL_GL_ENTRY(glClientWaitSync), NULL_GL_ENTRY(glDeleteSync),
+        };
+        #undef NULL_GL_ENTRY
+
+        GLADapiproc loadStub(const char* name){
+            auto it = STUBS.find(name);
+            return it == STUBS.end() ? nullptr : it->second;
+        }
+
+        // Forgets every object & binding (the call counters are kept since they identify the functions by index)
+        void resetModel(glm::ivec2 size){
+            std::vector<std::string> functionNames = std::move(state.functionNames);
+            std::vector<std::uint64_t> calls(functionNames.size(), 0);
+            state = State();
+            state.functionNames = std::move(functionNames);
+            state.calls = std::move(calls);
+            state.vertexArrays[0];
+            state.viewport[2] = state.scissor[2] = size.x;
+            state.viewport[3] = state.scissor[3] = size.y;
+        }
+
+    }
+
+    bool NullContext::create(glm::ivec2 size){
+        this->size = size;
+        resetModel(size);
+        if(!gladLoadGL(loadStub)){
+            std::cerr << "Failed to load the null OpenGL functions" << std::endl;
+            return false;
+        }
+        created = true;
+        return true;
+    }
+
+    void NullContext::destroy(bool report){
+        if(!created) return;
+        if(report) printReport(std::cout);
+        resetModel(size);
+        created = false;
+    }
+
+    NullContext::Statistics NullContext::getStatistics(){
+        Statistics statistics;
+        statistics.drawCalls = state.drawCalls;
+        statistics.errors = state.errors;
+        for(std::size_t index = 0; index < state.calls.size(); ++index){
+            statistics.calls += state.calls[index];
+            if(state.calls[index] > 0) statistics.functions.push_back({state.functionNames[index], state.calls[index]});
+        }
+        std::sort(statistics.functions.begin(), statistics.functions.end(), [](const FunctionCalls& first, const FunctionCalls& second){
+            return first.calls > second.calls;
+        });
+        // The vertex array 0 is a part of the model, not an object the engine created
+        statistics.liveObjects = state.buffers.size() + state.textures.size() + (state.vertexArrays.size() - 1) + state.framebuffers.size() +
+            state.renderbuffers.size() + state.samplers.size() + state.queries.size() + state.shaders.size() + state.programs.size() + state.syncs.size();
+        return statistics;
+    }
+
+    void NullContext::resetCounters(){
+        std::fill(state.calls.begin(), state.calls.end(), 0);
+        state.drawCalls = 0;
+    }
+
+    void NullContext::printReport(std::ostream& stream){
+        Statistics statistics = getStatistics();
+        stream << "Null GL: " << statistics.calls << " calls, " << statistics.drawCalls << " draw calls, " << statistics.errors << " errors" << std::endl;
+        // The most called functions are usually where the CPU time goes
+        constexpr std::size_t TOP_FUNCTIONS = 15;
+        for(std::size_t index = 0; index < std::min(TOP_FUNCTIONS, statistics.functions.size()); ++index)
+            stream << "    " << std::setw(28) << std::left << statistics.functions[index].name << std::right << statistics.functions[index].calls << std::endl;
+        if(statistics.liveObjects > 0){
+            stream << "Null GL: Objects that were never deleted: " << state.buffers.size() << " buffers, " << state.textures.size() << " textures, " <<
+                state.vertexArrays.size() - 1 << " vertex arrays, " << state.framebuffers.size() << " framebuffers, " << state.renderbuffers.size() << " renderbuffers, " <<
+                state.samplers.size() << " samplers, " << state.queries.size() << " queries, " << state.shaders.size() << " shaders, " <<
+                state.programs.size() << " programs, " << state.syncs.size() << " syncs" << std::endl;
+        }
+    }
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace our {
+
+    // A fake OpenGL "driver" that lets the engine run without any GPU or display, so the CPU side of the renderer
+    // (ECS iteration, command building & sorting, uniform marshalling, ...) can be measured without a driver in the loop.
+    // Instead of loading the functions of a real driver, glad is given stubs that keep a tiny model of the OpenGL state:
+    // the objects that were generated (with fake names), what is bound where, the linked programs & their uniform locations
+    // and the contents of the buffers (so that mapping and reading back a buffer still work). Nothing is ever drawn.
+    // The model is used to validate the calls (e.g. binding a deleted object, drawing without a program, setting a uniform
+    // location of another program) and every call is counted per function. The errors are printed as they are found
+    // and a report of the counters (and of the objects that were never deleted) is printed when the context is destroyed.
+    // The shaders are never compiled, so every shader compiles, every program links and every uniform name has a location.
+    class NullContext {
+    public:
+        // How many times a function was called
+        struct FunctionCalls {
+            std::string name;
+            std::uint64_t calls = 0;
+        };
+
+        struct Statistics {
+            std::uint64_t calls = 0;        // The calls of all the functions
+            std::uint64_t drawCalls = 0;
+            std::uint64_t errors = 0;       // The calls that failed the validation
+            std::uint64_t liveObjects = 0;  // The objects that were generated and not deleted yet
+            std::vector<FunctionCalls> functions; // Sorted from the most called to the least called
+        };
+
+    private:
+        glm::ivec2 size = {0, 0};
+        bool created = false;
+
+    public:
+        // Loads the stubs into glad and resets the model & the counters. The size is the size of the fake default framebuffer.
+        bool create(glm::ivec2 size);
+        // Prints the report (unless asked not to) and forgets the model. The OpenGL functions must not be called after this.
+        void destroy(bool report = true);
+
+        // Changes the size of the fake default framebuffer
+        void resize(glm::ivec2 size){ this->size = size; }
+        glm::ivec2 getSize() const { return size; }
+
+        // Returns the counters since the context was created (or since the last reset)
+        static Statistics getStatistics();
+        // Zeroes the call counters (e.g. to skip the loading when measuring the frames). The objects are kept.
+        static void resetCounters();
+        // Writes the counters and the live objects in a human readable form
+        static void printReport(std::ostream& stream);
+    };
+
+}
@@ -0,0 +1,200 @@
+#include "state-cache.hpp"
+
+namespace our {
+
+    GLStateCache& GLStateCache::current(){
+        static GLStateCache cache;
+        return cache;
+    }
+
+    void GLStateCache::invalidate(){
+        // Mark every shadowed value as invalid while keeping the counters intact
+        for(auto* shadow : {&cullFaceEnabled, &depthTestEnabled, &blendEnabled, &depthMask}) shadow->valid = false;
+        for(auto* shadow : {&culledFace, &frontFace, &depthFunction, &blendEquation}) shadow->valid = false;
+        for(auto* shadow : {&program, &vertexArray, &drawFramebuffer, &readFramebuffer, &activeTextureUnit}) shadow->valid = false;
+        for(auto& shadow : textures2D) shadow.valid = false;
+        for(auto& shadow : textures2DArray) shadow.valid = false;
+        for(auto& shadow : samplers) shadow.valid = false;
+        for(auto& shadow : uniformBuffers) shadow.valid = false;
+        blendFunction.valid = blendColor.valid = colorMask.valid = false;
+        clearColor.valid = clearDepth.valid = false;
+    }
+
+    void GLStateCache::restoreDefaults(){
+        // The calls go straight to OpenGL since the shadow copy may be out of sync (which is why this is called)
+        glDisable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+        glFrontFace(GL_CCW);
+        glDisable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDisable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_ONE, GL_ZERO);
+        glBlendColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClearDepth(1.0f);
+        glUseProgram(0);
+        glBindVertexArray(0);
+        for(GLuint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit){
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            glBindSampler(unit, 0);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        invalidate();
+    }
+
+    bool GLStateCache::setCapability(GLenum capability, Shadowed<bool>& shadow, bool enabled){
+        if(count(shadow.update(enabled))){
+            if(enabled) glEnable(capability); else glDisable(capability);
+        }
+        return enabled;
+    }
+
+    void GLStateCache::setFaceCulling(bool enabled, GLenum culledFace, GLenum frontFace){
+        // Similar to the original pipeline setup, the face & winding are only sent if culling is enabled
+        if(setCapability(GL_CULL_FACE, cullFaceEnabled, enabled)){
+            if(count(this->culledFace.update(culledFace))) glCullFace(culledFace);
+            if(count(this->frontFace.update(frontFace))) glFrontFace(frontFace);
+        }
+    }
+
+    void GLStateCache::setDepthTesting(bool enabled, GLenum function){
+        if(setCapability(GL_DEPTH_TEST, depthTestEnabled, enabled)){
+            if(count(depthFunction.update(function))) glDepthFunc(function);
+        }
+    }
+
+    void GLStateCache::setBlending(bool enabled, GLenum equation, GLenum sourceFactor, GLenum destinationFactor, glm::vec4 constantColor){
+        if(setCapability(GL_BLEND, blendEnabled, enabled)){
+            if(count(blendEquation.update(equation))) glBlendEquation(equation);
+            if(count(blendFunction.update({sourceFactor, destinationFactor}))) glBlendFunc(sourceFactor, destinationFactor);
+            if(count(blendColor.update(constantColor)))
+                glBlendColor(constantColor.r, constantColor.g, constantColor.b, constantColor.a);
+        }
+    }
+
+    void GLStateCache::setColorMask(glm::bvec4 mask){
+        if(count(colorMask.update(mask))) glColorMask(mask.r, mask.g, mask.b, mask.a);
+    }
+
+    void GLStateCache::setDepthMask(bool mask){
+        if(count(depthMask.update(mask))) glDepthMask(mask);
+    }
+
+    void GLStateCache::setClearColor(glm::vec4 color){
+        if(count(clearColor.update(color))) glClearColor(color.r, color.g, color.b, color.a);
+    }
+
+    void GLStateCache::setClearDepth(GLfloat depth){
+        if(count(clearDepth.update(depth))) glClearDepth(depth);
+    }
+
+    void GLStateCache::useProgram(GLuint name){
+        if(count(program.update(name))) glUseProgram(name);
+    }
+
+    void GLStateCache::bindVertexArray(GLuint name){
+        if(count(vertexArray.update(name))) glBindVertexArray(name);
+    }
+
+    void GLStateCache::bindFramebuffer(GLenum target, GLuint name){
+        if(name == 0) name = defaultFramebuffer;
+        // GL_FRAMEBUFFER binds both the draw and the read framebuffers, so we only skip it if both are already bound
+        if(target == GL_FRAMEBUFFER){
+            bool issue = drawFramebuffer.update(name);
+            issue = readFramebuffer.update(name) || issue;
+            if(count(issue)) glBindFramebuffer(GL_FRAMEBUFFER, name);
+        } else if(target == GL_DRAW_FRAMEBUFFER){
+            if(count(drawFramebuffer.update(name))) glBindFramebuffer(GL_DRAW_FRAMEBUFFER, name);
+        } else {
+            if(count(readFramebuffer.update(name))) glBindFramebuffer(GL_READ_FRAMEBUFFER, name);
+        }
+    }
+
+    void GLStateCache::activeTexture(GLuint unit){
+        if(count(activeTextureUnit.update(unit))) glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    GLStateCache::Shadowed<GLuint>* GLStateCache::textureShadow(GLuint unit, GLenum target){
+        if(unit >= MAX_TEXTURE_UNITS) return nullptr;
+        if(target == GL_TEXTURE_2D) return &textures2D[unit];
+        if(target == GL_TEXTURE_2D_ARRAY) return &textures2DArray[unit];
+        return nullptr;
+    }
+
+    void GLStateCache::bindTexture(GLenum target, GLuint name){
+        // If we don't know which unit is active, we cannot know what is bound to it
+        Shadowed<GLuint>* shadow = activeTextureUnit.valid ? textureShadow(activeTextureUnit.value, target) : nullptr;
+        if(shadow == nullptr){
+            count(true);
+            glBindTexture(target, name);
+            return;
+        }
+        if(count(shadow->update(name))) glBindTexture(target, name);
+    }
+
+    void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint name){
+        if(Shadowed<GLuint>* shadow = textureShadow(unit, target); shadow && shadow->valid && shadow->value == name){
+            count(false);
+            return;
+        }
+        activeTexture(unit);
+        bindTexture(target, name);
+    }
+
+    void GLStateCache::bindSampler(GLuint unit, GLuint name){
+        if(unit >= MAX_TEXTURE_UNITS){
+            count(true);
+            glBindSampler(unit, name);
+            return;
+        }
+        if(count(samplers[unit].update(name))) glBindSampler(unit, name);
+    }
+
+    void GLStateCache::bindUniformBufferRange(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size){
+        if(index >= MAX_UNIFORM_BUFFER_BINDINGS){
+            count(true);
+            glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+            return;
+        }
+        if(count(uniformBuffers[index].update({buffer, offset, size}))) glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+    }
+
+    void GLStateCache::onProgramDeleted(GLuint name){
+        // A program in use is only flagged for deletion, so we just stop trusting the shadow
+        if(program.value == name) program.valid = false;
+    }
+
+    // Deleting a bound vertex array, framebuffer, texture or sampler reverts the binding to 0 in the current context
+    void GLStateCache::onVertexArrayDeleted(GLuint name){
+        if(vertexArray.value == name) vertexArray.value = 0;
+    }
+
+    void GLStateCache::onFramebufferDeleted(GLuint name){
+        if(drawFramebuffer.value == name) drawFramebuffer.value = 0;
+        if(readFramebuffer.value == name) readFramebuffer.value = 0;
+    }
+
+    void GLStateCache::onTextureDeleted(GLuint name){
+        for(auto& texture : textures2D)
+            if(texture.value == name) texture.value = 0;
+        for(auto& texture : textures2DArray)
+            if(texture.value == name) texture.value = 0;
+    }
+
+    void GLStateCache::onSamplerDeleted(GLuint name){
+        for(auto& sampler : samplers)
+            if(sampler.value == name) sampler.value = 0;
+    }
+
+    // The indexed bindings of a deleted buffer are reset to 0 too, but a new buffer may reuse the name so we just forget them
+    void GLStateCache::onBufferDeleted(GLuint name){
+        for(auto& binding : uniformBuffers)
+            if(binding.value.buffer == name) binding.valid = false;
+    }
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstdint>
+
+namespace our {
+
+    // This class keeps a shadow copy of the OpenGL state of the current context (pipeline toggles, bound program,
+    // vertex array, textures & samplers per unit, uniform buffer ranges and framebuffers) so that redundant state changes are never sent to the driver.
+    // Every call that goes through this class is counted as either "issued" (sent to OpenGL) or "elided" (skipped since the
+    // state was already set). All the OpenGL state changes in the engine should go through this class, otherwise the shadow
+    // copy will go out of sync. If some code changes the state behind its back (e.g. ImGui), "invalidate" must be called after it.
+    class GLStateCache {
+    public:
+        // The number of texture units we shadow. Binding to a unit beyond that is always issued.
+        static constexpr GLuint MAX_TEXTURE_UNITS = 32;
+        // The number of uniform buffer binding points we shadow. Binding to a point beyond that is always issued.
+        static constexpr GLuint MAX_UNIFORM_BUFFER_BINDINGS = 16;
+
+        // The counters of the calls that were sent to OpenGL and the ones that were skipped
+        // The draw calls (and the triangles they draw) are counted too since they are the other half of the per-frame statistics
+        struct Counters {
+            std::uint64_t issued = 0;
+            std::uint64_t elided = 0;
+            std::uint64_t drawCalls = 0;
+            std::uint64_t triangles = 0;
+        };
+
+    private:
+        // A shadowed value is only trusted if "valid" is true, otherwise the next call will be issued no matter what.
+        template<typename T>
+        struct Shadowed {
+            T value{};
+            bool valid = false;
+
+            // Returns true if the given value differs from the shadowed one (so the call must be issued) and stores it
+            bool update(const T& newValue){
+                if(valid && value == newValue) return false;
+                value = newValue;
+                valid = true;
+                return true;
+            }
+        };
+
+        Shadowed<bool> cullFaceEnabled, depthTestEnabled, blendEnabled;
+        Shadowed<GLenum> culledFace, frontFace, depthFunction, blendEquation;
+        Shadowed<glm::uvec2> blendFunction; // x: source factor, y: destination factor
+        Shadowed<glm::vec4> blendColor;
+        Shadowed<glm::bvec4> colorMask;
+        Shadowed<bool> depthMask;
+        Shadowed<glm::vec4> clearColor;
+        Shadowed<GLfloat> clearDepth;
+
+        Shadowed<GLuint> program, vertexArray;
+        Shadowed<GLuint> drawFramebuffer, readFramebuffer;
+        Shadowed<GLuint> activeTextureUnit;
+        // The framebuffer that is bound instead of the framebuffer 0 (see "setDefaultFramebuffer")
+        GLuint defaultFramebuffer = 0;
+
+        // The range of a buffer bound to an indexed binding point (glBindBufferRange)
+        struct BufferRange {
+            GLuint buffer = 0;
+            GLintptr offset = 0;
+            GLsizeiptr size = 0;
+            bool operator==(const BufferRange& other) const {
+                return buffer == other.buffer && offset == other.offset && size == other.size;
+            }
+        };
+        std::array<Shadowed<BufferRange>, MAX_UNIFORM_BUFFER_BINDINGS> uniformBuffers;
+        std::array<Shadowed<GLuint>, MAX_TEXTURE_UNITS> textures2D, textures2DArray;
+        std::array<Shadowed<GLuint>, MAX_TEXTURE_UNITS> samplers;
+
+        Counters counters;
+
+        // Counts the call as issued or elided and returns "issue" to make the call sites short
+        bool count(bool issue){
+            if(issue) ++counters.issued; else ++counters.elided;
+            return issue;
+        }
+
+        bool setCapability(GLenum capability, Shadowed<bool>& shadow, bool enabled);
+        // Returns the shadow of the texture bound to the given target of the given unit (or null if we don't track it)
+        Shadowed<GLuint>* textureShadow(GLuint unit, GLenum target);
+
+        GLStateCache() = default;
+    public:
+        // Returns the state cache of the current context.
+        // The application only creates one OpenGL context, so there is only one cache.
+        static GLStateCache& current();
+
+        // Forget everything we know about the OpenGL state. Call this after any code that changes the state without using this class.
+        void invalidate();
+        // Puts the state we shadow back to the defaults of a new context (e.g. before running another scene in the same context)
+        // The shadow copy is invalidated too, so the next calls are issued no matter what.
+        void restoreDefaults();
+
+        // Pipeline state
+        void setFaceCulling(bool enabled, GLenum culledFace, GLenum frontFace);
+        void setDepthTesting(bool enabled, GLenum function);
+        void setBlending(bool enabled, GLenum equation, GLenum sourceFactor, GLenum destinationFactor, glm::vec4 constantColor);
+        void setColorMask(glm::bvec4 mask);
+        void setDepthMask(bool mask);
+        void setClearColor(glm::vec4 color);
+        void setClearDepth(GLfloat depth);
+
+        // Object bindings
+        void useProgram(GLuint name);
+        void bindVertexArray(GLuint name);
+        // Binding the framebuffer 0 binds the default framebuffer (which is the window's framebuffer unless it was replaced)
+        void bindFramebuffer(GLenum target, GLuint name);
+        // Replaces the framebuffer 0 by the given framebuffer. Without a window (headless mode), an offscreen framebuffer
+        // takes the place of the window's framebuffer, so all the code that draws to the framebuffer 0 keeps working.
+        void setDefaultFramebuffer(GLuint name) { defaultFramebuffer = name; drawFramebuffer.valid = readFramebuffer.valid = false; }
+        void activeTexture(GLuint unit);
+        // Binds the texture to the given target (GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY) of the currently active texture unit
+        void bindTexture(GLenum target, GLuint name);
+        // Binds the texture to the given target of the given unit (the active unit is only changed if a bind is needed)
+        void bindTexture(GLuint unit, GLenum target, GLuint name);
+        void bindSampler(GLuint unit, GLuint name);
+        // Binds a range of a buffer to an indexed GL_UNIFORM_BUFFER binding point
+        void bindUniformBufferRange(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+        // OpenGL may reuse the names of deleted objects, so the shadow copy must forget about them when they are deleted
+        void onProgramDeleted(GLuint name);
+        void onVertexArrayDeleted(GLuint name);
+        void onFramebufferDeleted(GLuint name);
+        void onTextureDeleted(GLuint name);
+        void onSamplerDeleted(GLuint name);
+        void onBufferDeleted(GLuint name);
+
+        // Counts a draw call. Draw calls are not shadowed (they are always issued), this only feeds the statistics.
+        void countDraw(std::uint64_t triangles) { ++counters.drawCalls; counters.triangles += triangles; }
+
+        // Returns the counters accumulated since the last call to "resetCounters"
+        [[nodiscard]] const Counters& getCounters() const { return counters; }
+        void resetCounters() { counters = {}; }
+
+        GLStateCache(const GLStateCache&) = delete;
+        GLStateCache& operator=(const GLStateCache&) = delete;
+    };
+
+}
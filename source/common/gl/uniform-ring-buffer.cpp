@@ -0,0 +1,167 @@
+#include "uniform-ring-buffer.hpp"
+#include "state-cache.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace our {
+
+    void UniformRingBuffer::initialize(GLsizeiptr bytesPerFrame){
+        // Every range bound with glBindBufferRange must start at a multiple of this alignment
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        create(bytesPerFrame);
+    }
+
+    void UniformRingBuffer::create(GLsizeiptr bytesPerFrame){
+        // The partitions must start at an aligned offset too
+        partitionSize = (bytesPerFrame + alignment - 1) / alignment * alignment;
+        GLsizeiptr totalSize = partitionSize * FRAMES_IN_FLIGHT;
+        persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        if(persistent){
+            // Coherent mapping means that our writes are visible to the GPU without flushing them explicitly
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_UNIFORM_BUFFER, totalSize, nullptr, flags);
+            memory = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalSize, flags));
+            if(!memory){
+                std::cerr << "WARNING: Couldn't map the uniform ring buffer persistently, falling back to glBufferSubData" << std::endl;
+                glDeleteBuffers(1, &buffer);
+                glGenBuffers(1, &buffer);
+                glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+                persistent = false;
+            }
+        }
+        if(!persistent){
+            glBufferData(GL_UNIFORM_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+            fallbackMemory.resize(totalSize);
+            memory = fallbackMemory.data();
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        partition = 0;
+        used = 0;
+    }
+
+    void UniformRingBuffer::release(){
+        for(auto& fence : fences){
+            if(fence) glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if(buffer){
+            // Deleting a buffer unmaps it
+            GLStateCache::current().onBufferDeleted(buffer);
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+        memory = nullptr;
+        fallbackMemory.clear();
+        releaseOverflows();
+    }
+
+    void UniformRingBuffer::releaseOverflows(){
+        // The GPU may still read them, but OpenGL keeps deleted buffers alive until it is done with them
+        for(auto& overflow : overflows){
+            GLStateCache::current().onBufferDeleted(overflow.buffer);
+            glDeleteBuffers(1, &overflow.buffer);
+        }
+        overflows.clear();
+    }
+
+    void UniformRingBuffer::destroy(){
+        release();
+        partitionSize = 0;
+    }
+
+    void UniformRingBuffer::beginFrame(){
+        releaseOverflows();
+        GLsizeiptr required = requested;
+        requested = 0;
+        if(required > partitionSize){
+            // The last frame needed more than a partition, so the buffer is replaced before anything of this frame is bound from it.
+            // The new buffer is empty so no fences are needed for it.
+            GLsizeiptr newSize = partitionSize * 2;
+            while(newSize < required) newSize *= 2;
+            std::cerr << "WARNING: The uniform ring buffer was full, growing it to " << newSize << " bytes per frame" << std::endl;
+            release();
+            create(newSize);
+            return;
+        }
+
+        partition = (partition + 1) % FRAMES_IN_FLIGHT;
+        used = 0;
+        GLsync& fence = fences[partition];
+        if(!fence) return;
+        // Usually, the fence was signaled long ago so this returns immediately. If not, we wait (flushing the commands the first time
+        // so that the fence is guaranteed to be signaled eventually).
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if(result == GL_TIMEOUT_EXPIRED){
+            ++stalls;
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            do {
+                result = glClientWaitSync(fence, flags, 1000000); // 1 ms
+                flags = 0;
+            } while(result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    void UniformRingBuffer::endFrame(){
+        GLsync& fence = fences[partition];
+        if(fence) glDeleteSync(fence);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    UniformRingBuffer::Allocation UniformRingBuffer::allocate(GLsizeiptr size){
+        requested = (requested + alignment - 1) / alignment * alignment + size;
+        GLsizeiptr offset = (used + alignment - 1) / alignment * alignment;
+        // The frame needs more data than a partition can hold (the ring grows at the next frame)
+        if(offset + size > partitionSize || !overflows.empty())
+            return allocateOverflow(size);
+        used = offset + size;
+        Allocation allocation;
+        allocation.buffer = buffer;
+        allocation.offset = partition * partitionSize + offset;
+        allocation.size = size;
+        allocation.data = memory + allocation.offset;
+        return allocation;
+    }
+
+    UniformRingBuffer::Allocation UniformRingBuffer::allocateOverflow(GLsizeiptr size){
+        GLsizeiptr offset = overflows.empty() ? 0 : (overflows.back().used + alignment - 1) / alignment * alignment;
+        if(overflows.empty() || offset + size > (GLsizeiptr)overflows.back().memory.size()){
+            // A new overflow buffer (written through a CPU copy like the ring without a persistent mapping)
+            Overflow overflow;
+            overflow.memory.resize(std::max(size, partitionSize));
+            glGenBuffers(1, &overflow.buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, overflow.buffer);
+            glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)overflow.memory.size(), nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            overflows.push_back(std::move(overflow));
+            offset = 0;
+        }
+        Overflow& overflow = overflows.back();
+        overflow.used = offset + size;
+        Allocation allocation;
+        allocation.buffer = overflow.buffer;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.data = overflow.memory.data() + offset;
+        return allocation;
+    }
+
+    void UniformRingBuffer::upload(const Allocation& allocation){
+        if(!persistent || allocation.buffer != buffer){
+            // Without a persistent mapping, the data has to be uploaded before it is used
+            glBindBuffer(GL_UNIFORM_BUFFER, allocation.buffer);
+            glBufferSubData(GL_UNIFORM_BUFFER, allocation.offset, allocation.size, allocation.data);
+        }
+    }
+
+    void UniformRingBuffer::bind(GLuint index, const Allocation& allocation){
+        upload(allocation);
+        GLStateCache::current().bindUniformBufferRange(index, allocation.buffer, allocation.offset, allocation.size);
+    }
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace our {
+
+    // A uniform buffer that is used as a ring to stream the per-frame & per-draw data of the renderer.
+    // The buffer is split into one partition per frame in flight. Every frame, data is written into the next partition
+    // and each block is bound with glBindBufferRange. Before a partition is written again, we wait on the fence placed
+    // after the frame that last used it, so the CPU never overwrites data the GPU may still be reading.
+    // If the driver supports GL_ARB_buffer_storage (core in 4.4), the buffer is mapped once (persistent & coherent) so writing
+    // the data is just a memcpy. Otherwise, the data is written to a CPU copy and uploaded with glBufferSubData when it is bound.
+    // The buffer is never replaced in the middle of a frame since the ranges bound earlier in the frame (like the frame block
+    // which is bound once) must stay bound. If a frame needs more than a partition, the rest of its data goes to overflow
+    // buffers that live until the next frame, and the ring grows at the start of the next frame to fit what that frame needed.
+    class UniformRingBuffer {
+    public:
+        // How many frames can be in flight before we wait for the GPU
+        static constexpr int FRAMES_IN_FLIGHT = 3;
+
+        // A range allocated in the current partition. "data" points to where the content should be written.
+        struct Allocation {
+            void* data = nullptr;
+            GLuint buffer = 0; // The ring buffer or an overflow buffer (see "allocate")
+            GLintptr offset = 0;
+            GLsizeiptr size = 0;
+        };
+
+    private:
+        GLuint buffer = 0;
+        bool persistent = false;
+        // The persistently mapped memory (or the CPU copy if the buffer can't be mapped persistently)
+        unsigned char* memory = nullptr;
+        std::vector<unsigned char> fallbackMemory;
+        GLsizeiptr partitionSize = 0;
+        GLint alignment = 256;
+
+        int partition = 0;
+        GLsizeiptr used = 0;
+        // The bytes the current frame asked for (including the alignment), which the ring grows to fit at the next frame
+        GLsizeiptr requested = 0;
+
+        // The buffers that hold what didn't fit in the partition of the current frame. They are never resized, so every
+        // allocation stays in the buffer it was made in, and they are deleted when the next frame begins.
+        struct Overflow {
+            GLuint buffer = 0;
+            std::vector<unsigned char> memory;
+            GLsizeiptr used = 0;
+        };
+        std::vector<Overflow> overflows;
+        std::array<GLsync, FRAMES_IN_FLIGHT> fences{};
+        // How many times we had to wait for the GPU (if this grows, there are not enough frames in flight)
+        int stalls = 0;
+
+        void create(GLsizeiptr bytesPerFrame);
+        void release();
+        void releaseOverflows();
+        Allocation allocateOverflow(GLsizeiptr size);
+
+    public:
+        // Creates the buffer with "bytesPerFrame" bytes for each frame in flight
+        void initialize(GLsizeiptr bytesPerFrame);
+        // Deletes the buffer (this must be called while the OpenGL context still exists)
+        void destroy();
+
+        // Moves to the next partition (waiting for the GPU to be done with it if needed). Must be called before any allocation in a frame.
+        // If the previous frame overflowed its partition, the buffer is replaced by a bigger one here (nothing is bound from it yet).
+        void beginFrame();
+        // Places a fence after the commands of this frame so that its partition is not reused before the GPU is done with it
+        void endFrame();
+
+        // Allocates "size" bytes in the current partition. If the partition is full, the bytes come from an overflow buffer
+        // instead, so the buffer of each allocation must be taken from "Allocation::buffer" (not from "getBuffer").
+        Allocation allocate(GLsizeiptr size);
+        // Allocates space for a value, copies it and returns its range
+        template<typename T>
+        Allocation push(const T& value) {
+            Allocation allocation = allocate(sizeof(T));
+            std::memcpy(allocation.data, &value, sizeof(T));
+            return allocation;
+        }
+        // Binds an allocation to an indexed uniform buffer binding point
+        void bind(GLuint index, const Allocation& allocation);
+        // Makes the content of an allocation visible to the GPU (without a persistent mapping, it has to be uploaded).
+        // This is only needed when the allocation is used as something other than a uniform block (e.g. as per-instance vertex data)
+        // since "bind" already does it.
+        void upload(const Allocation& allocation);
+        // The ring buffer (the allocations that overflowed are in other buffers, see "Allocation::buffer")
+        GLuint getBuffer() const { return buffer; }
+
+        bool isPersistent() const { return persistent; }
+        int getStalls() const { return stalls; }
+        GLsizeiptr getBytesPerFrame() const { return partitionSize; }
+    };
+
+}
@@ -14,10 +14,11 @@ namespace our {
 
     public:
         // Enable this object and capture current keyboard state from window
+        // Without a window (headless mode), no key is ever pressed
         void enable(GLFWwindow* window){
             enabled = true;
             for(int key = GLFW_KEY_SPACE; key <= GLFW_KEY_LAST; key++){
-                currentKeyStates[key] = previousKeyStates[key] = glfwGetKey(window, key);
+                currentKeyStates[key] = previousKeyStates[key] = window && glfwGetKey(window, key);
             }
         }
 
@@ -0,0 +1,87 @@
+#include "thread-pool.hpp"
+#include "../profiling/cpu-profiler.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace our {
+
+    ThreadPool::ThreadPool(unsigned workerCount){
+        workers.reserve(workerCount);
+        for(unsigned index = 0; index < workerCount; ++index)
+            workers.emplace_back(&ThreadPool::workerLoop, this, index);
+    }
+
+    ThreadPool::~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(auto& worker : workers) worker.join();
+    }
+
+    unsigned ThreadPool::defaultWorkerCount(){
+        // hardware_concurrency may return 0 if it can't tell
+        unsigned threads = std::thread::hardware_concurrency();
+        return threads > 1 ? threads - 1 : 0;
+    }
+
+    ThreadPool& ThreadPool::shared(){
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void ThreadPool::runChunks(const std::function<void(size_t)>& function){
+        for(size_t chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1)){
+            function(chunk);
+            finishedChunks.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void ThreadPool::workerLoop(unsigned index){
+        profiler::setThreadName("worker " + std::to_string(index + 1));
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true){
+            wake.wait(lock, [&]{ return stopping || generation != seen; });
+            if(stopping) return;
+            seen = generation;
+            // The loop may already be over if this worker woke up late
+            if(!task) continue;
+            const std::function<void(size_t)>* current = task;
+            ++busyWorkers;
+            lock.unlock();
+            runChunks(*current);
+            lock.lock();
+            if(--busyWorkers == 0) done.notify_one();
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& function){
+        if(count == 0) return;
+        // A single chunk (or a pool without workers) is not worth waking anyone up for
+        if(count == 1 || workers.empty()){
+            for(size_t chunk = 0; chunk < count; ++chunk) function(chunk);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &function;
+            chunkCount = count;
+            nextChunk.store(0);
+            finishedChunks.store(0);
+            ++generation;
+        }
+        wake.notify_all();
+
+        runChunks(function);
+
+        // Wait until every chunk finished and no worker still holds the task, then retire the task
+        // so that a worker that wakes up late doesn't run a loop that is already over
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]{ return busyWorkers == 0 && finishedChunks.load(std::memory_order_acquire) == chunkCount; });
+        task = nullptr;
+    }
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace our {
+
+    // A fixed set of worker threads that run data-parallel loops.
+    // A loop is split into chunks by the caller, then the workers and the calling thread grab chunks from a shared atomic counter
+    // until none are left (so a slow chunk doesn't hold back the others). "parallelFor" only returns after every chunk finished,
+    // so the task can safely capture locals by reference.
+    // The workers sleep on a condition variable between loops, so an idle pool costs nothing.
+    // Tasks must not touch OpenGL since the context is only current on the main thread.
+    class ThreadPool {
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable wake, done;
+        // The loop being run (null when there is none). It is only read by a worker after it registered itself in "busyWorkers".
+        const std::function<void(size_t)>* task = nullptr;
+        std::uint64_t generation = 0;
+        size_t busyWorkers = 0;
+        bool stopping = false;
+
+        size_t chunkCount = 0;
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> finishedChunks{0};
+
+        void workerLoop(unsigned index);
+        // Runs chunks of the current loop until none are left
+        void runChunks(const std::function<void(size_t)>& function);
+
+    public:
+        // Creates the given number of workers (the calling thread helps too, so the default leaves one core for it)
+        explicit ThreadPool(unsigned workerCount = defaultWorkerCount());
+        ~ThreadPool();
+
+        // Calls task(chunk) for every chunk in [0, chunkCount) and waits for all of them to finish
+        // The chunks run in no particular order, so each chunk should write its results to its own slot.
+        void parallelFor(size_t chunkCount, const std::function<void(size_t)>& task);
+
+        unsigned getWorkerCount() const { return (unsigned)workers.size(); }
+
+        // The number of hardware threads minus one (for the main thread)
+        static unsigned defaultWorkerCount();
+        // A pool shared by the systems of the engine (it is created on first use)
+        static ThreadPool& shared();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+    };
+
+}
@@ -0,0 +1,51 @@
+#include "worker-thread.hpp"
+#include "../profiling/cpu-profiler.hpp"
+
+namespace our {
+
+    WorkerThread::WorkerThread(const std::string& name){
+        thread = std::thread(&WorkerThread::loop, this, name);
+    }
+
+    WorkerThread::~WorkerThread(){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]{ return !busy; });
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    void WorkerThread::loop(std::string name){
+        profiler::setThreadName(name);
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true){
+            wake.wait(lock, [this]{ return stopping || busy; });
+            if(stopping) return;
+            // The task runs without the lock so that "wait" can be called (and block) meanwhile
+            std::function<void()> current = std::move(task);
+            lock.unlock();
+            current();
+            lock.lock();
+            busy = false;
+            done.notify_all();
+        }
+    }
+
+    void WorkerThread::start(std::function<void()> function){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]{ return !busy; });
+            task = std::move(function);
+            busy = true;
+        }
+        wake.notify_one();
+    }
+
+    void WorkerThread::wait(){
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]{ return !busy; });
+    }
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace our {
+
+    // A single long-lived thread that runs one task at a time.
+    // Unlike the thread pool (which splits one loop over many threads), this is used to run a whole stage of the frame
+    // (e.g. the simulation) next to the main thread: "start" hands over the task and returns immediately, "wait" blocks until it is done.
+    class WorkerThread {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake, done;
+        std::function<void()> task;
+        bool busy = false, stopping = false;
+
+        void loop(std::string name);
+
+    public:
+        // The name is shown in the CPU profiler traces
+        explicit WorkerThread(const std::string& name);
+        ~WorkerThread();
+
+        // Runs the task on the thread. If a previous task is still running, this waits for it first.
+        void start(std::function<void()> function);
+        // Waits until the current task (if any) is done
+        void wait();
+
+        WorkerThread(const WorkerThread&) = delete;
+        WorkerThread& operator=(const WorkerThread&) = delete;
+    };
+
+}
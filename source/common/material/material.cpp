@@ -45,7 +45,10 @@ namespace our
 
         // if the material is TintedMaterial in addition to setting the shader to be used we need to set the tint variable 
         // set the uniform "tint" in (shader) to the variable tint
-        shader->set("tint", tint); 
+        // (the handle is only looked up again if the shader changes, and the same tint isn't sent twice in a row)
+        static const char* const NAMES[] = {"tint"};
+        uniforms.resolve(shader, NAMES);
+        shader->set(uniforms[0], tint); 
     }
 
     // This function read the material data from a json object
@@ -70,18 +73,19 @@ namespace our
 
         // sets the alpha threshold
         // set the uniform "alphaThreshold" in (shader) to the variable alphaTreshold
-        this->shader->set("alphaThreshold", alphaThreshold); 
+        static const char* const NAMES[] = {"alphaThreshold", "tex"};
+        uniforms.resolve(shader, NAMES);
+        this->shader->set(uniforms[0], alphaThreshold); 
         
-        glActiveTexture(GL_TEXTURE0);
-        // binds the texture to unit 0
-        this->texture->bind();      
+        // binds the texture to unit 0 (skipped if it is already bound there)
+        this->texture->bind(0);
         
         // binds sampler to same texture unit 0 if it exists
         if(sampler != nullptr)
             this->sampler->bind(0);                              
         
         // send unit number to shader with uniform variable "tex"
-        this->shader->set("tex", 0);                         
+        this->shader->set(uniforms[1], 0);                         
     }
 
     // This function read the material data from a json object
@@ -95,6 +99,29 @@ namespace our
         sampler = AssetLoader<Sampler>::get(data.value("sampler", ""));
     }
 
+    // Sends a single map of a lighted material to the shader
+    // If the map is a texture layer, its array is bound to the given unit and the layer index is sent,
+    // otherwise, the layer is set to -1 and the constant color is sent instead (no texture is bound at all)
+    // "uniforms" points to the handles of the map's "array", "layer" & "color"
+    static void setupLightMap(ShaderProgram* shader, const UniformHandle* uniforms, const TextureLayer* map, const Sampler* sampler, GLint unit)
+    {
+        // Each map always uses its own unit since all the arrays in the shader must refer to a valid unit
+        shader->set(uniforms[0], unit);
+        if (map != nullptr && !map->isConstant())
+        {
+            //bind the texture array and the sampler to the unit (skipped if they are already bound there)
+            map->array->bind(unit);
+            if (sampler != nullptr)
+                sampler->bind(unit);
+            shader->set(uniforms[1], map->layer);
+        }
+        else
+        {
+            shader->set(uniforms[1], -1);
+            shader->set(uniforms[2], map != nullptr ? map->color : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        }
+    }
+
     // setup of the lightMaterial to create the needed textures based on the type
     void LightMaterial::setup() const
     {
@@ -103,66 +130,23 @@ namespace our
         // and sets the shader program to be used
         Material::setup();
 
-        if (albedo != nullptr)
-        {
-            //select an active texture unit -> 0
-            glActiveTexture(GL_TEXTURE0);
-            //bind the texture to unit 0
-            albedo->bind();
-            //bind the sampler to unit 0
-            sampler->bind(0);
-            // send unit number to shader with uniform variable "albedo"
-            shader->set("material.albedo", 0);
-        }
-        if (specular != nullptr)
-        {
-            //select an active texture unit -> 1
-            glActiveTexture(GL_TEXTURE1);
-            //bind the texture to unit 1
-            specular->bind();
-            //bind the sampler to unit 1
-            sampler->bind(1);
-            // send unit number to shader with uniform variable "specular"
-            shader->set("material.specular", 1);
-        }
-
-        if (emissive != nullptr)
-        {
-            //select an active texture unit -> 2
-            glActiveTexture(GL_TEXTURE2);
-            //bind the texture to unit 2
-            emissive->bind();
-            //bind the sampler to unit 2
-            sampler->bind(2);
-            // send unit number to shader with uniform variable "emissive"
-            shader->set("material.emissive", 2);
-        }
-
-        if (roughness != nullptr)
+        // The uniform names of the maps are built once, and resolved into handles only when the shader changes
+        static const std::vector<std::string> NAMES = []
         {
-            //select an active texture unit -> 3
-            glActiveTexture(GL_TEXTURE3);
-            //bind the texture to unit 3
-            //texture->bind();
-            roughness->bind();
-            //bind the sampler to unit 3
-            sampler->bind(3);
-            // send unit number to shader with uniform variable "roughness"
-            shader->set("material.roughness", 3);
-        }
-
-        if (ambient_occlusion != nullptr)
-        {
-            //select an active texture unit -> 4
-            glActiveTexture(GL_TEXTURE4);
-            //bind the texture to unit 4
-            ambient_occlusion->bind();
-            //bind the sampler to unit 4
-            sampler->bind(4);
-            // send unit number to shader with uniform variable "ambient_occlusion"
-            shader->set("material.ambient_occlusion", 4);
-        }
-        
+            std::vector<std::string> names;
+            for (const char *map : MAP_NAMES)
+                for (const char *member : {".array", ".layer", ".color"})
+                    names.push_back(std::string("material.") + map + member);
+            return names;
+        }();
+        uniforms.resolve(shader, NAMES);
+
+        // Each map uses a texture unit from 0 to 4 in the same order as in "MAP_NAMES"
+        setupLightMap(shader, &uniforms[0], albedo, sampler, 0);
+        setupLightMap(shader, &uniforms[3], specular, sampler, 1);
+        setupLightMap(shader, &uniforms[6], emissive, sampler, 2);
+        setupLightMap(shader, &uniforms[9], roughness, sampler, 3);
+        setupLightMap(shader, &uniforms[12], ambient_occlusion, sampler, 4);
     }
 
     //Deserialize LightMaterial data from the json file
@@ -172,11 +156,11 @@ namespace our
         if (!data.is_object())
             return;
         sampler = AssetLoader<Sampler>::get(data.value("sampler", ""));
-        albedo = AssetLoader<Texture2D>::get(data.value("albedo", ""));
-        specular = AssetLoader<Texture2D>::get(data.value("specular", ""));
-        emissive = AssetLoader<Texture2D>::get(data.value("emissive", ""));
-        roughness = AssetLoader<Texture2D>::get(data.value("roughness", ""));
-        ambient_occlusion = AssetLoader<Texture2D>::get(data.value("ambient_occlusion", ""));
+        albedo = AssetLoader<TextureLayer>::get(data.value("albedo", ""));
+        specular = AssetLoader<TextureLayer>::get(data.value("specular", ""));
+        emissive = AssetLoader<TextureLayer>::get(data.value("emissive", ""));
+        roughness = AssetLoader<TextureLayer>::get(data.value("roughness", ""));
+        ambient_occlusion = AssetLoader<TextureLayer>::get(data.value("ambient_occlusion", ""));
     }
 
 }
\ No newline at end of file
@@ -2,12 +2,15 @@
 
 #include "pipeline-state.hpp"
 #include "../texture/texture2d.hpp"
+#include "../texture/texture-array.hpp"
 #include "../texture/sampler.hpp"
 #include "../shader/shader.hpp"
 
 #include <glm/vec4.hpp>
 #include <json/json.hpp>
 
+#include <iterator>
+
 namespace our {
 
     // This is the base class for all the materials
@@ -36,6 +39,8 @@ namespace our {
 
         void setup() const override;
         void deserialize(const nlohmann::json& data) override;
+    private:
+        mutable UniformHandles<1> uniforms; // "tint"
     };
  
     // This material adds two uniforms (besides the tint from Tinted Material)
@@ -51,25 +56,35 @@ namespace our {
 
         void setup() const override;
         void deserialize(const nlohmann::json& data) override;
+    private:
+        mutable UniformHandles<2> uniforms; // "alphaThreshold", "tex"
     };
     // light material will inherit from the  material and add all texture types for the light material.
+    // Each map refers to a layer in a texture array (shared with other materials whose images have the same size)
+    // or to a constant color if the image holds a single color. A missing map is treated as a constant black.
     class LightMaterial : public Material {
     public:
+        // The names of the maps (used as json keys and as uniform names in "material.*")
+        static constexpr const char* MAP_NAMES[] = {"albedo", "specular", "emissive", "roughness", "ambient_occlusion"};
+
         //measure of ability to reflect light
-        Texture2D* albedo ;
+        TextureLayer* albedo ;
         //reflection of light from a surface in a specific direction.
-        Texture2D* specular ;
+        TextureLayer* specular ;
         //it is a measure of how smooth or rough a surface appears
         //affects specular light
-        Texture2D* roughness ;
+        TextureLayer* roughness ;
         //to create more realistic shadows 
-        Texture2D* ambient_occlusion ;
+        TextureLayer* ambient_occlusion ;
         //materials or objects that emit their own light. 
-        Texture2D* emissive ;
+        TextureLayer* emissive ;
         Sampler* sampler ;
 
         void setup() const override;
         void deserialize(const nlohmann::json& data) override;
+    private:
+        // "material.<map>.array", ".layer" & ".color" for each map in the order of "MAP_NAMES"
+        mutable UniformHandles<3 * std::size(MAP_NAMES)> uniforms;
     };
 
     // This function returns a new material instance based on the given type
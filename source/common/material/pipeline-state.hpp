@@ -4,6 +4,8 @@
 #include <glm/vec4.hpp>
 #include <json/json.hpp>
 
+#include "../gl/state-cache.hpp"
+
 namespace our {
     // There are some options in the render pipeline that we cannot control via shaders
     // such as blending, depth testing and so on
@@ -40,74 +42,31 @@ namespace our {
 
         // This function should set the OpenGL options to the values specified by this structure
         // For example, if faceCulling.enabled is true, you should call glEnable(GL_CULL_FACE), otherwise, you should call glDisable(GL_CULL_FACE)
+        // The options are sent through the GL state cache so that only the options that differ from the current OpenGL state
+        // reach the driver (consecutive draws usually share most of their pipeline state).
         void setup() const {
             //TODO: (Req 4) Write this function
+            GLStateCache& cache = GLStateCache::current();
 
             //1-FACE CULLING
-            //Check if we want it enabled or not
-            
-            //If YES then we enable culling at first then
-            //call glCullFace() to specify that the back-facing facets are culled
-            //& glFrontFace() to set orientation of front-facing polygons initially set to "counter-clockwise""
-
-            //If NO then we call glDisable() to disable culling
-            if (faceCulling.enabled == true)
-            {
-                glEnable(GL_CULL_FACE);
-                glCullFace(faceCulling.culledFace);
-                glFrontFace(faceCulling.frontFace);
-            }
-            else
-            {
-                glDisable(GL_CULL_FACE);
-            }
+            //If enabled, glCullFace() specifies which facets are culled
+            //& glFrontFace() sets the orientation of front-facing polygons initially set to "counter-clockwise"
+            cache.setFaceCulling(faceCulling.enabled, faceCulling.culledFace, faceCulling.frontFace);
 
             //2-DEPTH
-            //Check if we want it enabled or not
-            //If YES then we enable Depth at first then
-            //call glDepthFunc() to set the depth comparison function initially set to "GL_LEQUAL" 
+            //If enabled, glDepthFunc() sets the depth comparison function initially set to "GL_LEQUAL"
             //Passes if  incoming depth value is <= to stored value.
+            cache.setDepthTesting(depthTesting.enabled, depthTesting.function);
 
-            //If NO then we call glDisable() to disable culling
-
-            if (depthTesting.enabled == true)
-            {
-                glEnable(GL_DEPTH_TEST);
-                glDepthFunc(depthTesting.function);
-            }
-            else
-            {
-                glDisable(GL_DEPTH_TEST);
-            }
-            
             //3-BLENDING
-            //Check if we want it enabled or not
-
-            //If YES then we enable Depth at first then
-            //call glBlendEquation() to set how source and destination colors are combined set initially to "GL_FUNC_ADD" used for antialiasing and transparency,.
-            //& glBlendFunc() to define the operation of blending for all draw buffers  set initially to "src = GL_SRC_ALPHA" & "dst = GL_ONE_MINUS_SRC_ALPHA"
-            // meaning that the Factor is equal to the alpha component of the source color vector and dst factor is equal to 1−alpha of the source color vector
-            //& glBlendColor() to set  the source and destination blending factors ranging from [0,1]
-
-
-            //If NO then we call glDisable() to disable culling
-
-
-            if (blending.enabled == true)
-            {
-                glEnable(GL_BLEND);
-                glBlendEquation(blending.equation);
-                glBlendFunc(blending.sourceFactor, blending.destinationFactor);
-                glBlendColor(blending.constantColor.r, blending.constantColor.g, blending.constantColor.b, blending.constantColor.a);
-            }
-            else
-            {
-                glDisable(GL_BLEND);
-            }
-            
-            //Here to just call glColorMask() & glDepthMask() to
-            glColorMask(colorMask.r, colorMask.g, colorMask.b, colorMask.a);
-            glDepthMask(depthMask);
+            //If enabled, glBlendEquation() sets how source and destination colors are combined set initially to "GL_FUNC_ADD",
+            //& glBlendFunc() defines the source and destination factors set initially to "src = GL_SRC_ALPHA" & "dst = GL_ONE_MINUS_SRC_ALPHA"
+            //& glBlendColor() sets the constant color used by the constant blending factors
+            cache.setBlending(blending.enabled, blending.equation, blending.sourceFactor, blending.destinationFactor, blending.constantColor);
+
+            //Here to just call glColorMask() & glDepthMask()
+            cache.setColorMask(colorMask);
+            cache.setDepthMask(depthMask);
         }
 
         // Given a json object, this function deserializes a PipelineState structure
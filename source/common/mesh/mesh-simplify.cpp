@@ -0,0 +1,282 @@
+#include "mesh-simplify.hpp"
+#include "../profiling/cpu-profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace our::mesh_utils {
+
+    namespace {
+        // A quadric holds the sum of the squared distances to a set of planes as a symmetric 4x4 matrix (10 unique values).
+        // The total weight of the planes is kept too, so that the error can be normalized into an average squared distance.
+        struct Quadric {
+            double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+            double weight = 0;
+
+            // Adds the plane dot(normal, p) + d = 0 where normal is a unit vector
+            void addPlane(const glm::dvec3& normal, double d, double planeWeight){
+                double a = normal.x, b = normal.y, c = normal.z;
+                xx += a * a * planeWeight; xy += a * b * planeWeight; xz += a * c * planeWeight; xw += a * d * planeWeight;
+                yy += b * b * planeWeight; yz += b * c * planeWeight; yw += b * d * planeWeight;
+                zz += c * c * planeWeight; zw += c * d * planeWeight;
+                ww += d * d * planeWeight;
+                weight += planeWeight;
+            }
+
+            Quadric& operator+=(const Quadric& other){
+                xx += other.xx; xy += other.xy; xz += other.xz; xw += other.xw;
+                yy += other.yy; yz += other.yz; yw += other.yw;
+                zz += other.zz; zw += other.zw;
+                ww += other.ww;
+                weight += other.weight;
+                return *this;
+            }
+
+            // Returns the weighted average of the squared distances from the point to the planes
+            double error(const glm::dvec3& p) const {
+                double e = xx * p.x * p.x + yy * p.y * p.y + zz * p.z * p.z + ww
+                         + 2.0 * (xy * p.x * p.y + xz * p.x * p.z + yz * p.y * p.z + xw * p.x + yw * p.y + zw * p.z);
+                return weight > 0.0 ? std::abs(e) / weight : 0.0;
+            }
+        };
+
+        // Moving "from" onto "to" costs "cost"
+        struct Collapse {
+            unsigned int from, to;
+            double cost;
+        };
+
+        // The border planes are weighted more than the surface planes so that open edges (e.g. the rim of a lamp shade) don't shrink
+        constexpr double BORDER_WEIGHT = 10.0;
+
+        std::uint64_t edgeKey(unsigned int a, unsigned int b){
+            if(a > b) std::swap(a, b);
+            return (std::uint64_t(a) << 32) | b;
+        }
+    }
+
+    std::vector<unsigned int> simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& elements,
+                                       size_t targetIndexCount, float targetError, float* resultError){
+        PROFILE_ZONE("mesh_utils::simplify");
+        std::vector<unsigned int> indices = elements;
+        if(resultError) *resultError = 0.0f;
+        if(indices.size() <= targetIndexCount || vertices.empty()) return indices;
+
+        // The vertices that share a position are treated as a single point (a "group") by the collapses.
+        // The vertices of a group (its "wedges") only differ in their attributes (e.g. the texture coordinates on both sides of a seam).
+        std::vector<unsigned int> groupOf(vertices.size());
+        std::vector<glm::dvec3> positions;
+        std::vector<std::vector<unsigned int>> wedges;
+        {
+            std::unordered_map<glm::vec3, unsigned int> groups;
+            for(unsigned int vertex = 0; vertex < vertices.size(); ++vertex){
+                auto [it, inserted] = groups.try_emplace(vertices[vertex].position, (unsigned int)positions.size());
+                if(inserted){
+                    positions.emplace_back(vertices[vertex].position);
+                    wedges.emplace_back();
+                }
+                groupOf[vertex] = it->second;
+                wedges[it->second].push_back(vertex);
+            }
+        }
+        size_t groupCount = positions.size();
+
+        // The error is measured relative to the largest dimension of the mesh
+        glm::dvec3 minimum(std::numeric_limits<double>::max()), maximum(std::numeric_limits<double>::lowest());
+        for(auto& position : positions){
+            minimum = glm::min(minimum, position);
+            maximum = glm::max(maximum, position);
+        }
+        glm::dvec3 size = maximum - minimum;
+        double extent = std::max({size.x, size.y, size.z});
+        if(extent <= 0.0) extent = 1.0;
+        double errorLimit = (double)targetError * extent * (double)targetError * extent;
+
+        // Each group starts with the planes of its triangles (weighted by their area)
+        std::vector<Quadric> quadrics(groupCount);
+        std::unordered_map<std::uint64_t, int> edgeUses;
+        for(size_t first = 0; first + 2 < indices.size(); first += 3){
+            unsigned int g[3] = {groupOf[indices[first]], groupOf[indices[first + 1]], groupOf[indices[first + 2]]};
+            if(g[0] == g[1] || g[1] == g[2] || g[2] == g[0]) continue;
+            glm::dvec3 cross = glm::cross(positions[g[1]] - positions[g[0]], positions[g[2]] - positions[g[0]]);
+            double length = glm::length(cross);
+            if(length == 0.0) continue;
+            glm::dvec3 normal = cross / length;
+            double d = -glm::dot(normal, positions[g[0]]);
+            for(unsigned int group : g) quadrics[group].addPlane(normal, d, length * 0.5);
+            for(int edge = 0; edge < 3; ++edge) ++edgeUses[edgeKey(g[edge], g[(edge + 1) % 3])];
+        }
+        // An edge used by a single triangle is on the border, so we add a plane perpendicular to the triangle through the edge
+        // to both its ends (any movement away from the border line then has a cost)
+        for(size_t first = 0; first + 2 < indices.size(); first += 3){
+            unsigned int g[3] = {groupOf[indices[first]], groupOf[indices[first + 1]], groupOf[indices[first + 2]]};
+            if(g[0] == g[1] || g[1] == g[2] || g[2] == g[0]) continue;
+            glm::dvec3 normal = glm::cross(positions[g[1]] - positions[g[0]], positions[g[2]] - positions[g[0]]);
+            if(glm::length(normal) == 0.0) continue;
+            for(int edge = 0; edge < 3; ++edge){
+                unsigned int a = g[edge], b = g[(edge + 1) % 3];
+                if(edgeUses[edgeKey(a, b)] != 1) continue;
+                glm::dvec3 direction = positions[b] - positions[a];
+                glm::dvec3 perpendicular = glm::cross(direction, normal);
+                double length = glm::length(perpendicular);
+                if(length == 0.0) continue;
+                perpendicular /= length;
+                double d = -glm::dot(perpendicular, positions[a]);
+                double weight = glm::dot(direction, direction) * BORDER_WEIGHT;
+                quadrics[a].addPlane(perpendicular, d, weight);
+                quadrics[b].addPlane(perpendicular, d, weight);
+            }
+        }
+
+        // "target" links every collapsed group to the group it was moved onto
+        std::vector<unsigned int> target(groupCount);
+        std::iota(target.begin(), target.end(), 0u);
+        auto find = [&](unsigned int group){
+            while(target[group] != group) group = target[group] = target[target[group]];
+            return group;
+        };
+
+        // Returns the wedge of "group" whose attributes are the closest to the given vertex
+        std::vector<unsigned int> replacement(vertices.size());
+        auto pickWedge = [&](unsigned int vertex, unsigned int group){
+            unsigned int& cached = replacement[vertex];
+            if(cached != std::numeric_limits<unsigned int>::max() && groupOf[cached] == group) return cached;
+            const Vertex& original = vertices[vertex];
+            float bestDistance = std::numeric_limits<float>::max();
+            for(unsigned int wedge : wedges[group]){
+                const Vertex& candidate = vertices[wedge];
+                glm::vec2 uv = candidate.tex_coord - original.tex_coord;
+                glm::vec3 normal = candidate.normal - original.normal;
+                float distance = glm::dot(uv, uv) + glm::dot(normal, normal);
+                if(distance < bestDistance){
+                    bestDistance = distance;
+                    cached = wedge;
+                }
+            }
+            return cached;
+        };
+
+        double maxError = 0.0;
+        std::vector<unsigned int> adjacencyOffsets, adjacency, cursor;
+        std::vector<std::uint64_t> edges;
+        std::vector<Collapse> collapses;
+        std::vector<char> locked(groupCount);
+
+        // The collapses are done in passes. In each pass, we sort the edges by cost and collapse as many as possible
+        // while locking the neighborhood of each collapse, so that every collapse in a pass sees an unmodified neighborhood.
+        while(indices.size() > targetIndexCount){
+            size_t triangleCount = indices.size() / 3;
+
+            // The triangles around each group (a compressed adjacency list)
+            adjacencyOffsets.assign(groupCount + 1, 0);
+            for(unsigned int vertex : indices) ++adjacencyOffsets[groupOf[vertex] + 1];
+            for(size_t group = 0; group < groupCount; ++group) adjacencyOffsets[group + 1] += adjacencyOffsets[group];
+            adjacency.resize(indices.size());
+            cursor.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for(size_t index = 0; index < indices.size(); ++index)
+                adjacency[cursor[groupOf[indices[index]]]++] = (unsigned int)(index / 3);
+
+            // Every edge is evaluated in both directions and the cheaper one is kept
+            edges.clear();
+            for(size_t first = 0; first < indices.size(); first += 3)
+                for(int edge = 0; edge < 3; ++edge)
+                    edges.push_back(edgeKey(groupOf[indices[first + edge]], groupOf[indices[first + (edge + 1) % 3]]));
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+            collapses.clear();
+            for(std::uint64_t key : edges){
+                unsigned int a = (unsigned int)(key >> 32), b = (unsigned int)(key & 0xFFFFFFFFu);
+                Quadric combined = quadrics[a];
+                combined += quadrics[b];
+                double aOntoB = combined.error(positions[b]), bOntoA = combined.error(positions[a]);
+                if(aOntoB <= bOntoA) collapses.push_back({a, b, aOntoB});
+                else collapses.push_back({b, a, bOntoA});
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& first, const Collapse& second){ return first.cost < second.cost; });
+
+            size_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+            size_t removed = 0;
+            std::fill(locked.begin(), locked.end(), 0);
+            for(const Collapse& collapse : collapses){
+                if(collapse.cost > errorLimit || removed >= trianglesToRemove) break;
+                if(locked[collapse.from] || locked[collapse.to]) continue;
+
+                // Reject the collapse if it flips any of the remaining triangles around "from"
+                bool flips = false;
+                size_t collapsedTriangles = 0;
+                for(unsigned int k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1] && !flips; ++k){
+                    size_t first = (size_t)adjacency[k] * 3;
+                    unsigned int g[3] = {groupOf[indices[first]], groupOf[indices[first + 1]], groupOf[indices[first + 2]]};
+                    if(g[0] == collapse.to || g[1] == collapse.to || g[2] == collapse.to){
+                        ++collapsedTriangles;
+                        continue;
+                    }
+                    glm::dvec3 before = glm::cross(positions[g[1]] - positions[g[0]], positions[g[2]] - positions[g[0]]);
+                    for(auto& group : g) if(group == collapse.from) group = collapse.to;
+                    glm::dvec3 after = glm::cross(positions[g[1]] - positions[g[0]], positions[g[2]] - positions[g[0]]);
+                    flips = glm::dot(before, after) <= 0.0;
+                }
+                if(flips) continue;
+
+                target[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                maxError = std::max(maxError, collapse.cost);
+                removed += collapsedTriangles;
+                for(unsigned int k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1]; ++k){
+                    size_t first = (size_t)adjacency[k] * 3;
+                    for(int corner = 0; corner < 3; ++corner) locked[groupOf[indices[first + corner]]] = 1;
+                }
+                locked[collapse.to] = 1;
+            }
+            if(removed == 0) break;
+
+            // Move the indices of the collapsed groups and remove the triangles that became degenerate
+            std::fill(replacement.begin(), replacement.end(), std::numeric_limits<unsigned int>::max());
+            size_t written = 0;
+            for(size_t first = 0; first < indices.size(); first += 3){
+                unsigned int triangle[3], groups[3];
+                for(int corner = 0; corner < 3; ++corner){
+                    triangle[corner] = indices[first + corner];
+                    groups[corner] = find(groupOf[triangle[corner]]);
+                }
+                if(groups[0] == groups[1] || groups[1] == groups[2] || groups[2] == groups[0]) continue;
+                for(int corner = 0; corner < 3; ++corner){
+                    if(groups[corner] != groupOf[triangle[corner]]) triangle[corner] = pickWedge(triangle[corner], groups[corner]);
+                    indices[written++] = triangle[corner];
+                }
+            }
+            indices.resize(written);
+        }
+
+        if(resultError) *resultError = (float)(std::sqrt(maxError) / extent);
+        return indices;
+    }
+
+    std::vector<MeshLOD> generateLODs(const std::vector<Vertex>& vertices, std::vector<unsigned int>& elements,
+                                      int count, size_t minTriangles){
+        PROFILE_ZONE("mesh_utils::generateLODs");
+        std::vector<MeshLOD> lods = {{0, (GLsizei)elements.size(), 0.0f}};
+        // Each level is simplified from the previous one (which is faster than starting from the full mesh every time)
+        std::vector<unsigned int> current = elements;
+        float error = 0.0f;
+        for(int level = 1; level <= count; ++level){
+            size_t targetIndexCount = current.size() / 6 * 3;
+            if(targetIndexCount / 3 < minTriangles) break;
+            // Coarser levels are seen from further away, so each level may deviate twice as much as the previous one
+            float levelError = 0.0f;
+            std::vector<unsigned int> next = simplify(vertices, current, targetIndexCount, 0.01f * float(1 << level), &levelError);
+            // If the error limit stopped the simplification early, a new level wouldn't save much
+            if(next.size() > current.size() * 3 / 4) break;
+            error += levelError;
+            lods.push_back({(GLsizei)elements.size(), (GLsizei)next.size(), error});
+            elements.insert(elements.end(), next.begin(), next.end());
+            current = std::move(next);
+        }
+        return lods;
+    }
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "mesh.hpp"
+
+#include <vector>
+
+namespace our::mesh_utils {
+
+    // Simplifies a triangle list by collapsing edges in the order of their quadric error (Garland & Heckbert).
+    // The vertices are never modified: an edge collapse moves one end onto the other, so the result is a new list of indices
+    // into the same vertices. Vertices that share a position (e.g. at texture seams) are collapsed together, and each moved
+    // index picks the vertex at the new position whose attributes are the closest.
+    // Simplification stops once the result has at most "targetIndexCount" indices or when the next collapse would cause an error
+    // larger than "targetError" (relative to the mesh size). If "resultError" is given, it receives the error of the result.
+    std::vector<unsigned int> simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& elements,
+                                       size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+    // Appends up to "count" coarser levels of detail to the elements (each one has about half the triangles of the previous one)
+    // and returns the ranges of all the levels (including the original one) to be given to the Mesh constructor.
+    // The chain stops early if a level can't be simplified much further or if it would have fewer than "minTriangles" triangles.
+    std::vector<MeshLOD> generateLODs(const std::vector<Vertex>& vertices, std::vector<unsigned int>& elements,
+                                      int count, size_t minTriangles = 64);
+
+}
@@ -1,4 +1,6 @@
 #include "mesh-utils.hpp"
+#include "mesh-simplify.hpp"
+#include "../profiling/cpu-profiler.hpp"
 
 // We will use "Tiny OBJ Loader" to read and process '.obj" files
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -8,7 +10,8 @@
 #include <vector>
 #include <unordered_map>
 
-our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename) {
+our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename, int lodCount) {
+    PROFILE_ZONE("mesh_utils::loadOBJ");
 
     // The data that we will use to initialize our mesh
     std::vector<our::Vertex> vertices;
@@ -81,7 +84,10 @@ our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename) {
         }
     }
 
-    return new our::Mesh(vertices, elements);
+    // The levels of detail are appended to the elements and share the same vertices
+    std::vector<our::MeshLOD> lods;
+    if (lodCount > 0) lods = generateLODs(vertices, elements, lodCount);
+    return new our::Mesh(vertices, elements, lods);
 }
 
 // Create a sphere (the vertex order in the triangles are CCW from the outside)
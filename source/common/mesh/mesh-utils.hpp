@@ -5,7 +5,8 @@
 
 namespace our::mesh_utils {
     // Load an ".obj" file into the mesh
-    Mesh* loadOBJ(const std::string& filename);
+    // If lodCount > 0, up to lodCount simplified levels of detail are generated too (see "generateLODs" in "mesh-simplify.hpp")
+    Mesh* loadOBJ(const std::string& filename, int lodCount = 0);
     // Create a sphere (the vertex order in the triangles are CCW from the outside)
     // Segments define the number of divisions on the both the latitude and the longitude
     Mesh* sphere(const glm::ivec2& segments);
@@ -2,6 +2,10 @@
 
 #include <glad/gl.h>
 #include "vertex.hpp"
+#include "../gl/state-cache.hpp"
+
+#include <algorithm>
+#include <vector>
 
 namespace our {
 
@@ -10,6 +14,14 @@ namespace our {
     #define ATTRIB_LOC_TEXCOORD 2
     #define ATTRIB_LOC_NORMAL   3
 
+    // A level of detail of a mesh is a range of its element buffer. All the levels share the same vertex buffer,
+    // so a coarser level only needs fewer indices (see "mesh_utils::generateLODs").
+    struct MeshLOD {
+        GLsizei offset;     // The index of the first element of the level
+        GLsizei count;      // The number of elements of the level
+        float error;        // The simplification error relative to the mesh size (0 for the full resolution level)
+    };
+
     class Mesh {
         // Here, we store the object names of the 3 main components of a mesh:
         // A vertex array object, A vertex buffer and an element buffer
@@ -17,6 +29,13 @@ namespace our {
         unsigned int VAO;
         // We need to remember the number of elements that will be draw by glDrawElements 
         GLsizei elementCount;
+        // The number of vertices is only kept for statistics (e.g. estimating the memory used by the mesh)
+        GLsizei vertexCount;
+        // The levels of detail (the first one is the full resolution mesh)
+        std::vector<MeshLOD> lods;
+        // A sphere that bounds the vertices in the local space (used to estimate how big the mesh is on the screen)
+        glm::vec3 boundingCenter = glm::vec3(0.0f);
+        float boundingRadius = 0.0f;
     public:
 
         // The constructor takes two vectors:
@@ -26,7 +45,9 @@ namespace our {
         // a vertex buffer to store the vertex data on the VRAM,
         // an element buffer to store the element data on the VRAM,
         // a vertex array object to define how to read the vertex & element buffer during rendering 
-        Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& elements)
+        // - lods (optional) which splits the elements into levels of detail. If empty, all the elements form a single level.
+        Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& elements, const std::vector<MeshLOD>& lods = {})
+            : lods(lods)
         {
             //TODO: (Req 2) Write this function
             // remember to store the number of elements in "elementCount" since you will need it for drawing
@@ -34,6 +55,20 @@ namespace our {
             
             elementCount=elements.size();
             int verticesCount=vertices.size();
+            vertexCount=verticesCount;
+            if(this->lods.empty()) this->lods.push_back({0, elementCount, 0.0f});
+
+            // The bounding sphere is centered at the center of the bounding box (which is close enough to the smallest sphere)
+            if(!vertices.empty()){
+                glm::vec3 minimum = vertices[0].position, maximum = vertices[0].position;
+                for(const auto& vertex : vertices){
+                    minimum = glm::min(minimum, vertex.position);
+                    maximum = glm::max(maximum, vertex.position);
+                }
+                boundingCenter = (minimum + maximum) * 0.5f;
+                for(const auto& vertex : vertices)
+                    boundingRadius = std::max(boundingRadius, glm::distance(boundingCenter, vertex.position));
+            }
             //Vertex buffers are used for storing vertices data.
             //generate a buffer object and store its ID in the variable VBO.
             //The parameter '1' represents that we need only 1 buffer
@@ -67,7 +102,7 @@ namespace our {
             //OpenGl usually Binds objects before using it
             //So any coming instructions will be about VAO until it is unbound or another VAO is bound.
             //any subsequent calls to draw commands will use the vertex data stored in this VAO.
-            glBindVertexArray(VAO);
+            GLStateCache::current().bindVertexArray(VAO);
 
             //enables the vertex attribute array for the position attribute to recieve the data that will be sent (else: it will always recieve 0).
             //the position data for each vertex will be read from a buffer object and passed to the shader program
@@ -150,31 +185,58 @@ namespace our {
             glBufferData(GL_ELEMENT_ARRAY_BUFFER,elementCount*sizeof(unsigned int),(void*)(elements.data()),GL_STATIC_DRAW);//GL_STATIC_DRAW==I won't change it and I will use it in drawing
         }
 
-        // this function should render the mesh
-        void draw() 
+        // this function should render the mesh at the given level of detail (0 is the full resolution)
+        void draw(int lod = 0) 
         {
+            const MeshLOD& level = lods[std::clamp(lod, 0, (int)lods.size() - 1)];
             //binds the vertex array object (VAO) to the current OpenGL context.
             //OpenGl usually Binds objects before using it
             //So any coming instructions will be about VAO until it is unbound or another VAO is bound.
             //any subsequent vertex attribute data that is passed to OpenGL will be stored in the VAO.
-            glBindVertexArray(VAO);
+            //The bind is skipped if the VAO is already bound (e.g. the same mesh is drawn multiple times in a row).
+            GLStateCache::current().bindVertexArray(VAO);
             //This function draws a set of triangles specified by an array of indices.
             //The first parameter specifies the type of primitive to be drawn, in this case triangles.
             //The second parameter specifies the number of elements (indices) in the index array.
             //The third parameter specifies the data type of the elements
             //The fourth parameter represents a pointer to the start of the index array.
-            //(void*)0 start from the beginning of the element buffer
-            glDrawElements(GL_TRIANGLES, elementCount, GL_UNSIGNED_INT, (void*)0);
+            //The offset of the level in the element buffer (in bytes) is where its indices start
+            glDrawElements(GL_TRIANGLES, level.count, GL_UNSIGNED_INT, (void*)(level.offset * sizeof(unsigned int)));
+            GLStateCache::current().countDraw(level.count / 3);
             //TODO: (Req 2) Write this function
         }
 
+        // The number of elements in the element buffer (all the levels of detail together)
+        GLsizei getElementCount() const { return elementCount; }
+        GLsizei getVertexCount() const { return vertexCount; }
+        const std::vector<MeshLOD>& getLODs() const { return lods; }
+        int getLODCount() const { return (int)lods.size(); }
+        glm::vec3 getBoundingCenter() const { return boundingCenter; }
+        float getBoundingRadius() const { return boundingRadius; }
+
+        // Reads the vertices and the elements of a level of detail back from the GPU since the mesh doesn't keep them on the RAM.
+        // This stalls until the GPU is done with the buffers, so it is only meant for processing the meshes at load time.
+        // The elements of a coarser level index into all the vertices, so all the vertices are returned whatever the level is.
+        void readBack(std::vector<Vertex>& vertices, std::vector<unsigned int>& elements, int lod = 0) const
+        {
+            const MeshLOD& level = lods[std::clamp(lod, 0, (int)lods.size() - 1)];
+            vertices.resize(vertexCount);
+            elements.resize(level.count);
+            // The copy target is used so that neither the array buffer binding nor the element buffer of the bound VAO change
+            glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertexCount * sizeof(Vertex), vertices.data());
+            glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, level.offset * sizeof(unsigned int), level.count * sizeof(unsigned int), elements.data());
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+
         // this function should delete the vertex & element buffers and the vertex array object
         ~Mesh(){
 
             //1-Unbind all arrays to ensure that no objects are left bound when starting a new pass or when switching to another rendering context.
             
             //unbinds the currently bound vertex array object.
-            glBindVertexArray(0);
+            GLStateCache::current().bindVertexArray(0);
             //unbinds the currently bound element array buffer.
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
             //unbinds the currently bound array buffer. 
@@ -190,6 +252,7 @@ namespace our {
             //delete vertex array object (VAO)
             //the first parameter specifies the number of vertex arrays to be deleted
             //the second parameter is a pointer to the array to be deleted.
+            GLStateCache::current().onVertexArrayDeleted(VAO);
             glDeleteVertexArrays(1, &VAO);
         }
  
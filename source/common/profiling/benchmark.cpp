@@ -0,0 +1,202 @@
+#include "benchmark.hpp"
+#include "../components/camera.hpp"
+#include "../deserialize-utils.hpp"
+#include "../ecs/world.hpp"
+#include "../gl/state-cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace our {
+
+    void CameraPath::deserialize(const nlohmann::json& config){
+        if(!config.is_object()) return;
+        duration = std::max(config.value("duration", duration), 1e-3);
+        loop = config.value("loop", loop);
+        keyframes.clear();
+        if(config.contains("keyframes") && config["keyframes"].is_array()){
+            for(auto& item : config["keyframes"]){
+                Keyframe keyframe;
+                keyframe.position = item.value("position", glm::vec3(0.0f));
+                // Without a target, the camera looks down the -Z axis like an entity with no rotation
+                keyframe.target = item.value("target", keyframe.position + glm::vec3(0.0f, 0.0f, -1.0f));
+                keyframes.push_back(keyframe);
+            }
+        }
+    }
+
+    CameraPath::Keyframe CameraPath::evaluate(double time) const {
+        int count = (int)keyframes.size();
+        if(count == 1) return keyframes[0];
+        // A looping path has a segment from the last keyframe back to the first one
+        int segments = loop ? count : count - 1;
+        double position = time / duration * segments;
+        position = loop ? position - std::floor(position / segments) * segments : std::clamp(position, 0.0, (double)segments);
+        int segment = std::min((int)position, segments - 1);
+        float t = (float)(position - segment);
+
+        // The neighbours of the segment's ends shape the tangents. At the ends of an open path, the end keyframe is repeated.
+        auto at = [&](int index) -> const Keyframe& {
+            if(loop) return keyframes[((index % count) + count) % count];
+            return keyframes[std::clamp(index, 0, count - 1)];
+        };
+        const Keyframe &k0 = at(segment - 1), &k1 = at(segment), &k2 = at(segment + 1), &k3 = at(segment + 2);
+        auto catmullRom = [t](glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3){
+            return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t * t + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t * t * t);
+        };
+        return {catmullRom(k0.position, k1.position, k2.position, k3.position), catmullRom(k0.target, k1.target, k2.target, k3.target)};
+    }
+
+    void Benchmark::deserialize(const nlohmann::json& config){
+        if(!config.is_object()) return;
+        settings.warmupFrames = std::max(config.value("warmupFrames", settings.warmupFrames), 0);
+        settings.frames = std::max(config.value("frames", settings.frames), 1);
+        settings.timeStep = std::max(config.value("timeStep", settings.timeStep), 0.0);
+        settings.reportPath = config.value("report", settings.reportPath);
+        if(config.contains("camera")) cameraPath.deserialize(config["camera"]);
+    }
+
+    double Benchmark::beginFrame(double realDeltaTime){
+        ++frame;
+        recorded = false;
+        double deltaTime = settings.timeStep > 0 ? settings.timeStep : realDeltaTime;
+        // The first frame starts the clock of the camera path
+        if(frame > 0) time += deltaTime;
+        return deltaTime;
+    }
+
+    void Benchmark::recordFrame(const PerformanceHUD::FrameRecord& record){
+        recorded = true;
+        if(!isMeasuring()) return;
+        drawCalls.push_back(record.drawCalls);
+        triangles.push_back(record.triangles);
+        stateChanges.push_back(record.stateChanges);
+        for(auto& [name, milliseconds] : record.systems)
+            systemTimes[name].push_back(milliseconds);
+        for(auto& [name, milliseconds] : record.gpuPasses){
+            // The GPU timer reports the whole frame as the pass "frame" (it has no results during the first few frames)
+            if(name == "frame") gpuTimes.push_back(milliseconds);
+            else gpuPassTimes[name].push_back(milliseconds);
+        }
+    }
+
+    void Benchmark::endFrame(float cpuMilliseconds, float frameMilliseconds){
+        // If the state didn't record its statistics, we get the draw counts from the state cache ourselves
+        if(!recorded){
+            GLStateCache& cache = GLStateCache::current();
+            if(isMeasuring()){
+                drawCalls.push_back(cache.getCounters().drawCalls);
+                triangles.push_back(cache.getCounters().triangles);
+                stateChanges.push_back(cache.getCounters().issued);
+            }
+            cache.resetCounters();
+        }
+        if(!isMeasuring()) return;
+        cpuTimes.push_back(cpuMilliseconds);
+        frameTimes.push_back(frameMilliseconds);
+    }
+
+    void Benchmark::moveCamera(World* world) const {
+        for(auto entity : world->getEntities()){
+            if(!entity->getComponent<CameraComponent>()) continue;
+            CameraPath::Keyframe keyframe = cameraPath.evaluate(time);
+            entity->localTransform.position = keyframe.position;
+            // An entity with no rotation looks down -Z, so the yaw & pitch are the angles that turn -Z into the view direction
+            glm::vec3 direction = keyframe.target - keyframe.position;
+            if(glm::length(direction) > 1e-6f){
+                float yaw = std::atan2(-direction.x, -direction.z);
+                float pitch = std::atan2(direction.y, glm::length(glm::vec2(direction.x, direction.z)));
+                entity->localTransform.rotation = glm::vec3(pitch, yaw, 0.0f);
+            }
+            return;
+        }
+    }
+
+    nlohmann::json Benchmark::summarize(std::vector<float> samples){
+        if(samples.empty()) return nullptr;
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for(float sample : samples) sum += sample;
+        auto percentile = [&](double p){ return samples[std::min((size_t)(p * samples.size()), samples.size() - 1)]; };
+        return {
+            {"min", samples.front()},
+            {"average", sum / samples.size()},
+            {"p50", percentile(0.50)},
+            {"p90", percentile(0.90)},
+            {"p95", percentile(0.95)},
+            {"p99", percentile(0.99)},
+            {"max", samples.back()},
+        };
+    }
+
+    nlohmann::json Benchmark::summarize(const std::vector<std::uint64_t>& samples){
+        if(samples.empty()) return nullptr;
+        std::uint64_t sum = 0, largest = 0;
+        for(auto sample : samples){
+            sum += sample;
+            largest = std::max(largest, sample);
+        }
+        return {{"average", (double)sum / samples.size()}, {"max", largest}};
+    }
+
+    std::size_t Benchmark::getPeakMemory(){
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.PeakWorkingSetSize;
+        return 0;
+#else
+        rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+        return (std::size_t)usage.ru_maxrss; // in bytes on macOS
+#else
+        return (std::size_t)usage.ru_maxrss * 1024; // in kilobytes on Linux
+#endif
+#endif
+    }
+
+    bool Benchmark::writeReport(const nlohmann::json& environment) const {
+        nlohmann::json report = environment;
+        report["warmupFrames"] = settings.warmupFrames;
+        report["frames"] = (int)frameTimes.size();
+        report["timeStep"] = settings.timeStep;
+        report["cameraPath"] = hasCameraPath();
+        if(!sceneDescription.is_null()) report["sceneDescription"] = sceneDescription;
+        // All the times are in milliseconds
+        report["startupTime"] = startupMilliseconds;
+        report["frameTime"] = summarize(frameTimes);
+        report["cpuTime"] = summarize(cpuTimes);
+        report["gpuTime"] = summarize(gpuTimes);
+        report["systems"] = nlohmann::json::object();
+        for(auto& [name, samples] : systemTimes) report["systems"][name] = summarize(samples);
+        report["gpuPasses"] = nlohmann::json::object();
+        for(auto& [name, samples] : gpuPassTimes) report["gpuPasses"][name] = summarize(samples);
+        report["drawCalls"] = summarize(drawCalls);
+        report["triangles"] = summarize(triangles);
+        report["stateChanges"] = summarize(stateChanges);
+        report["peakMemoryMB"] = getPeakMemory() / (1024.0 * 1024.0);
+
+        std::error_code ec;
+        auto directory = std::filesystem::path(settings.reportPath).parent_path();
+        if(!directory.empty()) std::filesystem::create_directories(directory, ec);
+        std::ofstream out(settings.reportPath);
+        if(!out){
+            std::cerr << "ERROR: Couldn't open the benchmark report file: " << settings.reportPath << std::endl;
+            return false;
+        }
+        out << report.dump(4) << std::endl;
+        return (bool)out;
+    }
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "performance-hud.hpp"
+
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace our {
+
+    class World;
+
+    // A camera path is a Catmull-Rom spline through a list of keyframes. Each keyframe has a position and a target (the point
+    // the camera looks at) and both are interpolated, so the camera glides through the keyframes without sudden turns.
+    // The keyframes are evenly spread over the duration of the path.
+    class CameraPath {
+    public:
+        struct Keyframe {
+            glm::vec3 position;
+            glm::vec3 target;
+        };
+
+    private:
+        std::vector<Keyframe> keyframes;
+        double duration = 10.0; // in seconds
+        bool loop = true;       // If true, the camera goes back to the first keyframe at the end, otherwise it stays at the last one
+
+    public:
+        // Reads the path: {"duration": 10, "loop": true, "keyframes": [{"position": [x, y, z], "target": [x, y, z]}, ...]}
+        void deserialize(const nlohmann::json& config);
+
+        bool empty() const { return keyframes.empty(); }
+
+        // Returns the position and the target of the camera at the given time (in seconds)
+        Keyframe evaluate(double time) const;
+    };
+
+    // The benchmark mode runs a scene for a fixed number of frames and writes a JSON report of its performance so that
+    // different builds (or machines) can be compared. The first "warmupFrames" frames are ignored (shader compilation,
+    // first texture uploads, filling the caches, ...), then "frames" frames are measured.
+    // To make the runs repeatable, the states get a fixed time step instead of the real frame time (so the simulation
+    // is the same whatever the speed of the machine) and the camera can follow a scripted path instead of the user input.
+    // The application measures the frame times, while the states may record their own statistics (per-system times,
+    // GPU passes, draw counts) through "recordFrame". For the states that don't, the draw counts come from the state cache.
+    class Benchmark {
+    public:
+        struct Settings {
+            int warmupFrames = 60;
+            int frames = 600;
+            // The delta time (in seconds) given to the states. If it is 0, the real frame time is used.
+            double timeStep = 1.0 / 60.0;
+            std::string reportPath = "benchmark.json";
+        } settings;
+
+    private:
+        CameraPath cameraPath;
+
+        // The current frame (counting the warmup frames) and the time since the benchmark started as seen by the states
+        int frame = -1;
+        double time = 0;
+        double startupMilliseconds = 0;
+        nlohmann::json sceneDescription;
+
+        // The measured frames
+        std::vector<float> frameTimes, cpuTimes, gpuTimes;
+        std::vector<std::uint64_t> drawCalls, triangles, stateChanges;
+        std::map<std::string, std::vector<float>> systemTimes, gpuPassTimes;
+        // Whether a state recorded its statistics for the current frame
+        bool recorded = false;
+
+        static nlohmann::json summarize(std::vector<float> samples);
+        static nlohmann::json summarize(const std::vector<std::uint64_t>& samples);
+        // Returns the peak resident memory of the process in bytes (0 if it can't be read on this platform)
+        static std::size_t getPeakMemory();
+
+    public:
+        // Reads the settings from the app config: {"warmupFrames": 60, "frames": 600, "timeStep": 0.01667, "report": "benchmark.json",
+        // "camera": {camera path}} (the "scene" to benchmark is read by main since it replaces the "start-scene")
+        void deserialize(const nlohmann::json& config);
+
+        // How many frames the application should run (warmup included)
+        int getTotalFrames() const { return settings.warmupFrames + settings.frames; }
+        // Whether the current frame is measured (i.e. the warmup is over)
+        bool isMeasuring() const { return frame >= settings.warmupFrames; }
+
+        // The time it took from the start of the application till the first frame (mostly loading the scene) in milliseconds
+        void setStartupTime(double milliseconds) { startupMilliseconds = milliseconds; }
+
+        // Should be called by the application at the start of every frame. Returns the delta time the states should get.
+        double beginFrame(double realDeltaTime);
+        // Called by the states (optionally) once their frame is done to add their statistics to the report
+        void recordFrame(const PerformanceHUD::FrameRecord& record);
+        // Should be called by the application at the end of every frame with the CPU time of the frame (till the buffers are swapped)
+        // and the time of the whole frame (both in milliseconds)
+        void endFrame(float cpuMilliseconds, float frameMilliseconds);
+
+        bool hasCameraPath() const { return !cameraPath.empty(); }
+        // Gives a camera path to follow if the config had none (for the scenes whose size is only known once they are loaded)
+        void setDefaultCameraPath(const nlohmann::json& config) { if(cameraPath.empty()) cameraPath.deserialize(config); }
+        // Describes the scene in the report (e.g. the settings of a generated scene), which is how scaling curves are plotted
+        void setSceneDescription(const nlohmann::json& description) { sceneDescription = description; }
+        // Moves the first camera of the world to its place on the camera path at the current time.
+        // The path is in the space of the camera's parent (the world space if the camera has no parent).
+        void moveCamera(World* world) const;
+
+        // Writes the report. "environment" describes the run (e.g. the renderer & the resolution) and is copied into the report.
+        bool writeReport(const nlohmann::json& environment) const;
+    };
+
+}
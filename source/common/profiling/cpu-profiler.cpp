@@ -0,0 +1,138 @@
+#include "cpu-profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace our::profiler {
+
+    namespace {
+        struct ZoneRecord {
+            const char* name;
+            std::uint64_t start, end;
+            std::uint32_t frame;
+        };
+
+        // Each thread writes to its own buffer so recording never takes a lock.
+        // The buffers are owned by the registry (not by the threads) so that their zones can still be exported after the thread exits.
+        // A thread is registered as soon as it is named, but its zones are only allocated when it records its first zone,
+        // so threads never pay for the ring while the profiler is disabled.
+        struct ThreadBuffer {
+            std::vector<ZoneRecord> zones;
+            std::size_t next = 0;
+            bool wrapped = false;
+            std::uint32_t id;
+            std::string name;
+        };
+
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> registry;
+        std::atomic<std::uint32_t> currentFrame{0};
+        // The time origin of the trace (so that the timestamps are small numbers)
+        const std::uint64_t origin = detail::now();
+
+        thread_local ThreadBuffer* localBuffer = nullptr;
+
+        ThreadBuffer& getLocalBuffer(){
+            if(!localBuffer){
+                std::lock_guard<std::mutex> lock(registryMutex);
+                auto buffer = std::make_unique<ThreadBuffer>();
+                buffer->id = (std::uint32_t)registry.size();
+                buffer->name = buffer->id == 0 ? "main" : "thread " + std::to_string(buffer->id);
+                localBuffer = buffer.get();
+                registry.push_back(std::move(buffer));
+            }
+            return *localBuffer;
+        }
+
+        void writeEscaped(std::ostream& out, const std::string& text){
+            for(char c : text){
+                if(c == '"' || c == '\\') out << '\\';
+                out << c;
+            }
+        }
+    }
+
+    std::atomic<bool> detail::enabled{false};
+
+    std::uint64_t detail::now(){
+        using namespace std::chrono;
+        return (std::uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void detail::record(const char* name, std::uint64_t start, std::uint64_t end){
+        ThreadBuffer& buffer = getLocalBuffer();
+        if(buffer.zones.empty()) buffer.zones.resize(ZONES_PER_THREAD);
+        buffer.zones[buffer.next] = {name, start, end, currentFrame.load(std::memory_order_relaxed)};
+        if(++buffer.next == buffer.zones.size()){
+            buffer.next = 0;
+            buffer.wrapped = true;
+        }
+    }
+
+    void setEnabled(bool enabled){
+        detail::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void setFrame(std::uint32_t frame){
+        currentFrame.store(frame, std::memory_order_relaxed);
+    }
+
+    std::uint32_t getFrame(){
+        return currentFrame.load(std::memory_order_relaxed);
+    }
+
+    void setThreadName(const std::string& name){
+        ThreadBuffer& buffer = getLocalBuffer();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer.name = name;
+    }
+
+    bool writeChromeTrace(const std::string& path, std::uint32_t firstFrame, std::uint32_t lastFrame){
+        std::ofstream out(path);
+        if(!out){
+            std::cerr << "ERROR: Couldn't open the trace file: " << path << std::endl;
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(registryMutex);
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        auto separator = [&](){ if(!first) out << ",\n"; first = false; };
+        for(auto& buffer : registry){
+            separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"";
+            writeEscaped(out, buffer->name);
+            out << "\"}}";
+            std::size_t count = buffer->wrapped ? buffer->zones.size() : buffer->next;
+            for(std::size_t index = 0; index < count; ++index){
+                const ZoneRecord& zone = buffer->zones[index];
+                if(zone.frame < firstFrame || zone.frame > lastFrame) continue;
+                separator();
+                // Chrome traces use microseconds
+                out << "{\"name\":\"";
+                writeEscaped(out, zone.name);
+                out << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                    << ",\"ts\":" << (zone.start - origin) / 1000.0
+                    << ",\"dur\":" << (zone.end - zone.start) / 1000.0
+                    << ",\"args\":{\"frame\":" << zone.frame << "}}";
+            }
+        }
+        out << "\n]}\n";
+        return (bool)out;
+    }
+
+    void clear(){
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for(auto& buffer : registry){
+            buffer->next = 0;
+            buffer->wrapped = false;
+        }
+    }
+
+}
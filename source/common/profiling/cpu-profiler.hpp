@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// The CPU profiler records named time ranges ("zones") into a ring buffer owned by the thread that recorded them.
+// A zone is opened by one of the macros below and it closes when the enclosing scope ends:
+//
+//     void MovementSystem::update(...){
+//         PROFILE_ZONE("MovementSystem::update");
+//         ...
+//     }
+//
+// The zone name must be a string literal (only the pointer is stored).
+// If ENABLE_CPU_PROFILER is not defined, the macros compile to nothing. Otherwise, while the profiler is disabled at runtime
+// (the default), opening a zone only costs a relaxed atomic load and a branch.
+// The recorded zones can be exported as a Chrome trace (open it in chrome://tracing or https://ui.perfetto.dev).
+namespace our::profiler {
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+        // Returns the current time in nanoseconds (steady_clock is used since it is monotonic and portable, unlike rdtsc)
+        std::uint64_t now();
+        // Stores a zone in the buffer of the calling thread
+        void record(const char* name, std::uint64_t start, std::uint64_t end);
+    }
+
+    // Whether zones are recorded. This can be toggled at any time.
+    inline bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+
+    // Sets the index of the current frame. Every zone stores the frame in which it started so that a frame range can be exported.
+    void setFrame(std::uint32_t frame);
+    std::uint32_t getFrame();
+
+    // Gives a name to the calling thread in the exported trace (e.g. "main", "worker 1")
+    void setThreadName(const std::string& name);
+
+    // Writes the zones that started in the frames [firstFrame, lastFrame] to a file in the Chrome "trace_event" JSON format.
+    // Zones from all threads are included, so no other thread should be recording while this runs.
+    // Each thread keeps the last ZONES_PER_THREAD zones only, so very long ranges may lose their oldest zones.
+    bool writeChromeTrace(const std::string& path, std::uint32_t firstFrame, std::uint32_t lastFrame);
+    // Removes all the recorded zones
+    void clear();
+
+    // The capacity of the ring buffer of each thread
+    constexpr std::size_t ZONES_PER_THREAD = 1 << 16;
+
+    // A zone records the time between its construction and its destruction
+    class Zone {
+        const char* name;
+        std::uint64_t start = 0;
+        bool active;
+    public:
+        explicit Zone(const char* name) : name(name), active(isEnabled()) {
+            if(active) start = detail::now();
+        }
+        ~Zone() {
+            if(active) detail::record(name, start, detail::now());
+        }
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    };
+
+}
+
+#if defined(ENABLE_CPU_PROFILER)
+    #define OUR_PROFILE_CONCAT_IMPL(a, b) a##b
+    #define OUR_PROFILE_CONCAT(a, b) OUR_PROFILE_CONCAT_IMPL(a, b)
+    // Opens a zone with the given name till the end of the current scope
+    #define PROFILE_ZONE(name) ::our::profiler::Zone OUR_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+    #define PROFILE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,178 @@
+#include "performance-hud.hpp"
+#include "../asset-loader.hpp"
+#include "../ecs/world.hpp"
+#include "../gl/state-cache.hpp"
+#include "../mesh/mesh.hpp"
+#include "../systems/forward-renderer.hpp"
+#include "../texture/texture-array.hpp"
+#include "../texture/texture2d.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+
+namespace our {
+
+    void PerformanceHUD::deserialize(const nlohmann::json& config){
+        if(!config.is_object()) return;
+        visible = config.value("visible", visible);
+        hitchThreshold = config.value("hitchThreshold", hitchThreshold);
+    }
+
+    void PerformanceHUD::beginFrame(double deltaTime){
+        // The time between the start of the previous frame and the start of this one is the duration of the previous frame
+        if(hasPrevious){
+            previous.frameTime = (float)(deltaTime * 1000.0);
+            frameTimes[nextFrameTime] = previous.frameTime;
+            nextFrameTime = (nextFrameTime + 1) % HISTORY_SIZE;
+            frameTimeCount = std::min(frameTimeCount + 1, HISTORY_SIZE);
+            if(previous.frameTime > hitchThreshold){
+                if((int)hitches.size() == MAX_HITCHES) hitches.pop_front();
+                hitches.push_back(previous);
+            }
+        }
+        current = FrameRecord();
+        current.frame = frameCounter++;
+    }
+
+    void PerformanceHUD::recordSystem(const char* name, float milliseconds){
+        current.systems.emplace_back(name, milliseconds);
+    }
+
+    void PerformanceHUD::endFrame(World* world, ForwardRenderer* renderer){
+        GLStateCache& cache = GLStateCache::current();
+        const auto& counters = cache.getCounters();
+        current.drawCalls = counters.drawCalls;
+        current.triangles = counters.triangles;
+        current.stateChanges = counters.issued;
+        current.elidedStateChanges = counters.elided;
+        cache.resetCounters();
+
+        if(world) current.entities = world->getEntities().size();
+        if(renderer){
+            current.opaqueCommands = renderer->getOpaqueCommandCount();
+            current.transparentCommands = renderer->getTransparentCommandCount();
+            current.lights = renderer->getLightCount();
+            current.impostors = renderer->getImpostorCount();
+            // Only the passes are copied (not the whole statistics) to keep the hitch records small
+            for(auto& pass : renderer->getGPUTimer().getStatistics())
+                current.gpuPasses.emplace_back(pass.name, pass.last);
+        }
+        previous = std::move(current);
+        hasPrevious = true;
+    }
+
+    void PerformanceHUD::estimateVRAM(){
+        // Texture2D doesn't remember its size, so we ask OpenGL. We assume 4 bytes per pixel since all our images are loaded as RGBA8.
+        textureBytes = 0;
+        for(auto& [name, texture] : AssetLoader<Texture2D>::getAll()){
+            texture->bind();
+            GLint width = 0, height = 0, mipWidth = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 1, GL_TEXTURE_WIDTH, &mipWidth);
+            size_t bytes = (size_t)width * height * 4;
+            // A full mip chain adds about a third to the size of the first level
+            textureBytes += mipWidth > 0 ? bytes * 4 / 3 : bytes;
+        }
+        for(auto& [name, array] : AssetLoader<TextureArray>::getAll()){
+            size_t bytes = (size_t)array->getSize().x * array->getSize().y * array->getLayerCount() * 4;
+            textureBytes += bytes * 4 / 3;
+        }
+        // Each vertex has a position, a color, a texture coordinate and a normal (see Vertex) and each element is an unsigned int
+        meshBytes = 0;
+        for(auto& [name, mesh] : AssetLoader<Mesh>::getAll())
+            meshBytes += (size_t)mesh->getVertexCount() * sizeof(Vertex) + (size_t)mesh->getElementCount() * sizeof(unsigned int);
+        lastVRAMUpdate = std::chrono::steady_clock::now();
+    }
+
+    void PerformanceHUD::drawFrameRecord(const FrameRecord& record){
+        ImGui::Text("Frame %d: %.2f ms", record.frame, record.frameTime);
+        ImGui::Text("Draw calls: %llu, Triangles: %llu", (unsigned long long)record.drawCalls, (unsigned long long)record.triangles);
+        ImGui::Text("State changes: %llu issued, %llu elided", (unsigned long long)record.stateChanges, (unsigned long long)record.elidedStateChanges);
+        ImGui::Text("Entities: %zu, Commands: %zu opaque + %zu transparent, Impostors: %zu, Lights: %zu",
+            record.entities, record.opaqueCommands, record.transparentCommands, record.impostors, record.lights);
+        ImGui::Columns(2, nullptr, false);
+        for(auto& [name, milliseconds] : record.systems){
+            ImGui::Text("%s", name); ImGui::NextColumn();
+            ImGui::Text("%.3f ms", milliseconds); ImGui::NextColumn();
+        }
+        for(auto& [name, milliseconds] : record.gpuPasses){
+            ImGui::Text("GPU: %s", name.c_str()); ImGui::NextColumn();
+            ImGui::Text("%.3f ms", milliseconds); ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+    }
+
+    void PerformanceHUD::draw(ForwardRenderer* renderer){
+        if(!visible) return;
+        if(std::chrono::steady_clock::now() - lastVRAMUpdate > std::chrono::seconds(1)) estimateVRAM();
+
+        ImGui::Begin("Performance", &visible);
+
+        // The graph shows the frame times from the oldest to the newest, so we start right after the newest sample
+        int offset = frameTimeCount < HISTORY_SIZE ? 0 : nextFrameTime;
+        float largest = 0;
+        for(int index = 0; index < frameTimeCount; ++index) largest = std::max(largest, frameTimes[index]);
+        ImGui::PlotLines("##frame-times", frameTimes.data(), frameTimeCount, offset, "Frame time (ms)",
+            0.0f, std::max(largest, hitchThreshold) * 1.1f, ImVec2(0, 80));
+
+        if(frameTimeCount > 0){
+            std::vector<float> sorted(frameTimes.begin(), frameTimes.begin() + frameTimeCount);
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&](float p){ return sorted[std::min((size_t)(p * sorted.size()), sorted.size() - 1)]; };
+            ImGui::Text("P50: %.2f ms  P95: %.2f ms  P99: %.2f ms  Max: %.2f ms",
+                percentile(0.5f), percentile(0.95f), percentile(0.99f), sorted.back());
+        }
+        ImGui::SliderFloat("Hitch threshold (ms)", &hitchThreshold, 5.0f, 200.0f);
+
+        if(hasPrevious && ImGui::CollapsingHeader("Last frame", ImGuiTreeNodeFlags_DefaultOpen))
+            drawFrameRecord(previous);
+
+        // Unlike the GPU rows of the frame records, these are the statistics of each pass over the last frames
+        if(renderer && ImGui::CollapsingHeader("GPU passes", ImGuiTreeNodeFlags_DefaultOpen)){
+            const GPUTimer& timer = renderer->getGPUTimer();
+            ImGui::Columns(5, "gpu-passes");
+            ImGui::Text("Pass"); ImGui::NextColumn();
+            ImGui::Text("Last"); ImGui::NextColumn();
+            ImGui::Text("Min"); ImGui::NextColumn();
+            ImGui::Text("Avg"); ImGui::NextColumn();
+            ImGui::Text("P99"); ImGui::NextColumn();
+            ImGui::Separator();
+            for(auto& pass : timer.getStatistics()){
+                ImGui::Text("%s", pass.name.c_str()); ImGui::NextColumn();
+                ImGui::Text("%.3f ms", pass.last); ImGui::NextColumn();
+                ImGui::Text("%.3f ms", pass.min); ImGui::NextColumn();
+                ImGui::Text("%.3f ms", pass.average); ImGui::NextColumn();
+                ImGui::Text("%.3f ms", pass.p99); ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+            if(timer.getDroppedFrames() > 0) ImGui::Text("Dropped frames: %d", timer.getDroppedFrames());
+        }
+
+        if(ImGui::CollapsingHeader("Video memory (estimate)", ImGuiTreeNodeFlags_DefaultOpen)){
+            const float MB = 1024.0f * 1024.0f;
+            size_t targetBytes = renderer ? renderer->getRenderTargets().getAllocatedBytes() : 0;
+            ImGui::Text("Textures: %.2f MB", textureBytes / MB);
+            ImGui::Text("Meshes: %.2f MB", meshBytes / MB);
+            ImGui::Text("Render targets: %.2f MB", targetBytes / MB);
+            ImGui::Text("Total: %.2f MB", (textureBytes + meshBytes + targetBytes) / MB);
+        }
+
+        if(ImGui::CollapsingHeader("Hitches")){
+            if(hitches.empty()) ImGui::Text("No frame took longer than %.1f ms", hitchThreshold);
+            // The newest hitch is listed first
+            for(auto it = hitches.rbegin(); it != hitches.rend(); ++it){
+                ImGui::PushID(it->frame);
+                if(ImGui::TreeNode("hitch", "Frame %d (%.2f ms)", it->frame, it->frameTime)){
+                    drawFrameRecord(*it);
+                    ImGui::TreePop();
+                }
+                ImGui::PopID();
+            }
+            if(!hitches.empty() && ImGui::Button("Clear hitches")) hitches.clear();
+        }
+        ImGui::End();
+    }
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../gl/gpu-timer.hpp"
+
+#include <json/json.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace our {
+
+    class World;
+    class ForwardRenderer;
+
+    // An ImGui overlay that shows the performance of the game while it is played:
+    // the frame time graph & percentiles, the CPU time of each system, the GPU time of each pass (last, min, average & p99), the draw & state change counts,
+    // the entity counts and an estimate of the video memory used by the assets and the render targets.
+    // When a frame takes longer than "hitchThreshold", its detailed statistics are kept in a list of hitches so that
+    // intermittent stutters can be inspected after they happen.
+    class PerformanceHUD {
+    public:
+        // How many frames are shown in the graph and used for the percentiles
+        static constexpr int HISTORY_SIZE = 300;
+        // How many hitches are kept (the oldest ones are dropped first)
+        static constexpr int MAX_HITCHES = 16;
+
+        // Everything we know about a frame
+        struct FrameRecord {
+            int frame = 0;
+            float frameTime = 0; // in milliseconds
+            std::vector<std::pair<const char*, float>> systems; // The CPU time of each system in milliseconds
+            std::vector<std::pair<std::string, float>> gpuPasses; // The last GPU time of each pass in milliseconds (these lag a few frames behind)
+            std::uint64_t drawCalls = 0, triangles = 0, stateChanges = 0, elidedStateChanges = 0;
+            std::size_t entities = 0, opaqueCommands = 0, transparentCommands = 0, impostors = 0, lights = 0;
+        };
+
+        // Measures the duration of a scope and records it as the CPU time of a system
+        class ScopedTimer {
+            PerformanceHUD& hud;
+            const char* name;
+            std::chrono::steady_clock::time_point start;
+        public:
+            ScopedTimer(PerformanceHUD& hud, const char* name) : hud(hud), name(name), start(std::chrono::steady_clock::now()) {}
+            ~ScopedTimer() {
+                hud.recordSystem(name, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+        };
+
+        bool visible = false;
+        // Frames that take longer than this (in milliseconds) are captured as hitches
+        float hitchThreshold = 1000.0f / 30.0f;
+
+        // Reads the settings: {"visible": false, "hitchThreshold": milliseconds}
+        void deserialize(const nlohmann::json& config);
+
+        // Should be called at the start of every frame with the time since the last frame started (in seconds)
+        // Since that time is the duration of the previous frame, this is where the previous frame is checked for a hitch
+        void beginFrame(double deltaTime);
+        // Records the CPU time of a system (in milliseconds) for the current frame
+        void recordSystem(const char* name, float milliseconds);
+        // Should be called at the end of every frame (after rendering) to collect the counters of the frame
+        // The state cache counters are reset here so this should be the only place that resets them.
+        void endFrame(World* world, ForwardRenderer* renderer);
+
+        // Draws the overlay (if visible)
+        void draw(ForwardRenderer* renderer);
+
+        const std::deque<FrameRecord>& getHitches() const { return hitches; }
+        // The record of the frame that was ended last (its frame time is only known once the next frame begins)
+        const FrameRecord& getLastFrame() const { return previous; }
+
+    private:
+        FrameRecord current, previous;
+        bool hasPrevious = false;
+        int frameCounter = 0;
+        std::array<float, HISTORY_SIZE> frameTimes{};
+        int nextFrameTime = 0, frameTimeCount = 0;
+        std::deque<FrameRecord> hitches;
+
+        // The video memory estimate is refreshed every second since it needs to query the textures
+        std::size_t textureBytes = 0, meshBytes = 0;
+        std::chrono::steady_clock::time_point lastVRAMUpdate;
+        void estimateVRAM();
+
+        static void drawFrameRecord(const FrameRecord& record);
+    };
+
+}
@@ -0,0 +1,347 @@
+#include "scene-generator.hpp"
+#include "../asset-loader.hpp"
+#include "../components/mesh-renderer.hpp"
+#include "../components/movement.hpp"
+#include "../deserialize-utils.hpp"
+#include "../ecs/world.hpp"
+
+#include <glm/gtx/euler_angles.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace our {
+
+    namespace {
+        // The meshes of the assets from the smallest to the biggest. The scale brings each of them to about one unit.
+        struct MeshAsset {
+            const char* name;
+            const char* path;
+            float scale;
+        };
+        constexpr MeshAsset MESHES[] = {
+            {"cube", "assets/models/cube.obj", 0.5f},
+            {"sphere", "assets/models/sphere.obj", 0.5f},
+            {"monkey", "assets/models/monkey.obj", 0.4f},
+            {"suzanne", "assets/models/Suzanne.obj", 0.4f},
+            {"lamp", "assets/models/lamp.obj", 0.12f},
+            {"bird", "assets/models/bird.obj", 0.02f},
+            {"fish2", "assets/models/fish2.obj", 0.04f},
+            {"snake", "assets/models/snake.obj", 0.03f},
+            {"fish", "assets/models/fish.obj", 1.0f},
+        };
+        constexpr int MESH_COUNT = (int)(sizeof(MESHES) / sizeof(MESHES[0]));
+
+        // The albedo textures of the materials (the materials go through them in turn)
+        constexpr const char* ALBEDOS[] = {
+            "assets/textures/white.jpg", "assets/textures/wood.jpg", "assets/textures/gravel.jpg", "assets/textures/pebbels.jpg",
+            "assets/textures/color-grid.png", "assets/textures/moon.jpg", "assets/textures/road.jpg", "assets/textures/fish.jpg",
+            "assets/textures/bird.jpg", "assets/textures/snake.jpg", "assets/textures/pizza.jpg", "assets/textures/lake.jpg",
+        };
+        constexpr int ALBEDO_COUNT = (int)(sizeof(ALBEDOS) / sizeof(ALBEDOS[0]));
+
+        std::string materialName(int index) { return "material" + std::to_string(index); }
+    }
+
+    void SceneGenerator::deserialize(const nlohmann::json& config){
+        if(!config.is_object()) return;
+        settings.seed = config.value("seed", settings.seed);
+        settings.entities = std::max(config.value("entities", settings.entities), 0);
+        settings.depth = std::max(config.value("depth", settings.depth), 1);
+        settings.branching = std::max(config.value("branching", settings.branching), 1);
+        settings.meshes = std::clamp(config.value("meshes", settings.meshes), 1, MESH_COUNT);
+        settings.materials = std::max(config.value("materials", settings.materials), 1);
+        settings.lights = std::max(config.value("lights", settings.lights), 0);
+        settings.moving = std::clamp(config.value("moving", settings.moving), 0.0f, 1.0f);
+        settings.spacing = std::max(config.value("spacing", settings.spacing), 0.1f);
+        settings.lods = std::max(config.value("lods", settings.lods), 0);
+    }
+
+    bool SceneGenerator::parse(const std::string& list){
+        static const char* KEYS[] = {"seed", "entities", "depth", "branching", "meshes", "materials", "lights", "moving", "spacing", "lods"};
+        nlohmann::json config = nlohmann::json::object();
+        std::istringstream stream(list);
+        std::string item;
+        while(std::getline(stream, item, ',')){
+            if(item.empty()) continue;
+            auto separator = item.find('=');
+            std::string key = item.substr(0, separator);
+            if(separator == std::string::npos || std::find(std::begin(KEYS), std::end(KEYS), key) == std::end(KEYS)){
+                std::cerr << "ERROR: Invalid scene generator setting (expected key=value with a known key): " << item << std::endl;
+                return false;
+            }
+            try {
+                double value = std::stod(item.substr(separator + 1));
+                // The integer settings must be read back as integers by "deserialize"
+                if(key == "moving" || key == "spacing") config[key] = value;
+                else config[key] = (long long)value;
+            } catch(const std::exception&) {
+                std::cerr << "ERROR: Invalid scene generator value: " << item << std::endl;
+                return false;
+            }
+        }
+        deserialize(config);
+        return true;
+    }
+
+    nlohmann::json SceneGenerator::serialize() const {
+        return {
+            {"seed", settings.seed},
+            {"entities", settings.entities},
+            {"depth", settings.depth},
+            {"branching", settings.branching},
+            {"meshes", settings.meshes},
+            {"materials", settings.materials},
+            {"lights", settings.lights},
+            {"moving", settings.moving},
+            {"spacing", settings.spacing},
+            {"lods", settings.lods},
+        };
+    }
+
+    void SceneGenerator::generate(){
+        random.seed(settings.seed);
+        nodes.clear();
+        lights.clear();
+        int count = settings.entities;
+        float size = getSize();
+
+        // The number of entities in a full hierarchy (there is no need to count past the number of entities)
+        long long hierarchySize = 0, levelSize = 1;
+        for(int level = 0; level < settings.depth && hierarchySize < count; ++level){
+            hierarchySize += levelSize;
+            levelSize *= settings.branching;
+        }
+        // Each hierarchy gets a cell of a grid that covers the scene, and its entities are spread over the cell
+        long long roots = hierarchySize > 0 ? (count + hierarchySize - 1) / hierarchySize : 0;
+        int columns = std::max((int)std::ceil(std::sqrt((double)roots)), 1);
+        float cell = size / columns;
+
+        // The transforms of the entities of the current hierarchy in the world space (to make the children relative to their parents)
+        struct Placement {
+            glm::vec3 position;
+            float yaw, scale;
+        };
+        std::vector<Placement> placements;
+        placements.reserve((size_t)std::min<long long>(hierarchySize, count));
+        nodes.reserve(count);
+        for(long long root = 0; root < roots; ++root){
+            glm::vec2 center = glm::vec2(-0.5f * size) + cell * (glm::vec2((float)(root % columns), (float)(root / columns)) + 0.5f);
+            int first = (int)nodes.size();
+            placements.clear();
+            // The entities of a hierarchy are numbered level by level, so the parent of the k-th one is the ((k - 1) / branching)-th one
+            for(long long k = 0; k < hierarchySize && (int)nodes.size() < count; ++k){
+                Node node;
+                node.mesh = (int)(random() % settings.meshes);
+                node.material = (int)(random() % settings.materials);
+                Placement placement;
+                float extent = k == 0 ? 0.25f : 0.5f;
+                placement.position = {center.x + uniform(-extent, extent) * cell, k == 0 ? 0.5f : uniform(0.5f, 2.5f), center.y + uniform(-extent, extent) * cell};
+                placement.yaw = uniform(0.0f, glm::two_pi<float>());
+                placement.scale = MESHES[node.mesh].scale * uniform(0.8f, 1.2f);
+                if(uniform(0.0f, 1.0f) < settings.moving)
+                    node.spin = glm::radians(uniform(20.0f, 90.0f)) * (random() & 1 ? 1.0f : -1.0f);
+
+                if(k == 0){
+                    node.position = placement.position;
+                    node.yaw = placement.yaw;
+                    node.scale = placement.scale;
+                } else {
+                    int parent = (int)((k - 1) / settings.branching);
+                    const Placement& parentPlacement = placements[parent];
+                    node.parent = first + parent;
+                    glm::vec4 offset = glm::yawPitchRoll(-parentPlacement.yaw, 0.0f, 0.0f) * glm::vec4(placement.position - parentPlacement.position, 0.0f);
+                    node.position = glm::vec3(offset) / parentPlacement.scale;
+                    node.yaw = placement.yaw - parentPlacement.yaw;
+                    node.scale = placement.scale / parentPlacement.scale;
+                }
+                placements.push_back(placement);
+                nodes.push_back(node);
+            }
+        }
+
+        for(int index = 0; index < settings.lights; ++index){
+            PointLight light;
+            light.position = {uniform(-0.5f, 0.5f) * size, uniform(3.0f, 6.0f), uniform(-0.5f, 0.5f) * size};
+            light.color = {uniform(0.3f, 1.0f), uniform(0.3f, 1.0f), uniform(0.3f, 1.0f)};
+            lights.push_back(light);
+        }
+    }
+
+    nlohmann::json SceneGenerator::getAssets() const {
+        nlohmann::json assets = {
+            {"shaders", {{"lighted", {{"vs", "assets/shaders/light.vert"}, {"fs", "assets/shaders/light.frag"}}}}},
+            {"textures", {{"black", "assets/textures/black.jpg"}, {"grey", "assets/textures/grey.png"}, {"white", "assets/textures/white.jpg"}}},
+            {"samplers", {{"default", nlohmann::json::object()}}},
+            {"meshes", nlohmann::json::object()},
+            {"materials", nlohmann::json::object()},
+        };
+        for(int index = 0; index < settings.meshes; ++index)
+            assets["meshes"][MESHES[index].name] = {{"path", MESHES[index].path}, {"lods", settings.lods}};
+        for(int index = 0; index < std::min(settings.materials, ALBEDO_COUNT); ++index)
+            assets["textures"]["albedo" + std::to_string(index)] = ALBEDOS[index];
+        for(int index = 0; index < settings.materials; ++index){
+            assets["materials"][materialName(index)] = {
+                {"type", "lighted"},
+                {"shader", "lighted"},
+                {"pipelineState", {{"faceCulling", {{"enabled", true}}}, {"depthTesting", {{"enabled", true}}}}},
+                {"sampler", "default"},
+                {"albedo", "albedo" + std::to_string(index % ALBEDO_COUNT)},
+                {"specular", "white"},
+                {"roughness", "grey"},
+                {"ambient_occlusion", "black"},
+            };
+        }
+        return assets;
+    }
+
+    nlohmann::json SceneGenerator::getCameraAndLightsData() const {
+        float size = getSize();
+        // The camera stands at the south of the scene and looks down at its center
+        float height = 0.35f * size + 10.0f, distance = 0.5f * size + 10.0f;
+        float speed = std::max(8.0f, 0.05f * size);
+        nlohmann::json entities = nlohmann::json::array();
+        entities.push_back({
+            {"name", "camera"},
+            {"position", {0.0f, height, distance}},
+            {"rotation", {-glm::degrees(std::atan2(height, distance)), 0.0f, 0.0f}},
+            {"components", {
+                {{"type", "Camera"}, {"near", 0.1f}, {"far", std::max(100.0f, 2.0f * size + 100.0f)}},
+                {{"type", "Free Camera Controller"}, {"positionSensitivity", {speed, speed, speed}}},
+            }},
+        });
+        entities.push_back({
+            {"name", "sun"},
+            {"components", {{{"type", "Light"}, {"lightType", "directional"}, {"direction", {-1, -2, -1}},
+                             {"diffuse", {0.7, 0.7, 0.6}}, {"specular", {0.7, 0.7, 0.6}}}}},
+        });
+        for(auto& light : lights){
+            glm::vec3 color = light.color;
+            entities.push_back({
+                {"position", {light.position.x, light.position.y, light.position.z}},
+                {"components", {{{"type", "Light"}, {"lightType", "point"}, {"diffuse", {color.r, color.g, color.b}},
+                                 {"specular", {color.r, color.g, color.b}}, {"attenuation", {0.02, 0.1, 1}}}}},
+            });
+        }
+        return entities;
+    }
+
+    nlohmann::json SceneGenerator::getCameraPath() const {
+        // Catmull-Rom through 8 points is close enough to a circle
+        constexpr int KEYFRAMES = 8;
+        float size = getSize();
+        float radius = 0.5f * size + 10.0f, height = 0.25f * size + 8.0f;
+        nlohmann::json keyframes = nlohmann::json::array();
+        for(int index = 0; index < KEYFRAMES; ++index){
+            float angle = glm::two_pi<float>() * index / KEYFRAMES;
+            keyframes.push_back({{"position", {radius * std::sin(angle), height, radius * std::cos(angle)}}, {"target", {0.0f, 0.0f, 0.0f}}});
+        }
+        return {{"duration", 20}, {"loop", true}, {"keyframes", keyframes}};
+    }
+
+    nlohmann::json SceneGenerator::getNodeData(int index, const std::vector<int>& firstChild, const std::vector<int>& nextSibling) const {
+        const Node& node = nodes[index];
+        nlohmann::json components = {{{"type", "Mesh Renderer"}, {"mesh", MESHES[node.mesh].name}, {"material", materialName(node.material)}}};
+        if(node.spin != 0)
+            components.push_back({{"type", "Movement"}, {"angularVelocity", {0.0f, glm::degrees(node.spin), 0.0f}}});
+        nlohmann::json data = {
+            {"position", {node.position.x, node.position.y, node.position.z}},
+            {"rotation", {0.0f, glm::degrees(node.yaw), 0.0f}},
+            {"scale", {node.scale, node.scale, node.scale}},
+            {"components", components},
+        };
+        if(firstChild[index] >= 0){
+            nlohmann::json children = nlohmann::json::array();
+            for(int child = firstChild[index]; child >= 0; child = nextSibling[child])
+                children.push_back(getNodeData(child, firstChild, nextSibling));
+            data["children"] = std::move(children);
+        }
+        return data;
+    }
+
+    void SceneGenerator::populate(World* world) const {
+        // The camera & the lights are few, so they go through the usual deserialization
+        world->deserialize(getCameraAndLightsData());
+
+        // The entities are created directly since going through json would cost much more time & memory than the world itself
+        std::vector<Mesh*> meshes(settings.meshes);
+        for(int index = 0; index < settings.meshes; ++index)
+            meshes[index] = AssetLoader<Mesh>::get(MESHES[index].name);
+        std::vector<Material*> materials(settings.materials);
+        for(int index = 0; index < settings.materials; ++index)
+            materials[index] = AssetLoader<Material>::get(materialName(index));
+
+        std::vector<Entity*> entities(nodes.size());
+        for(size_t index = 0; index < nodes.size(); ++index){
+            const Node& node = nodes[index];
+            Entity* entity = world->add();
+            entity->parent = node.parent >= 0 ? entities[node.parent] : nullptr;
+            entity->localTransform.position = node.position;
+            entity->localTransform.rotation = {0.0f, node.yaw, 0.0f};
+            entity->localTransform.scale = glm::vec3(node.scale);
+            auto meshRenderer = entity->addComponent<MeshRendererComponent>();
+            meshRenderer->mesh = meshes[node.mesh];
+            meshRenderer->material = materials[node.material];
+            if(node.spin != 0)
+                entity->addComponent<MovementComponent>()->angularVelocity = {0.0f, node.spin, 0.0f};
+            entities[index] = entity;
+        }
+    }
+
+    bool SceneGenerator::writeConfig(const std::string& path, const nlohmann::json& base) const {
+        nlohmann::json config = base.is_object() ? base : nlohmann::json::object();
+        config["start-scene"] = "synthetic";
+        nlohmann::json scene = config.value("scene", nlohmann::json::object());
+        config.erase("scene");
+        scene.erase("generator");
+        scene.erase("world");
+        scene["assets"] = getAssets();
+        // The default path of the benchmark follows the size of the scene
+        if(config.contains("benchmark") && !config["benchmark"].contains("camera"))
+            config["benchmark"]["camera"] = getCameraPath();
+
+        std::error_code ec;
+        auto directory = std::filesystem::path(path).parent_path();
+        if(!directory.empty()) std::filesystem::create_directories(directory, ec);
+        std::ofstream out(path);
+        if(!out){
+            std::cerr << "ERROR: Couldn't open the scene file: " << path << std::endl;
+            return false;
+        }
+
+        // The children lists of the nodes (the children of each node are kept in their generation order)
+        std::vector<int> firstChild(nodes.size(), -1), nextSibling(nodes.size(), -1);
+        for(int index = (int)nodes.size() - 1; index >= 0; --index){
+            if(int parent = nodes[index].parent; parent >= 0){
+                nextSibling[index] = firstChild[parent];
+                firstChild[parent] = index;
+            }
+        }
+
+        // The config is written by hand around the world so that each hierarchy is turned into json only while it is written
+        out << "{\n";
+        for(auto& [key, value] : config.items())
+            out << "  " << nlohmann::json(key).dump() << ": " << value.dump() << ",\n";
+        out << "  \"scene\": {\n";
+        for(auto& [key, value] : scene.items())
+            out << "    " << nlohmann::json(key).dump() << ": " << value.dump() << ",\n";
+        out << "    \"generator\": " << serialize().dump() << ",\n";
+        out << "    \"world\": [";
+        const char* separator = "\n      ";
+        for(auto& entity : getCameraAndLightsData()){
+            out << separator << entity.dump();
+            separator = ",\n      ";
+        }
+        for(size_t index = 0; index < nodes.size(); ++index){
+            if(nodes[index].parent < 0)
+                out << separator << getNodeData((int)index, firstChild, nextSibling).dump();
+        }
+        out << "\n    ]\n  }\n}\n";
+        return (bool)out;
+    }
+
+}
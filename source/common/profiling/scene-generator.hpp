@@ -0,0 +1,100 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace our {
+
+    class World;
+
+    // Builds synthetic worlds of any size to measure how the ECS, the systems and the renderer scale with the scene.
+    // The scene is a flat square on which the entities are spread evenly (so the density stays the same whatever the count),
+    // lit by a directional light and a number of point lights, and seen by a camera looking down at its center.
+    // Every entity draws one of the first "meshes" meshes of the assets (from the smallest to the biggest) with one of "materials"
+    // materials (lit materials with different albedo textures), both picked at random. The entities are grouped into hierarchies that are
+    // "depth" levels deep where each entity has "branching" children, and a ratio of them spin around their Y axis
+    // (a spinning parent carries its children along, so the transforms have to be propagated every frame).
+    // The layout only depends on the settings, so a seed gives the same scene on every machine.
+    // The scene can either be added to a world directly (which is much faster and lighter than going through json for huge
+    // scenes) or be written as an app config (to freeze a scene or to measure the deserialization too).
+    class SceneGenerator {
+    public:
+        struct Settings {
+            std::uint32_t seed = 1;
+            int entities = 10000;   // The number of entities drawing a mesh (the lights & the camera are not counted)
+            int depth = 1;          // The number of levels of each hierarchy (1 means that all the entities are roots)
+            int branching = 4;      // The number of children of each entity above the last level of a hierarchy
+            int meshes = 4;         // How many different meshes are used
+            int materials = 8;      // How many different materials are used
+            int lights = 8;         // The number of point lights (there is always a directional light too)
+            float moving = 0.1f;    // The ratio of the entities that spin (the others never move)
+            float spacing = 4.0f;   // The average distance between neighbouring entities
+            int lods = 0;           // The simplified levels of detail generated for each mesh (only drawn if the renderer enables "lod")
+        } settings;
+
+        // A generated entity. Its transform is relative to its parent (whose index is always smaller than the entity's).
+        struct Node {
+            int parent = -1;
+            glm::vec3 position = {0, 0, 0};
+            float yaw = 0;          // The rotation around the Y axis (in radians)
+            float scale = 1;
+            int mesh = 0, material = 0;
+            float spin = 0;         // The angular velocity around the Y axis (in radians per second), 0 if the entity doesn't move
+        };
+
+        struct PointLight {
+            glm::vec3 position;
+            glm::vec3 color;
+        };
+
+    private:
+        std::vector<Node> nodes;
+        std::vector<PointLight> lights;
+
+        // A generator with a fixed algorithm (unlike the standard distributions whose results differ between the standard libraries)
+        std::mt19937 random;
+        float uniform(float min, float max) { return min + (max - min) * (float)(random() >> 8) * (1.0f / 16777216.0f); }
+
+        // The json of the camera & the lights (in the form read by "World::deserialize")
+        nlohmann::json getCameraAndLightsData() const;
+        // Writes the json of the node with its children
+        nlohmann::json getNodeData(int index, const std::vector<int>& firstChild, const std::vector<int>& nextSibling) const;
+
+    public:
+        // Reads the settings from a json object (any of them can be omitted):
+        // {"seed": 1, "entities": 10000, "depth": 1, "branching": 4, "meshes": 4, "materials": 8, "lights": 8, "moving": 0.1, "spacing": 4, "lods": 0}
+        void deserialize(const nlohmann::json& config);
+        // Reads the settings from a list of "key=value" separated by commas (e.g. "entities=50000,depth=3") as given on the command line.
+        // Returns false if the list is malformed or has an unknown key.
+        bool parse(const std::string& list);
+        nlohmann::json serialize() const;
+
+        // Lays out the scene. It must be called after the settings are changed & before the scene is used.
+        void generate();
+
+        const std::vector<Node>& getNodes() const { return nodes; }
+        // The length of the side of the square on which the entities are spread
+        float getSize() const { return settings.spacing * std::sqrt((float)settings.entities); }
+
+        // The shaders, textures, samplers, meshes & materials used by the scene in the form read by "deserializeAllAssets"
+        nlohmann::json getAssets() const;
+        // A path that circles the scene at a distance in the form read by "CameraPath::deserialize"
+        nlohmann::json getCameraPath() const;
+
+        // Adds the scene to the world. The assets must be loaded first (see "getAssets").
+        void populate(World* world) const;
+
+        // Writes an app config that shows the scene in the "synthetic" state. The config is a copy of "base" (e.g. for the
+        // renderer & the benchmark settings) where the generator settings of the scene are replaced by its assets & its world.
+        // The world is written one hierarchy at a time, so even huge scenes don't have to be held as json in memory.
+        bool writeConfig(const std::string& path, const nlohmann::json& base) const;
+    };
+
+}
@@ -0,0 +1,118 @@
+#include "postprocess-fusion.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+namespace our::postprocess_fusion {
+
+    namespace {
+        struct Effect {
+            std::string name, prefix, source;
+            bool remap = false, color = false, sample = false;
+        };
+
+        // Reads the snippet of an effect and finds which functions it defines
+        bool loadEffect(const std::string& name, Effect& effect){
+            std::string filename = std::string(EFFECTS_DIRECTORY) + name + ".glsl";
+            std::ifstream file(filename);
+            if(!file){
+                std::cerr << "ERROR: Couldn't open postprocess effect: " << filename << std::endl;
+                return false;
+            }
+            effect.name = name;
+            effect.source = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            effect.prefix = name;
+            std::replace(effect.prefix.begin(), effect.prefix.end(), '-', '_');
+
+            effect.remap = effect.source.find(effect.prefix + "_remap(") != std::string::npos;
+            effect.color = effect.source.find(effect.prefix + "_color(") != std::string::npos;
+            effect.sample = effect.source.find(effect.prefix + "_sample(") != std::string::npos;
+            if(effect.sample && effect.remap){
+                // A sampling effect already picks where it reads from, so a remap would be ambiguous
+                std::cerr << "WARNING: Postprocess effect \"" << name << "\" defines both a sample and a remap function, the remap is ignored" << std::endl;
+                effect.remap = false;
+            }
+            if(!effect.remap && !effect.color && !effect.sample){
+                std::cerr << "ERROR: Postprocess effect \"" << name << "\" defines no remap, color or sample function" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // Generates a fragment shader that applies a group of effects in a single pass
+        // If the stages are numbered 1 to n and "uv<k>" is the coordinate at which stage k is evaluated (uv<n> is the pixel itself),
+        // then stage k reads its input at uv<k-1> = remap_k(uv<k>). The colors are then computed from the first stage to the last.
+        FusedShader generate(const std::vector<Effect>& group){
+            int count = (int)group.size();
+            // The (1-based) index of the sampling stage. 0 means that there is none and a single fetch is enough.
+            int sampleStage = 0;
+            for(int k = 1; k <= count; ++k) if(group[k - 1].sample) sampleStage = k;
+
+            FusedShader shader;
+            for(auto& effect : group) shader.name += (shader.name.empty() ? "" : "+") + effect.name;
+
+            std::ostringstream out;
+            out << "#version 330\n\n";
+            out << "// Generated by postprocess_fusion from: " << shader.name << "\n\n";
+            out << "uniform sampler2D tex;\n\n";
+            out << "in vec2 tex_coord;\n";
+            out << "out vec4 frag_color;\n\n";
+            out << "// Reads the input after applying the remapping effects that come before the sampling effect\n";
+            out << "vec4 fetch(vec2 uv);\n\n";
+
+            // Each snippet is only included once even if the effect is used multiple times
+            std::set<std::string> included;
+            for(auto& effect : group)
+                if(included.insert(effect.name).second) out << effect.source << "\n";
+
+            out << "vec4 fetch(vec2 uv){\n";
+            for(int k = sampleStage - 1; k >= 1; --k)
+                if(group[k - 1].remap) out << "    uv = " << group[k - 1].prefix << "_remap(uv);\n";
+            out << "    return texture(tex, uv);\n";
+            out << "}\n\n";
+
+            out << "void main(){\n";
+            out << "    vec2 uv" << count << " = tex_coord;\n";
+            for(int k = count; k > sampleStage; --k){
+                const Effect& effect = group[k - 1];
+                out << "    vec2 uv" << k - 1 << " = ";
+                if(effect.remap) out << effect.prefix << "_remap(uv" << k << ");\n";
+                else out << "uv" << k << ";\n";
+            }
+            if(sampleStage > 0) out << "    vec4 color = " << group[sampleStage - 1].prefix << "_sample(uv" << sampleStage << ");\n";
+            else out << "    vec4 color = fetch(uv0);\n";
+            for(int k = std::max(sampleStage, 1); k <= count; ++k)
+                if(group[k - 1].color) out << "    color = " << group[k - 1].prefix << "_color(color, uv" << k << ");\n";
+            out << "    frag_color = color;\n";
+            out << "}\n";
+
+            shader.source = out.str();
+            return shader;
+        }
+    }
+
+    std::vector<FusedShader> compose(const std::vector<std::string>& effects){
+        std::vector<FusedShader> shaders;
+        std::vector<Effect> group;
+        bool groupHasColor = false, groupHasSample = false;
+        for(auto& name : effects){
+            Effect effect;
+            if(!loadEffect(name, effect)) continue;
+            // A sampling effect can't be fused after a color effect (or another sampling effect), so we start a new pass
+            if(effect.sample && (groupHasColor || groupHasSample)){
+                shaders.push_back(generate(group));
+                group.clear();
+                groupHasColor = groupHasSample = false;
+            }
+            groupHasColor |= effect.color;
+            groupHasSample |= effect.sample;
+            group.push_back(effect);
+        }
+        if(!group.empty()) shaders.push_back(generate(group));
+        return shaders;
+    }
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace our::postprocess_fusion {
+
+    // The directory that holds the fusable effects. Each effect is a GLSL snippet "<name>.glsl" that defines
+    // (where <prefix> is the effect name with '-' replaced by '_'):
+    // - "vec2 <prefix>_remap(vec2 uv)": for effects that only change where the input is read (e.g. fisheye).
+    // - "vec4 <prefix>_color(vec4 color, vec2 uv)": for effects that change the color of a pixel (e.g. vignette, grayscale).
+    // - "vec4 <prefix>_sample(vec2 uv)": for effects that read the input more than once through "vec4 fetch(vec2 uv)" (e.g. chromatic aberration).
+    // An effect can define both a remap and a color function.
+    constexpr const char* EFFECTS_DIRECTORY = "assets/shaders/postprocess/effects/";
+
+    // A generated fragment shader
+    struct FusedShader {
+        std::string name;   // The effects it contains (for error messages)
+        std::string source; // The GLSL source code
+    };
+
+    // This function composes the given chain of effects (applied in order) into as few fragment shaders as possible.
+    // All the remapping effects are folded into the coordinate used for the lookup and the color effects are applied
+    // one after the other on the fetched color, so the whole chain costs a single fullscreen pass.
+    // The only case that needs another pass is a sampling effect that comes after a color effect
+    // (since it would need the color effect to be applied on each of its reads).
+    // Effects that fail to load are skipped (and reported to std::cerr).
+    std::vector<FusedShader> compose(const std::vector<std::string>& effects);
+
+}
@@ -0,0 +1,181 @@
+#include "program-binary-cache.hpp"
+#include "../profiling/cpu-profiler.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace our {
+
+    namespace {
+
+        // The header of a cache file (followed by "length" bytes of the binary)
+        struct FileHeader {
+            char magic[4] = {'O', 'P', 'B', 'C'};
+            std::uint32_t version = 1;  // The version of this file format
+            std::uint64_t key = 0;      // The key of the program (a file renamed by hand is never loaded for another program)
+            std::uint32_t format = 0;   // The binary format given by the driver
+            std::uint32_t length = 0;
+        };
+
+        // 64-bit FNV-1a, which is plenty to tell the programs of a project apart
+        constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull, FNV_PRIME = 1099511628211ull;
+        void hashBytes(std::uint64_t& hash, const void* data, size_t size){
+            auto bytes = static_cast<const unsigned char*>(data);
+            for(size_t index = 0; index < size; ++index){
+                hash ^= bytes[index];
+                hash *= FNV_PRIME;
+            }
+        }
+        void hashString(std::uint64_t& hash, const std::string& string){
+            // The size is hashed too, so moving text from one string to the next changes the hash
+            std::uint64_t size = string.size();
+            hashBytes(hash, &size, sizeof(size));
+            hashBytes(hash, string.data(), string.size());
+        }
+
+    }
+
+    void ProgramBinaryCache::deserialize(const nlohmann::json& config){
+        if(!config.is_object()) return;
+        settings.enabled = config.value("enabled", true);
+        settings.directory = config.value("directory", settings.directory);
+    }
+
+    ProgramBinaryCache& ProgramBinaryCache::shared(){
+        static ProgramBinaryCache cache;
+        return cache;
+    }
+
+    void ProgramBinaryCache::initialize(){
+        active = false;
+        hits = misses = rejected = stored = 0;
+        if(!settings.enabled) return;
+
+        if(!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary){
+            std::cerr << "WARNING: The shader cache is disabled since the driver doesn't support program binaries" << std::endl;
+            return;
+        }
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if(formats <= 0){
+            std::cerr << "WARNING: The shader cache is disabled since the driver has no program binary format" << std::endl;
+            return;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(settings.directory, ec);
+        if(ec){
+            std::cerr << "WARNING: The shader cache is disabled since its directory couldn't be created: " << settings.directory << std::endl;
+            return;
+        }
+
+        // A binary is only valid for the driver that made it, so the driver is a part of the key
+        driver.clear();
+        for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}){
+            if(const GLubyte* string = glGetString(name)) driver += reinterpret_cast<const char*>(string);
+            driver += '\n';
+        }
+        active = true;
+    }
+
+    void ProgramBinaryCache::shutdown(){
+        if(!active) return;
+        std::cout << "Shader cache: " << hits << " programs loaded, " << misses << " compiled (" << stored << " stored)";
+        if(rejected > 0) std::cout << ", " << rejected << " binaries rejected by the driver";
+        std::cout << std::endl;
+        active = false;
+    }
+
+    std::uint64_t ProgramBinaryCache::computeKey(const std::vector<std::pair<GLenum, std::string>>& shaders) const {
+        std::uint64_t hash = FNV_OFFSET;
+        hashString(hash, driver);
+        for(auto& [type, source] : shaders){
+            hashBytes(hash, &type, sizeof(type));
+            hashString(hash, source);
+        }
+        return hash;
+    }
+
+    std::string ProgramBinaryCache::getPath(std::uint64_t key) const {
+        std::ostringstream name;
+        name << std::hex << key << ".bin";
+        return (std::filesystem::path(settings.directory) / name.str()).string();
+    }
+
+    bool ProgramBinaryCache::load(GLuint program, std::uint64_t key){
+        if(!active) return false;
+        PROFILE_ZONE("ProgramBinaryCache::load");
+        std::string path = getPath(key);
+        std::ifstream file(path, std::ios::binary);
+        if(!file){
+            ++misses;
+            return false;
+        }
+
+        FileHeader expected, header;
+        std::vector<char> binary;
+        bool valid = file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+            std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 &&
+            header.version == expected.version && header.key == key;
+        if(valid){
+            binary.resize(header.length);
+            valid = (bool)file.read(binary.data(), header.length);
+        }
+        file.close();
+
+        if(valid){
+            glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+            GLint status = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &status);
+            if(status == GL_TRUE){
+                ++hits;
+                return true;
+            }
+        }
+        // The file is broken or the driver doesn't accept the binary anymore (e.g. it was updated without changing its version
+        // string), so it is deleted and the program will be compiled (and stored again)
+        ++rejected;
+        ++misses;
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return false;
+    }
+
+    void ProgramBinaryCache::store(GLuint program, std::uint64_t key){
+        if(!active) return;
+        PROFILE_ZONE("ProgramBinaryCache::store");
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if(length <= 0) return;
+
+        FileHeader header;
+        header.key = key;
+        std::vector<char> binary(length);
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &header.format, binary.data());
+        if(written <= 0) return;
+        header.length = (std::uint32_t)written;
+
+        // The file is written under another name then renamed, so another run never reads a partially written binary
+        std::string path = getPath(key), temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary);
+            if(!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) || !file.write(binary.data(), written)){
+                std::cerr << "Failed to write the shader cache file: " << temporary << std::endl;
+                return;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temporary, path, ec);
+        if(ec){
+            std::cerr << "Failed to write the shader cache file: " << path << std::endl;
+            std::filesystem::remove(temporary, ec);
+            return;
+        }
+        ++stored;
+    }
+
+}
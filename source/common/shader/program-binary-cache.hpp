@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <json/json.hpp>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace our {
+
+    // Keeps the linked shader programs on disk (as the driver's program binaries) so that the next runs can load them
+    // with "glProgramBinary" instead of compiling & linking the GLSL again. Each program is stored in its own file named
+    // after a hash of its shader sources (which hold their defines) and of the driver's vendor, renderer & version strings,
+    // so editing a shader or updating the driver simply misses the cache. A binary the driver refuses anyway (it may
+    // reject binaries made by another build of itself) is deleted and the program is compiled from the sources.
+    // Program binaries are core in OpenGL 4.1 (or "GL_ARB_get_program_binary"), and the driver may support no format
+    // at all, in which case the cache stays disabled. It is used by "ShaderProgram::link".
+    class ProgramBinaryCache {
+    public:
+        struct Settings {
+            bool enabled = false;
+            std::string directory = "cache/shaders";
+        } settings;
+
+        // Reads the settings: {"enabled", "directory"}
+        void deserialize(const nlohmann::json& config);
+
+        // The cache used by all the shader programs
+        static ProgramBinaryCache& shared();
+
+        // Checks that the current context can save & load program binaries and reads the identity of the driver.
+        // This must be called after the context is created (the cache stays disabled otherwise).
+        void initialize();
+        // Prints how many programs were loaded from the cache (if it was used) and disables it until the next "initialize"
+        void shutdown();
+
+        bool isEnabled() const { return active; }
+
+        // The key of a program made of the given shaders (their types & sources) with the current driver
+        std::uint64_t computeKey(const std::vector<std::pair<GLenum, std::string>>& shaders) const;
+        // Loads the binary stored for the key into the program. Returns true if the program is now linked from it.
+        bool load(GLuint program, std::uint64_t key);
+        // Saves the binary of the linked program for the key
+        void store(GLuint program, std::uint64_t key);
+
+    private:
+        bool active = false;
+        std::string driver; // The vendor, renderer & version strings of the context
+
+        // The statistics printed by "shutdown"
+        int hits = 0, misses = 0, rejected = 0, stored = 0;
+
+        std::string getPath(std::uint64_t key) const;
+    };
+
+}
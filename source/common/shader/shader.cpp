@@ -1,15 +1,19 @@
 #include "shader.hpp"
+#include "uniform-blocks.hpp"
+#include "program-binary-cache.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <utility>
 
 // Forward definition for error checking functions
 std::string checkForShaderCompilationErrors(GLuint shader);
 std::string checkForLinkingErrors(GLuint program);
 
-bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
+bool our::ShaderProgram::attach(const std::string &filename, GLenum type)
 {
     // Here, we open the file and read a string from it containing the GLSL code of our shader
     std::ifstream file(filename);
@@ -19,9 +23,27 @@ bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
         return false;
     }
     std::string sourceString = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
-    const char *sourceCStr = sourceString.c_str();
     file.close();
 
+    return attachSource(sourceString, type, filename);
+}
+
+bool our::ShaderProgram::attachSource(const std::string &source, GLenum type, const std::string &name)
+{
+    // With the program binary cache, the sources are kept until "link" which decides whether they must be compiled at all
+    if (ProgramBinaryCache::shared().isEnabled())
+    {
+        pendingSources.emplace_back(type, source);
+        pendingNames.push_back(name);
+        return true;
+    }
+    return compile(source, type, name);
+}
+
+bool our::ShaderProgram::compile(const std::string &source, GLenum type, const std::string &name)
+{
+    const char *sourceCStr = source.c_str();
+
     // TODO: Complete this function
     // Note: The function "checkForShaderCompilationErrors" checks if there is
     //  an error in the given shader. You should use it to check if there is a
@@ -38,7 +60,7 @@ bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
     std::string compilationError = checkForShaderCompilationErrors(shaderID);
     if (compilationError.size() != 0)
     {
-        std::cerr << "ERROR IN " << filename << std::endl;
+        std::cerr << "ERROR IN " << name << std::endl;
 
         std::cout << compilationError;
 
@@ -53,7 +75,9 @@ bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
     return true;
 }
 
-bool our::ShaderProgram::link() const
+unsigned our::ShaderProgram::nextTableId = 0;
+
+bool our::ShaderProgram::link()
 {
     // TODO: Complete this function
     // Note: The function "checkForLinkingErrors" checks if there is
@@ -61,19 +85,108 @@ bool our::ShaderProgram::link() const
     //  linking error and print it so that you can know what is wrong with the
     //  program. The returned string will be empty if there is no errors.
 
-    //Here we link the program consisting of shaders to create an executable 
-    //& then check for any linking error and print if any is found
-    glLinkProgram(program);
+    // If the shaders wait in "pendingSources", the program binary cache may already have the whole program
+    ProgramBinaryCache &cache = ProgramBinaryCache::shared();
+    bool cached = false;
+    std::uint64_t key = 0;
+    if (!pendingSources.empty())
+    {
+        key = cache.computeKey(pendingSources);
+        cached = cache.load(program, key);
+        if (!cached)
+        {
+            bool compiled = true;
+            for (size_t index = 0; index < pendingSources.size(); ++index)
+                compiled = compile(pendingSources[index].second, pendingSources[index].first, pendingNames[index]) && compiled;
+            if (!compiled)
+                return false;
+            // Tells the driver that the binary will be retrieved (some drivers only keep it if asked before linking)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+    }
 
-    std::string linkingError = checkForLinkingErrors(program);
-    if (linkingError.size() != 0)
+    if (!cached)
     {
-        std::cout << linkingError;
-        return false;
+        //Here we link the program consisting of shaders to create an executable 
+        //& then check for any linking error and print if any is found
+        glLinkProgram(program);
+
+        std::string linkingError = checkForLinkingErrors(program);
+        if (linkingError.size() != 0)
+        {
+            std::cout << linkingError;
+            return false;
+        }
+        if (!pendingSources.empty())
+            cache.store(program, key);
+    }
+    pendingSources.clear();
+    pendingNames.clear();
+
+    // Attach the engine's shared uniform blocks (if the program uses them) to their binding points
+    // (this is done for the cached programs too since a loaded binary starts with the default bindings like a linked program)
+    for (auto [name, binding] : {std::make_pair(our::uniform_blocks::FRAME_BLOCK_NAME, our::uniform_blocks::FRAME_BINDING),
+                                 std::make_pair(our::uniform_blocks::OBJECT_BLOCK_NAME, our::uniform_blocks::OBJECT_BINDING)})
+    {
+        GLuint index = glGetUniformBlockIndex(program, name);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, binding);
     }
+
+    reflectUniforms();
     return true;
 }
 
+void our::ShaderProgram::reflectUniforms()
+{
+    // Linking resets every uniform of the program, so the old table (and the handles into it) can't be used anymore
+    uniforms.clear();
+    uniformIndices.clear();
+    tableId = ++nextTableId;
+
+    // OpenGL 3.3 has no program interface queries (GL 4.3), so the active uniforms are listed with "glGetActiveUniform"
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> buffer(std::max(maxLength, 1));
+    for (GLint index = 0; index < count; ++index)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(program, (GLuint)index, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+        // The uniforms in blocks are active too, but they have no location (they are set through the uniform blocks)
+        GLint location = glGetUniformLocation(program, name.c_str());
+        if (location == -1)
+            continue;
+        addUniform(name, location);
+        // An array is listed as its first element ("lights[0]"), which can also be named without the index
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            addUniform(name.substr(0, name.size() - 3), location);
+    }
+}
+
+our::UniformHandle our::ShaderProgram::addUniform(const std::string &name, GLint location)
+{
+    auto [it, inserted] = uniformIndices.try_emplace(name, (int)uniforms.size());
+    if (inserted)
+    {
+        Uniform uniform;
+        uniform.location = location;
+        uniforms.push_back(uniform);
+    }
+    return UniformHandle{it->second};
+}
+
+our::UniformHandle our::ShaderProgram::getUniform(const std::string &name)
+{
+    if (auto it = uniformIndices.find(name); it != uniformIndices.end())
+        return UniformHandle{it->second};
+    // Not reflected, so OpenGL is asked once and the answer (even -1) is kept
+    return addUniform(name, glGetUniformLocation(program, name.c_str()));
+}
+
 ////////////////////////////////////////////////////////////////////
 // Function to check for compilation and linking error in shaders //
 ////////////////////////////////////////////////////////////////////
@@ -1,89 +1,177 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+#include <cstring>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "../gl/state-cache.hpp"
+
 namespace our {
 
+    // A uniform of a specific program resolved in advance (see "ShaderProgram::getUniform")
+    // It is an index into the uniform table of the program, so setting the uniform through it needs no lookup at all.
+    struct UniformHandle {
+        int index = -1;
+    };
+
     class ShaderProgram {
 
     private:
         //Shader Program Handle (OpenGL object name)
         GLuint program;
 
+        // The uniforms of the program (filled with the active uniforms after linking) and a copy of the last value sent to
+        // each of them, so sending the same value again (the same tint or texture unit for every draw) costs no OpenGL call.
+        // The copy is only correct if the uniforms are only set through this class (so "program" must not leak elsewhere).
+        struct Uniform {
+            GLint location = -1;
+            GLsizei size = 0; // The bytes in "value" (0 until a value is sent)
+            alignas(16) unsigned char value[sizeof(glm::mat4)] = {};
+        };
+        std::vector<Uniform> uniforms;
+        std::unordered_map<std::string, int> uniformIndices;
+        // Identifies the table among all the programs & links, so the handles resolved for an older table (of a program
+        // that was linked again, or deleted and replaced by another one at the same address) are never used with this one
+        unsigned tableId;
+        static unsigned nextTableId;
+
+        // The shaders (types & sources) and their names waiting for "link" while the program binary cache is enabled
+        std::vector<std::pair<GLenum, std::string>> pendingSources;
+        std::vector<std::string> pendingNames;
+
+        // Compiles a shader and attaches it to the program
+        bool compile(const std::string& source, GLenum type, const std::string& name);
+
+        // Adds a uniform to the table (or returns the existing one)
+        UniformHandle addUniform(const std::string& name, GLint location);
+        // Reads the active uniforms of the linked program into the table
+        void reflectUniforms();
+
+        // Returns the location the value must be sent to, or -1 if the uniform doesn't exist or already holds this value
+        template<typename T>
+        GLint changedLocation(UniformHandle handle, const T& value)
+        {
+            static_assert(sizeof(T) <= sizeof(Uniform::value), "The uniform value is too big to be shadowed");
+            if(handle.index < 0) return -1;
+            Uniform& uniform = uniforms[handle.index];
+            if(uniform.location == -1) return -1;
+            if(uniform.size == (GLsizei)sizeof(T) && std::memcmp(uniform.value, &value, sizeof(T)) == 0) return -1;
+            std::memcpy(uniform.value, &value, sizeof(T));
+            uniform.size = (GLsizei)sizeof(T);
+            return uniform.location;
+        }
+
     public:
         ShaderProgram()
         {
             //TODO: (Req 1) Create A Shader Program
             program = glCreateProgram();
+            tableId = ++nextTableId;
         }
         ~ShaderProgram()
         {
             //TODO: (Req 1) Delete a shader program
+            GLStateCache::current().onProgramDeleted(program);
             glDeleteProgram(program);
         }
 
-        bool attach(const std::string& filename, GLenum type) const;
+        bool attach(const std::string& filename, GLenum type);
+        // Compiles & attaches a shader from its source code (used for generated shaders)
+        // "name" is only used to identify the shader in error messages
+        // If the program binary cache is enabled, the shader is only compiled by "link" when the cache doesn't have the program
+        // (so the compilation errors are reported by "link" and this always returns true).
+        bool attachSource(const std::string& source, GLenum type, const std::string& name);
 
-        bool link() const;
+        // Links the program (or loads it from the program binary cache), then reflects its active uniforms
+        // (which also forgets the values sent before)
+        bool link();
 
+        // The program is only sent to OpenGL if it is not already in use
         void use()
         {
-            glUseProgram(program);
+            GLStateCache::current().useProgram(program);
         }
 
-        GLuint getUniformLocation(const std::string& name)
+        // Returns the location of the uniform with the given name (-1 if the program has no such uniform)
+        GLint getUniformLocation(const std::string& name)
         {
             //TODO: (Req 1) Return the location of the uniform with the give name
-            return glGetUniformLocation(program, name.c_str());
+            UniformHandle uniform = getUniform(name);
+            return uniforms[uniform.index].location;
         }
 
+        // Resolves a uniform name into a handle that can be given to "set" without any name lookup.
+        // The handle stays valid until the program is linked again. Names that are not in the table (the array elements
+        // other than the first one, or every name in a null context which reports no active uniforms) are queried from
+        // OpenGL once, then cached like the reflected ones (including the names that don't exist).
+        UniformHandle getUniform(const std::string& name);
+        // Changes whenever the handles returned by "getUniform" change (see "UniformHandles")
+        unsigned getUniformTableId() const { return tableId; }
+
         //Here we set the the value of a UNIFORM VARIABLE for the current PROGRAM object in its location
         //whether it's to an int, float, vectors, matrix
-        void set(const std::string& uniform, GLfloat value)
+        //The program must be in use. A value equal to the last one sent to the same uniform isn't sent again.
+        void set(UniformHandle uniform, GLfloat value)
         {
             //TODO: (Req 1) Send the given float value to the given uniform
-            glUniform1f(getUniformLocation(uniform), value);
+            if(GLint location = changedLocation(uniform, value); location != -1)
+                glUniform1f(location, value);
         }
 
-        void set(const std::string& uniform, GLuint value)
+        void set(UniformHandle uniform, GLuint value)
         {
             //TODO: (Req 1) Send the given unsigned integer value to the given uniform
-            glUniform1ui(getUniformLocation(uniform), value);
+            if(GLint location = changedLocation(uniform, value); location != -1)
+                glUniform1ui(location, value);
         }
 
-        void set(const std::string& uniform, GLint value)
+        void set(UniformHandle uniform, GLint value)
         {
             //TODO: (Req 1) Send the given integer value to the given uniform
-            glUniform1i(getUniformLocation(uniform), value);
+            if(GLint location = changedLocation(uniform, value); location != -1)
+                glUniform1i(location, value);
         }
 
-        void set(const std::string& uniform, glm::vec2 value)
+        void set(UniformHandle uniform, glm::vec2 value)
         {
             //TODO: (Req 1) Send the given 2D vector value to the given uniform
-            glUniform2f(getUniformLocation(uniform), value.x, value.y);
+            if(GLint location = changedLocation(uniform, value); location != -1)
+                glUniform2f(location, value.x, value.y);
         }
 
-        void set(const std::string& uniform, glm::vec3 value)
+        void set(UniformHandle uniform, glm::vec3 value)
         {
             //TODO: (Req 1) Send the given 3D vector value to the given uniform
-            glUniform3f(getUniformLocation(uniform), value.x, value.y, value.z);
+            if(GLint location = changedLocation(uniform, value); location != -1)
+                glUniform3f(location, value.x, value.y, value.z);
         }
 
-        void set(const std::string& uniform, glm::vec4 value)
+        void set(UniformHandle uniform, glm::vec4 value)
         {
             //TODO: (Req 1) Send the given 4D vector value to the given uniform
-            glUniform4f(getUniformLocation(uniform), value.x, value.y, value.z, value.w);
+            if(GLint location = changedLocation(uniform, value); location != -1)
+                glUniform4f(location, value.x, value.y, value.z, value.w);
         }
 
-        void set(const std::string& uniform, glm::mat4 matrix)
+        void set(UniformHandle uniform, const glm::mat4& matrix)
         {
             //TODO: (Req 1) Send the given matrix 4x4 value to the given uniform
-            glUniformMatrix4fv(getUniformLocation(uniform), 1, GL_FALSE, glm::value_ptr(matrix));
+            if(GLint location = changedLocation(uniform, matrix); location != -1)
+                glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+        }
+
+        // The same functions by name (the name is looked up in the uniform table, see "getUniform")
+        template<typename T>
+        void set(const std::string& uniform, const T& value)
+        {
+            set(getUniform(uniform), value);
         }
 
         //TODO: (Req 1) Delete the copy constructor and assignment operator.
@@ -96,6 +184,27 @@ namespace our {
         ShaderProgram& operator=(const ShaderProgram&) = delete;
     };
 
+    // The handles of a fixed list of uniform names, resolved again only when they are used with another program.
+    // An object that sets the same uniforms for every draw (like a material) keeps one instead of looking the names up.
+    template<std::size_t N>
+    class UniformHandles {
+        unsigned resolvedFor = 0; // The table the handles belong to (0 is never a table)
+        UniformHandle handles[N];
+
+    public:
+        // Resolves the given names (an array of N strings) in the program unless they were resolved for its table last time
+        template<typename Names>
+        void resolve(ShaderProgram* shader, const Names& names)
+        {
+            if(shader->getUniformTableId() == resolvedFor) return;
+            for(std::size_t index = 0; index < N; ++index)
+                handles[index] = shader->getUniform(names[index]);
+            resolvedFor = shader->getUniformTableId();
+        }
+
+        const UniformHandle& operator[](std::size_t index) const { return handles[index]; }
+    };
+
 }
 
 #endif
\ No newline at end of file
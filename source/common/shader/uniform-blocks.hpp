@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+namespace our {
+
+    // The uniform blocks shared by the engine's shaders and their C++ mirrors.
+    // The structs follow the std140 layout rules, so they can be copied into a uniform buffer as is:
+    // a vec3 takes 16 bytes unless a scalar follows it, and an array of structs has a stride that is a multiple of 16.
+    // A shader that declares a block with one of these names gets it attached to the matching binding point when it is linked
+    // (GLSL 330 can't set the binding in the shader itself).
+    namespace uniform_blocks {
+
+        // The binding points of the blocks
+        constexpr GLuint FRAME_BINDING = 0;  // "FrameData"
+        constexpr GLuint OBJECT_BINDING = 1; // "ObjectData"
+
+        constexpr const char* FRAME_BLOCK_NAME = "FrameData";
+        constexpr const char* OBJECT_BLOCK_NAME = "ObjectData";
+
+        // Must match MAX_LIGHTS in "assets/shaders/light.frag"
+        constexpr int MAX_LIGHTS = 16;
+
+        // struct Light { int type; vec3 position; vec3 direction; vec3 diffuse; vec3 specular; vec3 attenuation; vec2 cone_angles; };
+        struct Light {
+            GLint type;
+            GLint padding0[3];
+            glm::vec4 position;     // xyz
+            glm::vec4 direction;    // xyz
+            glm::vec4 diffuse;      // xyz
+            glm::vec4 specular;     // xyz
+            glm::vec4 attenuation;  // xyz
+            glm::vec2 coneAngles;
+            glm::vec2 padding1;
+        };
+        static_assert(sizeof(Light) == 112, "Light must follow the std140 layout");
+
+        // layout(std140) uniform FrameData { mat4 VP; vec3 camera_position; int light_count; Light lights[MAX_LIGHTS]; };
+        // This is written once per frame
+        struct Frame {
+            glm::mat4 VP;
+            glm::vec3 cameraPosition;
+            GLint lightCount;
+            Light lights[MAX_LIGHTS];
+        };
+        static_assert(offsetof(Frame, lightCount) == 76 && offsetof(Frame, lights) == 80, "Frame must follow the std140 layout");
+
+        // layout(std140) uniform ObjectData { mat4 M; mat4 M_IT; };
+        // This is written once per draw
+        struct Object {
+            glm::mat4 M;
+            glm::mat4 M_IT;
+        };
+        static_assert(sizeof(Object) == 128, "Object must follow the std140 layout");
+
+    }
+
+}
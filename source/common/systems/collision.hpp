@@ -2,6 +2,7 @@
 
 #include "../ecs/world.hpp"
 #include "../components/collision.hpp"
+#include "../profiling/cpu-profiler.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
@@ -54,6 +55,7 @@ namespace our
         // Otherwise it returns false
         bool update(World *world)
         {
+            PROFILE_ZONE("CollisionSystem::update");
 
             std::vector<CollisionComponent *> collisionComponents;
             // For each entity in the world
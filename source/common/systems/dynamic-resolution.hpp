@@ -0,0 +1,90 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+
+namespace our
+{
+
+    // This class picks the resolution scale at which the scene is rendered so that the frame time stays within a budget
+    // The cost of a frame is mostly proportional to the number of pixels (scale squared), so when we are over budget we scale down
+    // by the square root of the budget ratio. We can't measure how much headroom we have when we are under budget (vsync hides it),
+    // so we probe upwards one step at a time after the frame time was within budget for a while.
+    // Scales are quantized into steps so that the renderer only ever needs a few render target sizes.
+    class DynamicResolution
+    {
+    public:
+        bool enabled = false;
+        // The frame time budget in seconds
+        double targetFrameTime = 1.0 / 60.0;
+        // The range of the resolution scale (relative to the window size)
+        float minScale = 0.5f, maxScale = 1.0f;
+        // The scale always changes in multiples of this step
+        float step = 0.05f;
+        // How far over budget (relative to the budget) we tolerate before scaling down
+        float tolerance = 0.1f;
+        // How many frames within budget we wait before trying a larger scale
+        int probeFrames = 60;
+        // The strength of the sharpening applied by the upscaler (0 to 1)
+        float sharpness = 0.5f;
+
+        // Reads the settings from the renderer configuration (it is enabled unless "enabled" is false):
+        // "dynamicResolution": {"enabled": true, "targetFrameTime": milliseconds, "minScale": 0.5, "maxScale": 1.0, "sharpness": 0.5}
+        void deserialize(const nlohmann::json &config)
+        {
+            if (!config.is_object())
+                return;
+            enabled = config.value("enabled", true);
+            targetFrameTime = config.value("targetFrameTime", targetFrameTime * 1000.0) / 1000.0;
+            minScale = glm::clamp(config.value("minScale", minScale), step, 1.0f);
+            maxScale = glm::clamp(config.value("maxScale", maxScale), minScale, 1.0f);
+            sharpness = glm::clamp(config.value("sharpness", sharpness), 0.0f, 1.0f);
+            scale = maxScale;
+        }
+
+        // Updates the scale given the duration of the last frame (in seconds) and returns the new scale
+        float update(double frameTime)
+        {
+            if (!enabled)
+                return scale = 1.0f;
+            // We smooth the frame time so that a single slow frame doesn't change the resolution
+            smoothedFrameTime = smoothedFrameTime <= 0.0 ? frameTime : glm::mix(smoothedFrameTime, frameTime, 0.1);
+            ++framesSinceChange;
+
+            if (smoothedFrameTime > targetFrameTime * (1.0 + tolerance))
+            {
+                // Over budget: give the smoothed frame time a few frames to reflect the previous change before changing again
+                if (framesSinceChange >= 4 && scale > minScale)
+                {
+                    float desired = scale * (float)glm::sqrt(targetFrameTime / smoothedFrameTime);
+                    // We always go down at least one step
+                    setScale(glm::min(quantize(desired), scale - step));
+                }
+                framesWithinBudget = 0;
+            }
+            else if (++framesWithinBudget >= probeFrames && scale < maxScale)
+            {
+                setScale(scale + step);
+                framesWithinBudget = 0;
+            }
+            return scale;
+        }
+
+        float getScale() const { return scale; }
+        double getSmoothedFrameTime() const { return smoothedFrameTime; }
+
+    private:
+        float scale = 1.0f;
+        double smoothedFrameTime = 0.0;
+        int framesSinceChange = 0, framesWithinBudget = 0;
+
+        float quantize(float value) const { return glm::floor(value / step + 0.5f) * step; }
+
+        void setScale(float value)
+        {
+            scale = glm::clamp(quantize(value), minScale, maxScale);
+            framesSinceChange = 0;
+        }
+    };
+
+}
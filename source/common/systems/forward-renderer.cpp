@@ -1,7 +1,13 @@
 #include "forward-renderer.hpp"
 #include "../mesh/mesh-utils.hpp"
 #include "../texture/texture-utils.hpp"
+#include "../shader/postprocess-fusion.hpp"
+#include "../profiling/cpu-profiler.hpp"
+#include "../jobs/thread-pool.hpp"
+#include "../shader/uniform-blocks.hpp"
+#include "frustum.hpp"
 #include <iostream>
+#include <set>
 namespace our
 {
 
@@ -10,6 +16,26 @@ namespace our
         // First, we store the window size for later use
         this->windowSize = windowSize;
 
+        // The level of detail selection is only used if the config asks for it (so the reference images of the tests don't change)
+        if (config.contains("lod") && config["lod"].is_object())
+        {
+            const auto &lod = config["lod"];
+            lodSettings.enabled = lod.value("enabled", true);
+            lodSettings.threshold = lod.value("threshold", lodSettings.threshold);
+            lodSettings.hysteresis = glm::clamp(lod.value("hysteresis", lodSettings.hysteresis), 0.0f, 0.9f);
+        }
+
+        // The impostors are only used if the config asks for them (the atlas is baked later by "bakeImpostors")
+        if (config.contains("impostors"))
+            impostors.deserialize(config["impostors"]);
+
+        // Static batching is also opt-in (the batches are built later by "buildStaticBatches")
+        if (config.contains("staticBatching"))
+            staticBatcher.deserialize(config["staticBatching"]);
+
+        // The ring buffer that streams the uniform blocks of the lit shaders (its size per frame in bytes can be set in the config)
+        uniformRing.initialize(config.value("uniformRingBytes", (GLsizeiptr)1 << 20));
+
         // Then we check if there is a sky texture in the configuration
         if (config.contains("sky"))
         {
@@ -57,79 +83,70 @@ namespace our
         // Then we check if there is a postprocessing shader in the configuration
         if (config.contains("postprocess"))
         {
-            // TODO: (Req 11) Create a framebuffer
-
-            // create a framebuffer using the postprocessFramebuffer object in this class
-            glGenFramebuffers(1, &postprocessFrameBuffer);
-
-            // bind the framebuffer just created to be drawn on
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, postprocessFrameBuffer);
-
-            // TODO: (Req 11) Create a color and a depth texture and attach them to the framebuffer
-            //  Hints: The color format can be (Red, Green, Blue and Alpha components with 8 bits for each channel).
-            //  The depth format can be (Depth component with 24 bits).
-
-            // create a color texture
-            colorTarget = new Texture2D();
-
-            // attach the color texture to the framebuffer
-            colorTarget->bind();
-
-            int width = windowSize.x, height = windowSize.y;
-
-            // returns the bit mip levels to draw on -> simply returns the maximum of the width and height of the window size
-            GLsizei levels = (GLsizei)glm::floor(glm::log2(glm::max<float>((float)width, (float)height))) + 1;
-
-            // allocate memory for the color texture
-            // the color format is 8 bits for each channel (red , green, blue, alpha) as stated above
-            glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, width, height);
-
-            // attach the 2D texture to the currently bound frambuffer color attachment
-            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTarget->getOpenGLName(), 0);
-
-            // create a color texture
-            depthTarget = new Texture2D();
-
-            // attach the depth texture to the framebuffer
-            depthTarget->bind();
-
-            // allocate memory for the depth texture
-            // the depth component is 24 bits as stated above
-            glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
-
-            // attach the 2D texture to the currently bound frambuffer depth attachment
-            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTarget->getOpenGLName(), 0);
-
-            // TODO: (Req 11) Unbind the framebuffer just to be safe
-            // unbind the postprocess frambuffer after finishing to return to the default frambuffer
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            // The framebuffer and its color & depth targets are not created here anymore.
+            // They are transient resources of the frame graph (see "render") and they are allocated by the render target pool on first use.
 
             // Create a vertex array to use for drawing the texture
-            glGenVertexArrays(1, &postProcessVertexArray);
+            if (!postProcessVertexArray)
+                glGenVertexArrays(1, &postProcessVertexArray);
 
             // Create a sampler to use for sampling the scene texture in the post processing shader
-            Sampler *postprocessSampler = new Sampler();
+            postprocessSampler = new Sampler();
             postprocessSampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
             postprocessSampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             postprocessSampler->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
             postprocessSampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-            // Read the postprocessing shaders from the json file and add them to the shaders vector
-            for (const auto &shader : config["postprocess"]) // Assume its an array of postprocessing shaders
+            // The same sampler but it also filters between mip levels (for stages that downsample their input by more than 2x)
+            postprocessMipSampler = new Sampler();
+            postprocessMipSampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            postprocessMipSampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            postprocessMipSampler->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            postprocessMipSampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            // Read the postprocessing effects from the json file. Each effect can be:
+            // - A shader path: a single stage at full resolution.
+            // - An object: a single stage {"shader": path, "scale": 0.5, "mipmaps": true, "uniforms": {"name": value}}.
+            //   Instead of "shader", the object can list per-pixel effects {"effects": ["fisheye", "vignette"]} which are fused
+            //   into one generated shader (see "postprocess_fusion::compose").
+            // - An array of the above: an ordered chain of stages where each stage reads the output of the previous one.
+            const nlohmann::json &effects = config["postprocess"];
+            auto parseEffect = [this](const nlohmann::json &effect)
             {
-                ShaderProgram *postprocessShader = new ShaderProgram();
-                postprocessShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
-                postprocessShader->attach(shader, GL_FRAGMENT_SHADER);
-                postprocessShader->link();
-                postprocessShaders.push_back(postprocessShader); //= push into vector of postprocessing shaders
-            }
+                PostprocessChain chain;
+                if (effect.is_array())
+                    for (const auto &stage : effect)
+                        appendPostprocessStages(chain, stage);
+                else
+                    appendPostprocessStages(chain, effect);
+                // An empty chain ("[]" or effects that all failed to load) is replaced by a copy so that the effects keep their indices
+                // and every chain has a first stage
+                if (chain.empty())
+                {
+                    std::cerr << "Postprocess effect " << postprocessEffects.size() << " has no stages, it is replaced by a plain copy" << std::endl;
+                    appendPostprocessStages(chain, "assets/shaders/postprocess/default.frag");
+                }
+                postprocessEffects.push_back(chain);
+            };
+            if (effects.is_array())
+                for (const auto &effect : effects)
+                    parseEffect(effect);
+            else
+                parseEffect(effects);
+
+            // If the last stage of an effect runs at a lower resolution, its output is upscaled to the window by a plain copy
+            upscaleShader = new ShaderProgram();
+            upscaleShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
+            upscaleShader->attach("assets/shaders/blit.frag", GL_FRAGMENT_SHADER);
+            upscaleShader->link();
 
-            // Create a postprocessing material for each shader added to the vector
-            if (postprocessShaders.size() > 0)
+            // Create a postprocessing material that will be shared by all the stages
+            if (postprocessEffects.size() > 0)
             {
                 postprocessMaterial = new TexturedMaterial();
-                postprocessMaterial->shader = postprocessShaders[0]; //= the default postprocessing effect does nothing.
-                postprocessMaterial->texture = colorTarget;
+                postprocessMaterial->shader = postprocessEffects[0][0].shader; //= the default postprocessing effect does nothing.
+                // The texture is the input of the stage which is assigned by the frame graph every frame
+                postprocessMaterial->texture = nullptr;
                 postprocessMaterial->sampler = postprocessSampler;
 
                 // The default options are fine but we don't need to interact with the depth buffer
@@ -137,6 +154,104 @@ namespace our
                 postprocessMaterial->pipelineState.depthMask = false;
             }
         }
+
+        // Then we check if dynamic resolution is requested in the configuration
+        if (config.contains("dynamicResolution"))
+        {
+            dynamicResolution.deserialize(config["dynamicResolution"]);
+            if (dynamicResolution.enabled)
+            {
+                // The upscale is a fullscreen triangle just like the postprocessing stages
+                if (!postProcessVertexArray)
+                    glGenVertexArrays(1, &postProcessVertexArray);
+
+                ShaderProgram *shader = new ShaderProgram();
+                shader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
+                shader->attach("assets/shaders/upscale.frag", GL_FRAGMENT_SHADER);
+                shader->link();
+
+                // The upscale relies on bilinear filtering to interpolate between the pixels of the scene
+                Sampler *upscaleSampler = new Sampler();
+                upscaleSampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                upscaleSampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                upscaleSampler->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                upscaleSampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+                upscaleMaterial = new TexturedMaterial();
+                upscaleMaterial->shader = shader;
+                upscaleMaterial->texture = nullptr;
+                upscaleMaterial->sampler = upscaleSampler;
+                upscaleMaterial->pipelineState.depthMask = false;
+            }
+        }
+    }
+
+    void ForwardRenderer::appendPostprocessStages(PostprocessChain &chain, const nlohmann::json &config)
+    {
+        PostprocessStage stage;
+        std::string fragmentShader;
+        std::vector<std::string> effects;
+        if (config.is_string())
+        {
+            fragmentShader = config.get<std::string>();
+        }
+        else if (config.is_object())
+        {
+            fragmentShader = config.value<std::string>("shader", "");
+            if (config.contains("effects") && config["effects"].is_array())
+                effects = config["effects"].get<std::vector<std::string>>();
+            // We don't allow stages larger than the window or smaller than a handful of pixels
+            stage.scale = glm::clamp(config.value("scale", 1.0f), 1.0f / 64.0f, 1.0f);
+            stage.mipmaps = config.value("mipmaps", false);
+            if (config.contains("uniforms") && config["uniforms"].is_object())
+            {
+                for (auto &[name, value] : config["uniforms"].items())
+                {
+                    PostprocessStage::Uniform uniform{name, 1, glm::vec4(0.0f)};
+                    if (value.is_number())
+                    {
+                        uniform.value.x = value.get<float>();
+                    }
+                    else if (value.is_array() && value.size() >= 1 && value.size() <= 4)
+                    {
+                        uniform.components = (int)value.size();
+                        for (int i = 0; i < uniform.components; i++)
+                            uniform.value[i] = value[i].get<float>();
+                    }
+                    else
+                    {
+                        std::cerr << "Ignoring postprocess uniform \"" << name << "\": expected a number or an array of 1 to 4 numbers" << std::endl;
+                        continue;
+                    }
+                    stage.uniforms.push_back(uniform);
+                }
+            }
+        }
+        if (effects.empty())
+        {
+            stage.shader = new ShaderProgram();
+            stage.shader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
+            stage.shader->attach(fragmentShader, GL_FRAGMENT_SHADER);
+            stage.shader->link();
+            chain.push_back(stage);
+            return;
+        }
+
+        // The effects are fused at load time into as few shaders as possible (usually one), so the whole list costs
+        // a single fullscreen pass instead of a pass (and a full framebuffer round trip) per effect
+        bool first = true;
+        for (auto &fused : postprocess_fusion::compose(effects))
+        {
+            PostprocessStage part = stage;
+            // Only the first pass reads the input of the stage, so only it needs its mip levels
+            part.mipmaps = first && stage.mipmaps;
+            first = false;
+            part.shader = new ShaderProgram();
+            part.shader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
+            part.shader->attachSource(fused.source, GL_FRAGMENT_SHADER, "fused postprocess (" + fused.name + ")");
+            part.shader->link();
+            chain.push_back(part);
+        }
     }
 
     void ForwardRenderer::destroy()
@@ -151,65 +266,242 @@ namespace our
             delete skyMaterial;
         }
         // Delete all objects related to post processing
+        // (the samplers and the upscale shader are created whenever "postprocess" is in the config, even if it lists no effects)
+        delete postprocessSampler;
+        delete postprocessMipSampler;
+        delete upscaleShader;
+        postprocessSampler = postprocessMipSampler = nullptr;
+        upscaleShader = nullptr;
+        for (auto &chain : postprocessEffects)
+            for (auto &stage : chain)
+                delete stage.shader;
+        postprocessEffects.clear();
         if (postprocessMaterial)
         {
-            glDeleteFramebuffers(1, &postprocessFrameBuffer);
-            glDeleteVertexArrays(1, &postProcessVertexArray);
-            delete colorTarget;
-            delete depthTarget;
-            delete postprocessMaterial->sampler;
-            delete postprocessMaterial->shader;
             delete postprocessMaterial;
+            postprocessMaterial = nullptr;
 
-            postprocessShaders.clear();
-            lightings.clear();
+            packet.lights.clear();
             this->postprocessingIndex = 0;
             this->postprocessEffect = false;
         }
+        // Delete all objects related to dynamic resolution
+        if (upscaleMaterial)
+        {
+            delete upscaleMaterial->shader;
+            delete upscaleMaterial->sampler;
+            delete upscaleMaterial;
+            upscaleMaterial = nullptr;
+        }
+        if (postProcessVertexArray)
+        {
+            GLStateCache::current().onVertexArrayDeleted(postProcessVertexArray);
+            glDeleteVertexArrays(1, &postProcessVertexArray);
+            postProcessVertexArray = 0;
+        }
+        // Delete the render targets and their framebuffers and the timer queries
+        frameGraph.reset();
+        impostors.destroy();
+        staticBatcher.destroy();
+        gpuTimer.destroy();
+        uniformRing.destroy();
+        renderTargets.destroy();
     }
 
-    void ForwardRenderer::render(World *world)
+    void ForwardRenderer::writeFrameBlock(const FramePacket &packet)
     {
-        // First of all, we search for a camera and for all the mesh renderers
-        CameraComponent *camera = nullptr;
-        opaqueCommands.clear();
-        transparentCommands.clear();
-        lightings.clear();
-
-        for (auto entity : world->getEntities())
+        UniformRingBuffer::Allocation allocation = uniformRing.allocate(sizeof(uniform_blocks::Frame));
+        auto *frame = static_cast<uniform_blocks::Frame *>(allocation.data);
+        frame->VP = packet.VP;
+        frame->cameraPosition = packet.cameraPosition;
+        frame->lightCount = (GLint)std::min(packet.lights.size(), (size_t)uniform_blocks::MAX_LIGHTS);
+        for (GLint index = 0; index < frame->lightCount; ++index)
         {
-            // If we hadn't found a camera yet, we look for a camera in this entity
-            if (!camera)
-                camera = entity->getComponent<CameraComponent>();
-            // If this entity has a mesh renderer component
+            const LightData &light = packet.lights[index];
+            uniform_blocks::Light &block = frame->lights[index];
+            block.type = (GLint)light.type;
+            block.position = glm::vec4(light.position, 1.0f);
+            block.direction = glm::vec4(light.direction, 0.0f);
+            block.diffuse = glm::vec4(light.diffuse, 0.0f);
+            block.specular = glm::vec4(light.specular, 0.0f);
+            block.attenuation = glm::vec4(light.attenuation, 0.0f);
+            block.coneAngles = light.coneAngles;
+        }
+        uniformRing.bind(uniform_blocks::FRAME_BINDING, allocation);
+    }
+
+    void ForwardRenderer::bakeImpostors(World *world)
+    {
+        if (!impostors.settings.enabled)
+            return;
+        PROFILE_ZONE("ForwardRenderer::bakeImpostors");
+        // Every (mesh, material) pair used by the world gets a row in the atlas (the set keeps them in a stable order)
+        std::set<std::pair<Mesh *, Material *>> candidates;
+        for (Entity *entity : world->getEntities())
             if (auto meshRenderer = entity->getComponent<MeshRendererComponent>(); meshRenderer)
+                if (impostors.isCandidate(meshRenderer->mesh, meshRenderer->material))
+                    candidates.insert({meshRenderer->mesh, meshRenderer->material});
+
+        // The meshes are drawn with the same code as the frames, so they look the same as their impostors (apart from the lighting
+        // which is computed for the mesh at the origin). The packet only provides the lights, the camera of each view is set below.
+        FramePacket bakePacket;
+        generateCommands(world, bakePacket);
+        std::vector<RenderCommand> commands(1);
+        uniformRing.beginFrame();
+        bool baked = impostors.bake({candidates.begin(), candidates.end()}, [&](Mesh *mesh, Material *material, const glm::mat4 &VP, const glm::vec3 &eye)
+                                    {
+            bakePacket.VP = VP;
+            bakePacket.cameraPosition = eye;
+            writeFrameBlock(bakePacket);
+            commands[0] = {glm::mat4(1.0f), mesh->getBoundingCenter(), mesh, material, 0};
+            drawCommands(commands, bakePacket); });
+        uniformRing.endFrame();
+        if (baked)
+            std::cout << "Baked " << impostors.getImpostorCount() << " impostors" << std::endl;
+    }
+
+    void ForwardRenderer::drawCommands(const std::vector<RenderCommand> &commands, const FramePacket &packet)
+    {
+        const glm::mat4 &VP = packet.VP;
+        // The handles of the uniforms set for each command (only looked up again when the shader changes between commands)
+        static const char *const TRANSFORM_NAMES[] = {"transform"};
+        static const char *const SKY_NAMES[] = {"sky.top", "sky.middle", "sky.bottom"};
+        UniformHandles<1> transformUniforms;
+        UniformHandles<3> skyUniforms;
+        for (const RenderCommand &command : commands)
+        {
+            /// to draw the command, first the material must be setup
+            /// the shader transformation matrix must be set for each command
+            /// the VP matrix is common for all since it's camera related, changing the camera view or/and position will change that
+            /// each command has a local-to-world transformation matrix, multiplying that by the VP matix allows determining the final transformation matrix
+            /// the last step is actually drawing the respective mesh of the commands
+            command.material->setup();
+
+            // Here we render the light on lit materials
+            if (auto lightingMaterial = dynamic_cast<LightMaterial *>(command.material); lightingMaterial)
             {
-                // We construct a command from it
-                RenderCommand command;
-                command.localToWorld = meshRenderer->getOwner()->getLocalToWorldMatrix();
-                command.center = glm::vec3(command.localToWorld * glm::vec4(0, 0, 0, 1));
-                command.mesh = meshRenderer->mesh;
-                command.material = meshRenderer->material;
-                // if it is transparent, we add it to the transparent commands list
-                if (command.material->transparent)
+                // The model matrix and its inverse transpose are written into the ring buffer and bound as the object block
+                // (the VP matrix, the camera position and the lights are in the frame block which is bound once per frame)
+                UniformRingBuffer::Allocation allocation = uniformRing.allocate(sizeof(uniform_blocks::Object));
+                auto *object = static_cast<uniform_blocks::Object *>(allocation.data);
+                object->M = command.localToWorld;
+                object->M_IT = glm::transpose(glm::inverse(command.localToWorld));
+                uniformRing.bind(uniform_blocks::OBJECT_BINDING, allocation);
+
+                // (these never change, so they are only sent the first time thanks to the shadowed uniform values)
+                skyUniforms.resolve(lightingMaterial->shader, SKY_NAMES);
+                lightingMaterial->shader->set(skyUniforms[0], glm::vec3(0.7, 0.3, 0.8));
+                lightingMaterial->shader->set(skyUniforms[1], glm::vec3(0.7, 0.3, 0.8));
+                lightingMaterial->shader->set(skyUniforms[2], glm::vec3(0.7, 0.3, 0.8));
+            }
+            else
+            {
+                transformUniforms.resolve(command.material->shader, TRANSFORM_NAMES);
+                command.material->shader->set(transformUniforms[0], VP * command.localToWorld);
+            }
+            command.mesh->draw(command.lod);
+        }
+    }
+
+    CameraComponent *ForwardRenderer::generateCommands(World *world, FramePacket &packet)
+    {
+        PROFILE_ZONE("ForwardRenderer::generateCommands");
+        // The entities are in a set, so we copy them to a vector to be able to split them into chunks
+        const auto &entities = world->getEntities();
+        entityList.assign(entities.begin(), entities.end());
+        size_t chunkCount = (entityList.size() + COMMAND_CHUNK_SIZE - 1) / COMMAND_CHUNK_SIZE;
+        if (commandBuckets.size() < chunkCount)
+            commandBuckets.resize(chunkCount);
+
+        // Each chunk only reads the entities & components and writes to its own bucket, so the chunks need no synchronization
+        // (small worlds fit in a single chunk which runs on the calling thread)
+        ThreadPool::shared().parallelFor(chunkCount, [this](size_t chunk)
+                                         {
+            PROFILE_ZONE("ForwardRenderer::generateCommands chunk");
+            CommandBucket &bucket = commandBuckets[chunk];
+            bucket.opaque.clear();
+            bucket.transparent.clear();
+            bucket.lights.clear();
+            bucket.impostors.clear();
+            bucket.camera = nullptr;
+            size_t end = std::min(entityList.size(), (chunk + 1) * COMMAND_CHUNK_SIZE);
+            for (size_t index = chunk * COMMAND_CHUNK_SIZE; index < end; ++index)
+            {
+                Entity *entity = entityList[index];
+                // If we hadn't found a camera yet, we look for a camera in this entity
+                if (!bucket.camera)
+                    bucket.camera = entity->getComponent<CameraComponent>();
+                // If this entity has a mesh renderer component (that isn't drawn as a part of a static batch)
+                if (auto meshRenderer = entity->getComponent<MeshRendererComponent>(); meshRenderer && !meshRenderer->batched)
                 {
-                    transparentCommands.push_back(command);
+                    // We construct a command from it
+                    RenderCommand command;
+                    command.localToWorld = meshRenderer->getOwner()->getLocalToWorldMatrix();
+                    command.center = glm::vec3(command.localToWorld * glm::vec4(0, 0, 0, 1));
+                    command.mesh = meshRenderer->mesh;
+                    command.material = meshRenderer->material;
+                    // Far meshes that have an impostor only add an instance to the impostor batch
+                    // (each mesh renderer belongs to a single chunk, so updating its state here is safe)
+                    int impostor = impostors.find(command.mesh, command.material);
+                    if (selectImpostor(meshRenderer, command.localToWorld, impostor))
+                    {
+                        bucket.impostors.push_back(impostors.makeInstance(impostor, command.localToWorld, lodView.position));
+                    }
+                    else
+                    {
+                        command.lod = selectLOD(meshRenderer, command.localToWorld);
+                        // if it is transparent, we add it to the transparent commands list, otherwise we add it to the opaque command list
+                        if (command.material->transparent)
+                            bucket.transparent.push_back(command);
+                        else
+                            bucket.opaque.push_back(command);
+                    }
                 }
-                else
+                // Add lights to a list (with their position & direction in world space)
+                if (auto light = entity->getComponent<LightComponent>(); light)
                 {
-                    // Otherwise, we add it to the opaque command list
-                    opaqueCommands.push_back(command);
+                    glm::mat4 lightToWorld = entity->getLocalToWorldMatrix();
+                    bucket.lights.push_back({light->lightType,
+                                             glm::vec3(lightToWorld * glm::vec4(0, 0, 0, 1)),
+                                             glm::vec3(lightToWorld * glm::vec4(0, 0, -1, 0)),
+                                             light->diffuse, light->specular, light->attenuation, light->coneAngles});
                 }
-            }
+            } });
 
-            // Add lights to a list
-            if (auto light = entity->getComponent<LightComponent>(); light)
-            {
-                lightings.push_back(light);
-            }
+        // Then we merge the buckets in chunk order (the first camera of the first chunk that has one is the first camera overall)
+        CameraComponent *camera = nullptr;
+        packet.opaqueCommands.clear();
+        packet.transparentCommands.clear();
+        packet.lights.clear();
+        packet.impostors.clear();
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            CommandBucket &bucket = commandBuckets[chunk];
+            if (!camera)
+                camera = bucket.camera;
+            packet.opaqueCommands.insert(packet.opaqueCommands.end(), bucket.opaque.begin(), bucket.opaque.end());
+            packet.transparentCommands.insert(packet.transparentCommands.end(), bucket.transparent.begin(), bucket.transparent.end());
+            packet.lights.insert(packet.lights.end(), bucket.lights.begin(), bucket.lights.end());
+            packet.impostors.insert(packet.impostors.end(), bucket.impostors.begin(), bucket.impostors.end());
         }
+        return camera;
+    }
+
+    void ForwardRenderer::render(World *world)
+    {
+        PROFILE_ZONE("ForwardRenderer::render");
+        buildPacket(world, packet);
+        submit(packet);
+    }
+
+    void ForwardRenderer::buildPacket(World *world, FramePacket &packet)
+    {
+        PROFILE_ZONE("ForwardRenderer::buildPacket");
+        // First of all, we search for a camera and for all the mesh renderers
+        CameraComponent *camera = generateCommands(world, packet);
 
         // If there is no camera, we return (we cannot render without a camera)
+        packet.hasCamera = camera != nullptr;
         if (camera == nullptr)
             return;
 
@@ -223,7 +515,22 @@ namespace our
         glm::vec4 foroward_direction = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
         glm::vec3 cameraForward = camera->getOwner()->getLocalToWorldMatrix() * foroward_direction;
 
-        std::sort(transparentCommands.begin(), transparentCommands.end(), [cameraForward](const RenderCommand &first, const RenderCommand &second)
+        packet.VP = camera->getProjectionMatrix(windowSize) * camera->getViewMatrix();
+
+        // The static batches are already in world space. Only the ones that intersect the view volume are drawn.
+        Frustum frustum(packet.VP);
+        for (const auto &batch : staticBatcher.getBatches())
+        {
+            if (!frustum.intersects(batch.mesh->getBoundingCenter(), batch.mesh->getBoundingRadius()))
+                continue;
+            RenderCommand command{glm::mat4(1.0f), batch.mesh->getBoundingCenter(), batch.mesh, batch.material, 0};
+            if (command.material->transparent)
+                packet.transparentCommands.push_back(command);
+            else
+                packet.opaqueCommands.push_back(command);
+        }
+
+        std::sort(packet.transparentCommands.begin(), packet.transparentCommands.end(), [cameraForward](const RenderCommand &first, const RenderCommand &second)
                   {
             //TODO: (Req 9) Finish this function
             // HINT: the following return should return true "first" should be drawn before "second". 
@@ -233,236 +540,267 @@ namespace our
             return glm::dot(cameraForward, first.center) > glm::dot(cameraForward, second.center); });
 
         // TODO: (Req 9) Get the camera ViewProjection matrix and store it in VP
+        // (it is computed above since the static batches are culled against it)
 
-        glm::mat4 VP = camera->getProjectionMatrix(windowSize) * camera->getViewMatrix();
+        packet.cameraPosition = camera->getOwner()->getLocalToWorldMatrix() * glm::vec4(0, 0, 0, 1);
 
-        // TODO: (Req 9) Set the OpenGL viewport using viewportStart and viewportSize
+        packet.postprocessEffect = postprocessEffect;
+        packet.postprocessingIndex = postprocessingIndex;
 
-        /// starting from the bottom left corner 0,0 till window size in both directions
-        glViewport(0, 0, windowSize.x, windowSize.y);
+        // Remember the camera for the level of detail selection of the next frame (it needs a perspective projection)
+        lodView.valid = camera->cameraType == CameraType::PERSPECTIVE;
+        lodView.position = packet.cameraPosition;
+        lodView.projectionScale = 1.0f / glm::tan(camera->fovY * 0.5f);
+    }
 
-        // TODO: (Req 9) Set the clear color to black and the clear depth to 1
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClearDepth(1.0f);
+    float ForwardRenderer::getScreenCoverage(Mesh *mesh, const glm::mat4 &localToWorld) const
+    {
+        // The largest axis scale is used for non-uniform scales
+        glm::vec3 center = localToWorld * glm::vec4(mesh->getBoundingCenter(), 1.0f);
+        float scale = glm::max(glm::length(glm::vec3(localToWorld[0])), glm::max(glm::length(glm::vec3(localToWorld[1])), glm::length(glm::vec3(localToWorld[2]))));
+        float distance = glm::distance(center, lodView.position);
+        return distance > 0.0f ? mesh->getBoundingRadius() * scale * lodView.projectionScale / distance : 1.0f;
+    }
 
-        // TODO: (Req 9) Set the color mask to true and the depth mask to true (to ensure the glClear will affect the framebuffer)
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-        glDepthMask(GL_TRUE);
+    bool ForwardRenderer::selectImpostor(MeshRendererComponent *meshRenderer, const glm::mat4 &localToWorld, int impostor) const
+    {
+        if (impostor < 0 || !lodView.valid)
+            return meshRenderer->impostor = false;
+        float threshold = impostors.settings.threshold * (meshRenderer->impostor ? 1.0f + lodSettings.hysteresis : 1.0f - lodSettings.hysteresis);
+        return meshRenderer->impostor = getScreenCoverage(meshRenderer->mesh, localToWorld) < threshold;
+    }
+
+    int ForwardRenderer::selectLOD(MeshRendererComponent *meshRenderer, const glm::mat4 &localToWorld) const
+    {
+        Mesh *mesh = meshRenderer->mesh;
+        int count = mesh->getLODCount();
+        if (!lodSettings.enabled || !lodView.valid || count == 1)
+            return meshRenderer->lod = 0;
+
+        float coverage = getScreenCoverage(mesh, localToWorld);
+
+        // The switching point between the levels (level - 1) and level
+        auto switchingPoint = [this](int level)
+        { return lodSettings.threshold / float(1 << (level - 1)); };
+        int lod = glm::clamp(meshRenderer->lod, 0, count - 1);
+        while (lod + 1 < count && coverage < switchingPoint(lod + 1) * (1.0f - lodSettings.hysteresis))
+            ++lod;
+        while (lod > 0 && coverage > switchingPoint(lod) * (1.0f + lodSettings.hysteresis))
+            --lod;
+        return meshRenderer->lod = lod;
+    }
 
-        // If there is a postprocess material, bind the framebuffer
-        if (postprocessEffect && postprocessMaterial)
+    void ForwardRenderer::submit(const FramePacket &packet)
+    {
+        PROFILE_ZONE("ForwardRenderer::submit");
+        submittedOpaqueCommands = packet.opaqueCommands.size();
+        submittedTransparentCommands = packet.transparentCommands.size();
+        submittedLights = packet.lights.size();
+        submittedImpostors = packet.impostors.size();
+        if (!packet.hasCamera)
+            return;
+        const glm::vec3 cameraPosition = packet.cameraPosition;
+        const glm::mat4 VP = packet.VP;
+
+        // The frame block is written once and stays bound for all the lit draws of the frame
+        uniformRing.beginFrame();
+        writeFrameBlock(packet);
+
+        // Now we describe the frame as a graph of passes. The viewport, the framebuffer binding and the clears
+        // (black color & depth = 1 on the first write of each target) are handled by the graph before each pass runs.
+        frameGraph.reset();
+        renderTargets.beginFrame();
+        FrameGraph::Resource backbuffer = frameGraph.importBackbuffer(windowSize);
+
+        // With dynamic resolution, the scene is rendered at a fraction of the window size then upscaled
+        glm::ivec2 renderSize = windowSize;
+        if (dynamicResolution.enabled && upscaleMaterial)
+            renderSize = glm::max(glm::ivec2(glm::vec2(windowSize) * dynamicResolution.getScale()), glm::ivec2(1));
+        bool upscale = renderSize != windowSize;
+
+        // If there is a postprocess material (or the scene needs to be upscaled), the scene is drawn to transient color & depth targets instead of the window
+        bool postprocess = packet.postprocessEffect && postprocessMaterial;
+        // If the first postprocess stage downsamples its input through its mip levels, the input needs a full mip chain
+        GLsizei postprocessLevels = postprocess && postprocessEffects[packet.postprocessingIndex][0].mipmaps ? RenderTargetDescription::fullMipChain(windowSize) : 1;
+        FrameGraph::Resource sceneColor = backbuffer, sceneDepth = backbuffer;
+        if (postprocess || upscale)
         {
-            // TODO: (Req 11) bind the framebuffer
-            // if the postprocess material is not null
-            // bind the postprocess framebuffer ta draw on it
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, postprocessFrameBuffer);
+            sceneColor = frameGraph.createTexture("scene-color", {renderSize, GL_RGBA8, upscale ? 1 : postprocessLevels});
+            sceneDepth = frameGraph.createTexture("scene-depth", {renderSize, GL_DEPTH_COMPONENT24});
         }
 
-        // TODO: (Req 9) Clear the color and depth buffers
-
-        /// clear the color and depth buffers by setting their corresponding bits
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
         // TODO: (Req 9) Draw all the opaque commands
-        //  Don't forget to set the "transform" uniform to be equal the model-view-projection matrix for each render command
-        for (RenderCommand command : opaqueCommands)
-        {
-            /// to draw the command, first the material must be setup
-            /// the shader transformation matrix must be set for each command
-            /// the VP matrix is common for all since it's camera related, changing the camera view or/and position will change that
-            /// each command has a local-to-world transformation matrix, multiplying that by the VP matix allows determining the final transformation matrix
-            /// the last step is actually drawing the respective mesh of the commands
-            command.material->setup();
-
-            // Here we render the light on opaque materials
-            // We loop on all lightining materials
-            if (auto lightingMaterial = dynamic_cast<LightMaterial *>(command.material); lightingMaterial)
+        frameGraph.addPass(
+            "opaque", [&](FrameGraph::Builder &builder)
             {
-                // Calculate the VP , M, M inverse, camera position
-                lightingMaterial->shader->set("VP", VP);
-                lightingMaterial->shader->set("M", command.localToWorld);
-                lightingMaterial->shader->set("M_IT", glm::transpose(glm::inverse(command.localToWorld)));
-                command.material->shader->set("camera_position", glm::vec3(camera->getOwner()->getLocalToWorldMatrix() * glm::vec4(0, 0, 0, 1))); //normalize
-
-                // Send the lights' data to the fragement shaders
-                lightingMaterial->shader->set("light_count", (int)lightings.size());
-                lightingMaterial->shader->set("sky.top", glm::vec3(0.7, 0.3, 0.8));
-                lightingMaterial->shader->set("sky.middle", glm::vec3(0.7, 0.3, 0.8));
-                lightingMaterial->shader->set("sky.bottom", glm::vec3(0.7, 0.3, 0.8));
-
-                // loop on the lightings list and set each one of them sending its data to the fragement shader
-                for (unsigned i = 0; i < lightings.size(); i++)
-                {
-                    // Calculate the position and direction relative to the world it's in
-                    // It can be dynamic inheriting its parent position and direction
-                    glm::vec3 lightPosition = lightings[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(0, 0, 0, 1);
-                    glm::vec3 lightDirection = lightings[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(0, 0, -1, 0);
-
-                    // Send the lights' data to the fragement shaders
-                    std::string lightName = "lights[" + std::to_string(i) + "]";
-                    lightingMaterial->shader->set(lightName + ".type", (GLint)lightings[i]->lightType);
-                    lightingMaterial->shader->set(lightName + ".diffuse", lightings[i]->diffuse);
-                    lightingMaterial->shader->set(lightName + ".specular", lightings[i]->specular);
-                    lightingMaterial->shader->set(lightName + ".attenuation", lightings[i]->attenuation);
-
-                    // Send lights data according to its type from the 3
-                    if (lightings[i]->lightType == LIGHT_TYPE::DIRECTIONAL)
-                    {
-                        lightingMaterial->shader->set(lightName + ".direction", lightDirection);
-                    }
-                    else if (lightings[i]->lightType == LIGHT_TYPE::POINT)
-                    {
-                        lightingMaterial->shader->set(lightName + ".position", lightPosition);
-                    }
-                    else if (lightings[i]->lightType == LIGHT_TYPE::SPOT)
-                    {
-                        lightingMaterial->shader->set(lightName + ".position", lightPosition);
-                        lightingMaterial->shader->set(lightName + ".direction", lightDirection);
-                        lightingMaterial->shader->set(lightName + ".cone_angles", lightings[i]->coneAngles);
-                    }
-                }
-            }
-            else
+                builder.writeColor(sceneColor, true, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+                builder.writeDepth(sceneDepth, true, 1.0f); },
+            [this, &packet](FrameGraph &)
             {
-                command.material->shader->set("transform", VP * command.localToWorld);
-            }
-            command.mesh->draw();
-        }
+                drawCommands(packet.opaqueCommands, packet);
+                impostors.draw(packet.impostors, packet.VP, packet.cameraPosition, uniformRing); });
 
         // If there is a sky material, draw the sky
         if (this->skyMaterial)
         {
-
-            // TODO: (Req 10) setup the sky material
-            this->skyMaterial->setup();
-
-            // TODO: (Req 10) Get the camera position
-            glm::vec3 cameraPosition = camera->getOwner()->getLocalToWorldMatrix() * glm::vec4(0, 0, 0, 1.0);
-
-            // TODO: (Req 10) Create a model matrix for the sky such that it always follows the camera (sky sphere center = camera position)
-            glm::mat4 identity(1.0f);
-            glm::mat4 M = glm::translate(identity, cameraPosition); // translating shpere position to camera position
-
-            // TODO: (Req 10) We want the sky to be drawn behind everything (in NDC space, z=1)
-            //  We can acheive the is by multiplying by an extra matrix after the projection but what values should we put in it?
-
-            /// same steps as the drawing transparent commands above, only the extra projection matrix to put the sky in the back
-            /// is added, the values are of the matrix are put such that the x and y are components are preserved and the z component is set to 1
-            glm::mat4 alwaysBehindTransform = glm::mat4(
-                1.0f, 0.0f, 0.0f, 0.0f,
-                0.0f, 1.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 0.0f, 0.0f,
-                0.0f, 0.0f, 1.0f, 1.0f);
-
-            // TODO: (Req 10) set the "transform" uniform
-            glm::mat4 skyTransform = alwaysBehindTransform * VP * M; // trasforming sky to depth = 1
-            this->skyMaterial->shader->set("transform", skyTransform);
-            // TODO: (Req 10) draw the sky sphere
-            this->skySphere->draw();
+            frameGraph.addPass(
+                "sky", [&](FrameGraph::Builder &builder)
+                {
+                    builder.writeColor(sceneColor);
+                    builder.writeDepth(sceneDepth); },
+                [this, VP, cameraPosition](FrameGraph &)
+                {
+                    // TODO: (Req 10) setup the sky material
+                    this->skyMaterial->setup();
+
+                    // TODO: (Req 10) Create a model matrix for the sky such that it always follows the camera (sky sphere center = camera position)
+                    glm::mat4 identity(1.0f);
+                    glm::mat4 M = glm::translate(identity, cameraPosition); // translating shpere position to camera position
+
+                    // TODO: (Req 10) We want the sky to be drawn behind everything (in NDC space, z=1)
+                    //  We can acheive the is by multiplying by an extra matrix after the projection but what values should we put in it?
+
+                    /// the values are of the matrix are put such that the x and y are components are preserved and the z component is set to 1
+                    glm::mat4 alwaysBehindTransform = glm::mat4(
+                        1.0f, 0.0f, 0.0f, 0.0f,
+                        0.0f, 1.0f, 0.0f, 0.0f,
+                        0.0f, 0.0f, 0.0f, 0.0f,
+                        0.0f, 0.0f, 1.0f, 1.0f);
+
+                    // TODO: (Req 10) set the "transform" uniform
+                    glm::mat4 skyTransform = alwaysBehindTransform * VP * M; // trasforming sky to depth = 1
+                    this->skyMaterial->shader->set("transform", skyTransform);
+                    // TODO: (Req 10) draw the sky sphere
+                    this->skySphere->draw(); });
         }
-        // TODO: (Req 9) Draw all the transparent commands
-        //  Don't forget to set the "transform" uniform to be equal the model-view-projection matrix for each render command
-        for (RenderCommand command : transparentCommands)
-        {
-            /// to draw the command, first the material must be setup
-            /// the shader transformation matrix must be set for each command
-            /// the VP matrix is common for all since it's camera related, changing the camera view or/and position will change that
-            /// each command has a local-to-world transformation matrix, multiplying that by the VP matix allows determining the final transformation matrix
-            /// the last step is actually drawing the respective mesh of the commands
 
-            command.material->setup();
-
-            // Here we render the light on transparent materials
-            // We loop on all lightining materials
-            if (auto lightingMaterial = dynamic_cast<LightMaterial *>(command.material); lightingMaterial)
+        // TODO: (Req 9) Draw all the transparent commands
+        frameGraph.addPass(
+            "transparent", [&](FrameGraph::Builder &builder)
             {
-                // Calculate the VP , M, M inverse, camera position
-                lightingMaterial->shader->set("VP", VP);
-                lightingMaterial->shader->set("M", command.localToWorld);
-                lightingMaterial->shader->set("M_IT", glm::transpose(glm::inverse(command.localToWorld)));
-                command.material->shader->set("camera_position", glm::vec3(camera->getOwner()->getLocalToWorldMatrix() * glm::vec4(0, 0, 0, 1)));
-
-                // Send the lights' data to the fragement shader
-                lightingMaterial->shader->set("light_count", (int)lightings.size());
-                lightingMaterial->shader->set("sky.top", glm::vec3(0.7, 0.3, 0.8));
-                lightingMaterial->shader->set("sky.middle", glm::vec3(0.7, 0.3, 0.8));
-                lightingMaterial->shader->set("sky.bottom", glm::vec3(0.7, 0.3, 0.8));
-
-                for (unsigned i = 0; i < lightings.size(); i++)
+                builder.writeColor(sceneColor);
+                builder.writeDepth(sceneDepth); },
+            [this, &packet](FrameGraph &)
+            { drawCommands(packet.transparentCommands, packet); });
+
+        // If the scene was rendered at a lower resolution, upscale it to the window size (or to the input of the postprocessing)
+        FrameGraph::Resource postprocessInput = sceneColor;
+        if (upscale)
+        {
+            postprocessInput = postprocess ? frameGraph.createTexture("scene-upscaled", {windowSize, GL_RGBA8, postprocessLevels}) : backbuffer;
+            frameGraph.addPass(
+                "upscale", [&](FrameGraph::Builder &builder)
+                {
+                    builder.read(sceneColor);
+                    builder.writeColor(postprocessInput); },
+                [this, sceneColor](FrameGraph &graph)
                 {
-                    // Calculate the position and direction relative to the world it's in
-                    // It can be dynamic inheriting its parent position and direction
-                    glm::vec3 lightPosition = lightings[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(0, 0, 0, 1);
-                    glm::vec3 lightDirection = lightings[i]->getOwner()->getLocalToWorldMatrix() * glm::vec4(0, 0, -1, 0);
+                    upscaleMaterial->texture = graph.getTexture(sceneColor);
+                    upscaleMaterial->setup();
+                    upscaleMaterial->shader->set("sharpness", dynamicResolution.sharpness);
+                    GLStateCache::current().bindVertexArray(postProcessVertexArray);
+                    glDrawArrays(GL_TRIANGLES, 0, 3);
+                    GLStateCache::current().countDraw(1); });
+        }
 
-                    std::string lightName = "lights[" + std::to_string(i) + "]";
+        // If there is a postprocess material, apply postprocessing
+        if (postprocess)
+            addPostprocessPasses(packet.postprocessingIndex, postprocessInput, backbuffer);
+
+        // Finally, cull the unused passes, assign the render targets and run the passes
+        PROFILE_ZONE("ForwardRenderer::execute");
+        frameGraph.compile();
+        gpuTimer.beginFrame();
+        frameGraph.execute(renderTargets, &gpuTimer);
+        gpuTimer.endFrame();
+        uniformRing.endFrame();
+
+        // When the resolution changes, the targets of the old sizes stay in the pool so they can be reused if we come back to that size.
+        // We free the ones that weren't used for a few seconds.
+        if (dynamicResolution.enabled)
+            renderTargets.trim(240);
+    }
 
-                    // Send the lights' data to the fragement shader
-                    lightingMaterial->shader->set(lightName + ".type", (GLint)lightings[i]->lightType);
-                    lightingMaterial->shader->set(lightName + ".diffuse", lightings[i]->diffuse);
-                    lightingMaterial->shader->set(lightName + ".specular", lightings[i]->specular);
-                    lightingMaterial->shader->set(lightName + ".attenuation", lightings[i]->attenuation);
+    void ForwardRenderer::addPostprocessPasses(int effect, FrameGraph::Resource sceneColor, FrameGraph::Resource backbuffer)
+    {
+        const PostprocessChain &chain = postprocessEffects[effect];
 
-                    // Send the lights' data depending on its type to the fragement shader
-                    if (lightings[i]->lightType == LIGHT_TYPE::DIRECTIONAL)
-                    {
-                        lightingMaterial->shader->set(lightName + ".direction", lightDirection);
-                    }
-                    else if (lightings[i]->lightType == LIGHT_TYPE::POINT)
+        // Draws a fullscreen triangle that samples "input" with the given shader
+        auto addFullscreenPass = [this](const std::string &name, const PostprocessStage *stage, ShaderProgram *shader,
+                                         FrameGraph::Resource input, FrameGraph::Resource output)
+        {
+            frameGraph.addPass(
+                name, [&](FrameGraph::Builder &builder)
+                {
+                    builder.read(input);
+                    builder.writeColor(output); },
+                [this, stage, shader, input](FrameGraph &graph)
+                {
+                    // TODO: (Req 11) Setup the postprocess material and draw the fullscreen triangle
+                    Texture2D *inputTexture = graph.getTexture(input);
+                    bool mipmaps = stage && stage->mipmaps;
+                    if (mipmaps)
                     {
-                        lightingMaterial->shader->set(lightName + ".position", lightPosition);
+                        // Downsampling by more than 2x reads the input's mip levels so that every input pixel contributes
+                        inputTexture->bind();
+                        glGenerateMipmap(GL_TEXTURE_2D);
                     }
-                    else if (lightings[i]->lightType == LIGHT_TYPE::SPOT)
+                    postprocessMaterial->shader = shader;
+                    postprocessMaterial->texture = inputTexture;
+                    postprocessMaterial->sampler = mipmaps ? postprocessMipSampler : postprocessSampler;
+                    postprocessMaterial->setup();
+                    if (stage)
                     {
-                        lightingMaterial->shader->set(lightName + ".position", lightPosition);
-                        lightingMaterial->shader->set(lightName + ".direction", lightDirection);
-                        lightingMaterial->shader->set(lightName + ".cone_angles", lightings[i]->coneAngles);
+                        for (const auto &uniform : stage->uniforms)
+                        {
+                            switch (uniform.components)
+                            {
+                            case 1: shader->set(uniform.name, uniform.value.x); break;
+                            case 2: shader->set(uniform.name, glm::vec2(uniform.value)); break;
+                            case 3: shader->set(uniform.name, glm::vec3(uniform.value)); break;
+                            default: shader->set(uniform.name, uniform.value); break;
+                            }
+                        }
                     }
-                }
-            }
-            else
-            {
-                command.material->shader->set("transform", VP * command.localToWorld);
-            }
 
-            command.mesh->draw();
-        }
-
-        // If there is a postprocess material, apply postprocessing
-        if (postprocessEffect && postprocessMaterial)
+                    // now we draw the triangle using the vertices in the post process vertex array
+                    // glDrawArrays begins from the index 0 and draws using the first three vertices which draws a single triangle
+                    GLStateCache::current().bindVertexArray(postProcessVertexArray);
+                    glDrawArrays(GL_TRIANGLES, 0, 3);
+                    GLStateCache::current().countDraw(1); });
+        };
+
+        // Each stage writes to a new transient target. Since the pool reuses a target as soon as its last reader is done,
+        // consecutive stages of the same size end up ping-ponging between two textures.
+        FrameGraph::Resource input = sceneColor;
+        for (size_t index = 0; index < chain.size(); index++)
         {
-            // TODO: (Req 11) Return to the default framebuffer
-            // unbind the postprocess framebuffer to return to the default framebuffer
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-
-            // TODO: (Req 11) Setup the postprocess material and draw the fullscreen triangle
-
-            // if postprocess material in not null
-            // setup the postprocess material
-            // this calls the setup of the textured material which sets uo the pipekine state, shader to use, tint,
-            // and other shader parameters to be used in the material
-            postprocessMaterial->setup();
-
-            // now we draw the triangle using the vertices in the post process vertex array
-            // first bind the post process vertex array to draw the traingle
-            glBindVertexArray(postProcessVertexArray);
-
-            // use glDrawArrays to draw the triangle
-            // first by specifying the mode of what we're drawing which is GL_TRIANGLES
-            // then by specifying the the fisrt vertex to be rendered in the bound vertex array
-            // lastly by specifying the number of vertices to be rendered
-            // this means that this function begins from the index 0 and draws using the first three vertices
-            // which draws a single triangle
-            glDrawArrays(GL_TRIANGLES, 0, 3);
+            const PostprocessStage &stage = chain[index];
+            bool last = index + 1 == chain.size();
+            FrameGraph::Resource output = backbuffer;
+            // The last stage draws directly to the window unless it runs at a lower resolution
+            if (!last || stage.scale < 1.0f)
+            {
+                glm::ivec2 size = glm::max(glm::ivec2(glm::vec2(windowSize) * stage.scale), glm::ivec2(1));
+                bool nextUsesMipmaps = !last && chain[index + 1].mipmaps;
+                GLsizei levels = nextUsesMipmaps ? RenderTargetDescription::fullMipChain(size) : 1;
+                output = frameGraph.createTexture("postprocess-" + std::to_string(index), {size, GL_RGBA8, levels});
+            }
+            addFullscreenPass("postprocess-" + std::to_string(index), &stage, stage.shader, input, output);
+            input = output;
         }
+        // The output of a reduced resolution last stage is upscaled (with bilinear filtering) to the window
+        if (input != backbuffer)
+            addFullscreenPass("postprocess-upscale", nullptr, upscaleShader, input, backbuffer);
     }
 
     void ForwardRenderer::setPostprocessingIndex(int index)
     {
         // Update the postprocessing index with the index passed
-        // Make the postproessing material use the shader at the given index
-        postprocessMaterial->shader = postprocessShaders[index];
-        // std::cout<<postprocessMaterial;
+        // Make the postproessing material use the first shader of the effect at the given index (the other stages are set while rendering)
+        if (index < 0 || index >= (int)postprocessEffects.size())
+            return;
+        postprocessMaterial->shader = postprocessEffects[index][0].shader;
         postprocessingIndex = index;
     }
 
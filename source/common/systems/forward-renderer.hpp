@@ -5,6 +5,11 @@
 #include "../components/mesh-renderer.hpp"
 #include "../asset-loader.hpp"
 #include "../components/lighting.hpp"
+#include "../framegraph/frame-graph.hpp"
+#include "../gl/uniform-ring-buffer.hpp"
+#include "dynamic-resolution.hpp"
+#include "impostor-atlas.hpp"
+#include "static-batcher.hpp"
 
 #include <glad/gl.h>
 #include <vector>
@@ -22,6 +27,37 @@ namespace our
         glm::vec3 center;
         Mesh *mesh;
         Material *material;
+        // The level of detail of the mesh to draw
+        int lod = 0;
+    };
+
+    // The data of a light copied out of its entity (the position & direction are already in world space)
+    struct LightData
+    {
+        LIGHT_TYPE type;
+        glm::vec3 position, direction;
+        glm::vec3 diffuse, specular, attenuation;
+        glm::vec2 coneAngles;
+    };
+
+    // A frame packet holds everything the renderer needs to draw a frame. It is built from the world by "ForwardRenderer::buildPacket"
+    // then drawn by "ForwardRenderer::submit". It only holds copies and pointers to assets (which don't change while the game runs),
+    // so once it is built, the world can be updated while the packet is being drawn.
+    struct FramePacket
+    {
+        // If the world has no camera, there is nothing to draw
+        bool hasCamera = false;
+        glm::mat4 VP = glm::mat4(1.0f);
+        glm::vec3 cameraPosition = glm::vec3(0.0f);
+        // The transparent commands are sorted from far to near
+        std::vector<RenderCommand> opaqueCommands;
+        std::vector<RenderCommand> transparentCommands;
+        std::vector<LightData> lights;
+        // The far instances that are replaced by impostors (they are drawn in a single batch after the opaque commands)
+        std::vector<ImpostorInstance> impostors;
+        // The postprocess state at the time the packet was built
+        bool postprocessEffect = false;
+        int postprocessingIndex = 0;
     };
 
     enum Postprocess
@@ -31,6 +67,30 @@ namespace our
         BLUR
     };
 
+    // A postprocess stage is a fullscreen pass that reads the output of the previous stage (or the scene color for the first stage)
+    // Stages can run at a fraction of the window resolution so that expensive effects (e.g. blurs) are applied to fewer pixels
+    struct PostprocessStage
+    {
+        // A constant uniform sent to the stage's shader (e.g. the direction of a separable blur)
+        struct Uniform
+        {
+            std::string name;
+            int components; // 1 for a float, 2 to 4 for vectors
+            glm::vec4 value;
+        };
+
+        ShaderProgram *shader = nullptr;
+        // The size of the stage's output relative to the window size (e.g. 0.5 for half resolution)
+        float scale = 1.0f;
+        // If true, the mip chain of the input is generated before the stage samples it.
+        // This is needed to downsample by more than 2x without skipping pixels (a single bilinear tap only averages 2x2 pixels).
+        bool mipmaps = false;
+        std::vector<Uniform> uniforms;
+    };
+
+    // A postprocess effect is an ordered chain of stages
+    using PostprocessChain = std::vector<PostprocessStage>;
+
     // A forward renderer is a renderer that draw the object final color directly to the framebuffer
     // In other words, the fragment shader in the material should output the color that we should see on the screen
     // This is different from more complex renderers that could draw intermediate data to a framebuffer before computing the final color
@@ -40,27 +100,104 @@ namespace our
         // These window size will be used on multiple occasions (setting the viewport, computing the aspect ratio, etc.)
         glm::ivec2 windowSize;
 
-        // These are two vectors in which we will store the opaque and the transparent commands.
-        // We define them here (instead of being local to the "render" function) as an optimization to prevent reallocating them every frame
-        std::vector<RenderCommand> opaqueCommands;
-        std::vector<RenderCommand> transparentCommands;
+        // The packet used by "render" to store the opaque & transparent commands and the lights.
+        // We define it here (instead of being local to the "render" function) as an optimization to prevent reallocating its vectors every frame
+        FramePacket packet;
+        // The number of commands and lights of the last submitted packet (for statistics)
+        size_t submittedOpaqueCommands = 0, submittedTransparentCommands = 0, submittedLights = 0, submittedImpostors = 0;
 
         // Objects used for rendering a skybox
-        Mesh *skySphere;
-        TexturedMaterial *skyMaterial;
+        Mesh *skySphere = nullptr;
+        TexturedMaterial *skyMaterial = nullptr;
 
         // Objects used for Postprocessing
-        GLuint postprocessFrameBuffer, postProcessVertexArray;
-        Texture2D *colorTarget, *depthTarget;
+        GLuint postProcessVertexArray = 0;
+
+        // The passes of each frame are described by a frame graph which is rebuilt every frame
+        // The render targets (e.g. the scene color & depth needed for postprocessing) are transient resources of the graph
+        // and their textures come from this pool, so they are only allocated once and shared between passes when possible
+        FrameGraph frameGraph;
+        RenderTargetPool renderTargets;
+        // Measures the GPU time of each pass of the frame graph
+        GPUTimer gpuTimer;
+        // The per-frame data (camera & lights) and the per-object data (model matrices) of the lit shaders are written into this
+        // ring buffer and bound as uniform block ranges, instead of being sent with individual glUniform calls for every draw
+        UniformRingBuffer uniformRing;
 
         // Objects for the postprocessing materials
-        TexturedMaterial *postprocessMaterial;
-        std::vector<our::ShaderProgram *> postprocessShaders;
-        // std::vector<our::TexturedMaterial *> postprocessMaterials;
+        // The material is shared by all the stages, its shader, texture and sampler are changed per stage
+        TexturedMaterial *postprocessMaterial = nullptr;
+        // The samplers used to read the input of a stage (the second one filters between mip levels)
+        Sampler *postprocessSampler = nullptr, *postprocessMipSampler = nullptr;
+        // The effects read from the configuration, only the one at "postprocessingIndex" is applied
+        std::vector<PostprocessChain> postprocessEffects;
+        // The shader used to upscale the output of the last stage to the window if it runs at a lower resolution
+        ShaderProgram *upscaleShader = nullptr;
         int postprocessingIndex = 0;
 
-        // Objects used for light
-        std::vector<LightComponent *> lightings;
+        // Objects used for dynamic resolution: the scene is rendered at a fraction of the window size picked by the controller
+        // then upscaled to the window size by the upscale material
+        DynamicResolution dynamicResolution;
+        TexturedMaterial *upscaleMaterial = nullptr;
+
+        // The commands are generated in parallel: the entities are split into chunks of COMMAND_CHUNK_SIZE entities,
+        // each chunk is processed by a worker of the thread pool into its own bucket, then the buckets are concatenated in chunk order.
+        // Since every chunk keeps the entity order, the lists are the same as if they were generated on a single thread.
+        // The buckets (like the command lists) are kept between frames so that their memory is reused.
+        struct CommandBucket
+        {
+            std::vector<RenderCommand> opaque, transparent;
+            std::vector<LightData> lights;
+            std::vector<ImpostorInstance> impostors;
+            CameraComponent *camera = nullptr;
+        };
+        static constexpr size_t COMMAND_CHUNK_SIZE = 256;
+        std::vector<Entity *> entityList;
+        std::vector<CommandBucket> commandBuckets;
+
+        // Level of detail selection: a mesh switches to its level i (i >= 1) once its bounding sphere covers less than
+        // threshold / 2^(i - 1) of the screen height. To avoid popping back and forth around a switching point, a mesh only moves
+        // to a coarser level when it is "hysteresis" (relative) below the point and only comes back when it is as much above it.
+        // The commands are generated before the camera is found, so the camera of the previous frame is used for the selection.
+        struct LODSettings
+        {
+            bool enabled = false;
+            float threshold = 0.25f;
+            float hysteresis = 0.15f;
+        } lodSettings;
+        struct LODView
+        {
+            bool valid = false;
+            glm::vec3 position;
+            float projectionScale; // 1 / tan(fovY / 2)
+        } lodView;
+
+        // The far opaque meshes are drawn as impostors (pictures of the mesh baked at load time) once they cover less than
+        // "impostors.settings.threshold" of the screen height. The same hysteresis as the levels of detail is applied.
+        ImpostorAtlas impostors;
+        // The meshes of the static entities are merged per material & chunk at load time. Each batch is drawn (if it is in view)
+        // with an identity model matrix instead of drawing its entities one by one.
+        StaticBatcher staticBatcher;
+
+        // Returns the fraction of the screen height covered by the bounding sphere of the mesh (seen from the camera of the last frame)
+        float getScreenCoverage(Mesh *mesh, const glm::mat4 &localToWorld) const;
+        // Returns the level of detail at which the mesh renderer should be drawn (and remembers it in the component)
+        int selectLOD(MeshRendererComponent *meshRenderer, const glm::mat4 &localToWorld) const;
+        // Returns whether the mesh renderer should be drawn as the given impostor (-1 if it has none) and remembers it in the component
+        bool selectImpostor(MeshRendererComponent *meshRenderer, const glm::mat4 &localToWorld, int impostor) const;
+
+        // Fills the command & light lists of the packet from the entities of the world and returns the first camera found (or null)
+        CameraComponent *generateCommands(World *world, FramePacket &packet);
+
+        // Writes the camera & lights of the packet into the ring buffer and binds them as the frame block of the lit shaders
+        void writeFrameBlock(const FramePacket &packet);
+        // Draws a list of commands (this is shared by the opaque and the transparent passes)
+        void drawCommands(const std::vector<RenderCommand> &commands, const FramePacket &packet);
+        // Adds the passes of the given postprocess effect to the frame graph
+        void addPostprocessPasses(int effect, FrameGraph::Resource sceneColor, FrameGraph::Resource backbuffer);
+        // Reads a postprocess stage from the configuration (either a shader path or an object) and appends it to the chain
+        // A stage that lists fusable effects may need more than one pass, so it can append multiple stages
+        void appendPostprocessStages(PostprocessChain &chain, const nlohmann::json &config);
 
     public:
 
@@ -74,14 +211,48 @@ namespace our
         // Clean up the renderer
         void destroy();
 
-        // This function should be called every frame to draw the given world
+        // Renders the impostors of the opaque meshes of the world (those detailed enough to be worth it) into the impostor atlas.
+        // This should be called once the world is loaded. The meshes are lit by the lights of the world at the time of the call.
+        void bakeImpostors(World *world);
+
+        // Merges the meshes of the static entities of the world into batches. This should be called once the world is loaded.
+        // After this, the batched entities must not move nor be removed (see "StaticBatcher::isStatic").
+        void buildStaticBatches(World *world) { staticBatcher.build(world); }
+
+        // This function should be called every frame to draw the given world (it builds a packet then submits it)
         void render(World *world);
 
-        // This function sets the index of the current postprocessing shader
+        // Collects what is needed to draw the world into the packet. This doesn't call OpenGL, so it can run on any thread
+        // as long as nothing modifies the world or the renderer's settings at the same time.
+        void buildPacket(World *world, FramePacket &packet);
+        // Draws a packet. This must be called on the thread that owns the OpenGL context.
+        void submit(const FramePacket &packet);
+
+        // This function sets the index of the current postprocessing effect
         void setPostprocessingIndex(int index);
 
-        // This function returns the index of the current postprocessing shader
+        // This function returns the index of the current postprocessing effect
         int getPostprocessingIndex();
+
+        // This function should be called every frame (before "render") with the duration of the last frame in seconds
+        // If dynamic resolution is enabled, it adjusts the resolution at which the scene is rendered to stay within the frame time budget
+        void updateDynamicResolution(double frameTime) { dynamicResolution.update(frameTime); }
+        const DynamicResolution &getDynamicResolution() const { return dynamicResolution; }
+
+        // Returns the frame graph of the last rendered frame (for debugging and statistics)
+        const FrameGraph &getFrameGraph() const { return frameGraph; }
+        // Returns the pool that owns the render targets
+        const RenderTargetPool &getRenderTargets() const { return renderTargets; }
+        // The number of commands and lights of the last submitted packet
+        size_t getOpaqueCommandCount() const { return submittedOpaqueCommands; }
+        size_t getTransparentCommandCount() const { return submittedTransparentCommands; }
+        size_t getLightCount() const { return submittedLights; }
+        size_t getImpostorCount() const { return submittedImpostors; }
+        size_t getStaticBatchCount() const { return staticBatcher.getBatches().size(); }
+        // Returns the ring buffer used to stream the uniform blocks
+        const UniformRingBuffer &getUniformRing() const { return uniformRing; }
+        // Returns the GPU timer that holds the GPU time statistics of each pass (the results lag a few frames behind)
+        GPUTimer &getGPUTimer() { return gpuTimer; }
     };
 
 }
\ No newline at end of file
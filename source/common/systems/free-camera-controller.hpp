@@ -3,6 +3,7 @@
 #include "../ecs/world.hpp"
 #include "../components/camera.hpp"
 #include "../components/free-camera-controller.hpp"
+#include "../profiling/cpu-profiler.hpp"
 
 #include "../application.hpp"
 
@@ -34,6 +35,7 @@ namespace our
         // This should be called every frame to update all entities containing a FreeCameraControllerComponent
         void update(World *world, float deltaTime, ForwardRenderer *renderer)
         {
+            PROFILE_ZONE("FreeCameraControllerSystem::update");
             // First of all, we search for an entity containing both a CameraComponent and a FreeCameraControllerComponent
             // As soon as we find one, we break
             CameraComponent *camera = nullptr;
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace our
+{
+
+    // The 6 planes of the view volume of a camera, extracted from its view projection matrix (Gribb & Hartmann).
+    // Each plane is stored as (normal, distance) with the normal pointing inside the volume.
+    struct Frustum
+    {
+        std::array<glm::vec4, 6> planes;
+
+        explicit Frustum(const glm::mat4 &VP)
+        {
+            // The rows of the matrix (a point is inside if -w <= x, y, z <= w in clip space)
+            glm::mat4 rows = glm::transpose(VP);
+            planes = {rows[3] + rows[0], rows[3] - rows[0],
+                      rows[3] + rows[1], rows[3] - rows[1],
+                      rows[3] + rows[2], rows[3] - rows[2]};
+            for (auto &plane : planes)
+                plane /= glm::length(glm::vec3(plane));
+        }
+
+        // Returns false only if the sphere is completely outside the volume (it can return true for spheres near a corner that are outside)
+        bool intersects(const glm::vec3 &center, float radius) const
+        {
+            for (const auto &plane : planes)
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                    return false;
+            return true;
+        }
+    };
+
+}
@@ -0,0 +1,217 @@
+#include "impostor-atlas.hpp"
+#include "../gl/state-cache.hpp"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace our
+{
+
+    void ImpostorAtlas::deserialize(const nlohmann::json &config)
+    {
+        if (!config.is_object())
+            return;
+        settings.enabled = config.value("enabled", true);
+        settings.angles = glm::clamp(config.value("angles", settings.angles), 1, 32);
+        settings.cellSize = glm::clamp(config.value("cellSize", settings.cellSize), 16, 512);
+        settings.elevation = glm::radians(glm::clamp(config.value("elevation", glm::degrees(settings.elevation)), -89.0f, 89.0f));
+        settings.threshold = glm::max(config.value("threshold", settings.threshold), 0.0f);
+        settings.minTriangles = config.value("minTriangles", settings.minTriangles);
+    }
+
+    bool ImpostorAtlas::isCandidate(Mesh *mesh, Material *material) const
+    {
+        // Transparent materials need sorting and blending which a batch of alpha tested quads can't do
+        return mesh && material && !material->transparent && mesh->getLODs()[0].count / 3 >= settings.minTriangles;
+    }
+
+    bool ImpostorAtlas::bake(const std::vector<std::pair<Mesh *, Material *>> &pairs, const DrawFunction &draw)
+    {
+        release();
+        if (pairs.empty())
+            return true;
+
+        // Every row holds the views of a pair, so the atlas can't have more rows than fit in the largest texture
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        int cellSize = glm::min(settings.cellSize, (int)maxSize / settings.angles);
+        int rows = glm::min((int)pairs.size(), (int)maxSize / cellSize);
+        if (rows < (int)pairs.size())
+            std::cerr << "WARNING: Only " << rows << " of " << pairs.size() << " meshes fit in the impostor atlas" << std::endl;
+        glm::ivec2 size(settings.angles * cellSize, rows * cellSize);
+
+        // The mip chain stops at 4x4 pixels per view (smaller levels would mix the views together)
+        GLsizei levels = 1;
+        while ((cellSize >> levels) >= 4)
+            ++levels;
+        atlas = new Texture2D();
+        atlas->bind();
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, size.x, size.y);
+
+        // The depth buffer is only needed while baking
+        GLuint depthBuffer, framebuffer;
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+        glGenFramebuffers(1, &framebuffer);
+        GLStateCache &cache = GLStateCache::current();
+        cache.bindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas->getOpenGLName(), 0);
+        glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        bool complete = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (complete)
+        {
+            // The background is transparent black, so the mip levels of the atlas hold premultiplied colors
+            // (the shader divides by the alpha to get the color of the mesh back without dark fringes)
+            cache.setColorMask(glm::bvec4(true, true, true, true));
+            cache.setDepthMask(true);
+            cache.setClearColor(glm::vec4(0.0f));
+            cache.setClearDepth(1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            for (int row = 0; row < rows; ++row)
+            {
+                auto [mesh, material] = pairs[row];
+                glm::vec3 center = mesh->getBoundingCenter();
+                float radius = glm::max(mesh->getBoundingRadius(), 1e-4f);
+                float extent = radius * PADDING;
+                // The camera is outside the bounding sphere and the orthographic box covers it whatever the direction is
+                glm::mat4 projection = glm::ortho(-extent, extent, -extent, extent, radius, 4.0f * radius);
+                for (int column = 0; column < settings.angles; ++column)
+                {
+                    // The views are evenly spread around the up axis, the first one looks at the mesh from +Z
+                    float azimuth = glm::two_pi<float>() * column / settings.angles;
+                    glm::vec3 direction(glm::sin(azimuth) * glm::cos(settings.elevation), glm::sin(settings.elevation),
+                                        glm::cos(azimuth) * glm::cos(settings.elevation));
+                    glm::vec3 eye = center + direction * (2.0f * radius);
+                    glViewport(column * cellSize, row * cellSize, cellSize, cellSize);
+                    draw(mesh, material, projection * glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f)), eye);
+                }
+                lookup[{mesh, material}] = (int)entries.size();
+                entries.push_back({mesh, material});
+            }
+        }
+        else
+        {
+            std::cerr << "ERROR: The impostor atlas framebuffer is incomplete" << std::endl;
+        }
+        cache.bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        if (!complete)
+        {
+            release();
+            return false;
+        }
+        atlas->bind();
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        sampler = new Sampler();
+        sampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        sampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        sampler->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        sampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        shader = new ShaderProgram();
+        shader->attach("assets/shaders/impostor.vert", GL_VERTEX_SHADER);
+        shader->attach("assets/shaders/impostor.frag", GL_FRAGMENT_SHADER);
+        shader->link();
+
+        // The quads are opaque (the shader discards the transparent background), so they go through the depth test like any mesh
+        pipelineState.depthTesting.enabled = true;
+
+        // The corners of the quad are the only per-vertex data, the center and the cell come from the per-instance attributes
+        const glm::vec2 corners[] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {-1.0f, 1.0f}, {1.0f, 1.0f}};
+        glGenVertexArrays(1, &quadVertexArray);
+        cache.bindVertexArray(quadVertexArray);
+        glGenBuffers(1, &quadBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+        return true;
+    }
+
+    ImpostorInstance ImpostorAtlas::makeInstance(int impostor, const glm::mat4 &localToWorld, const glm::vec3 &cameraPosition) const
+    {
+        Mesh *mesh = entries[impostor].mesh;
+        glm::vec3 center = localToWorld * glm::vec4(mesh->getBoundingCenter(), 1.0f);
+        float scale = glm::max(glm::length(glm::vec3(localToWorld[0])), glm::max(glm::length(glm::vec3(localToWorld[1])), glm::length(glm::vec3(localToWorld[2]))));
+
+        // The view is picked from the direction of the camera in the local space of the mesh. The quad always stays upright,
+        // so only the rotation of the instance around the up axis is accounted for.
+        glm::vec3 local = glm::inverse(glm::mat3(localToWorld)) * (cameraPosition - center);
+        float azimuth = glm::atan(local.x, local.z);
+        int column = (int)glm::round(azimuth / glm::two_pi<float>() * settings.angles);
+        column = ((column % settings.angles) + settings.angles) % settings.angles;
+
+        float rows = (float)entries.size();
+        ImpostorInstance instance;
+        instance.centerSize = glm::vec4(center, mesh->getBoundingRadius() * scale * PADDING);
+        instance.cell = glm::vec4((float)column / settings.angles, impostor / rows, 1.0f / settings.angles, 1.0f / rows);
+        return instance;
+    }
+
+    void ImpostorAtlas::draw(const std::vector<ImpostorInstance> &instances, const glm::mat4 &VP, const glm::vec3 &cameraPosition, UniformRingBuffer &ring)
+    {
+        if (instances.empty() || !atlas)
+            return;
+        // The instances are written into the ring buffer which is then read as a vertex buffer.
+        // All of them are reserved in a single allocation before the vertex array is set up, and the attributes point at the
+        // buffer of that allocation (it may be an overflow buffer of the ring, see "UniformRingBuffer::allocate").
+        GLsizeiptr bytes = instances.size() * sizeof(ImpostorInstance);
+        UniformRingBuffer::Allocation allocation = ring.allocate(bytes);
+        std::memcpy(allocation.data, instances.data(), bytes);
+        ring.upload(allocation);
+
+        pipelineState.setup();
+        shader->use();
+        shader->set("VP", VP);
+        shader->set("camera_position", cameraPosition);
+        shader->set("atlas", 0);
+        atlas->bind(0);
+        sampler->bind(0);
+
+        GLStateCache &cache = GLStateCache::current();
+        cache.bindVertexArray(quadVertexArray);
+        // The ring buffer moves to another partition every frame, so the per-instance attributes are pointed at this frame's data
+        glBindBuffer(GL_ARRAY_BUFFER, allocation.buffer);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance), (void *)(allocation.offset + offsetof(ImpostorInstance, centerSize)));
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance), (void *)(allocation.offset + offsetof(ImpostorInstance, cell)));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instances.size());
+        cache.countDraw(2 * instances.size());
+    }
+
+    void ImpostorAtlas::release()
+    {
+        entries.clear();
+        lookup.clear();
+        delete atlas;
+        delete sampler;
+        delete shader;
+        atlas = nullptr;
+        sampler = nullptr;
+        shader = nullptr;
+        if (quadVertexArray)
+        {
+            GLStateCache::current().onVertexArrayDeleted(quadVertexArray);
+            glDeleteVertexArrays(1, &quadVertexArray);
+            glDeleteBuffers(1, &quadBuffer);
+            quadVertexArray = quadBuffer = 0;
+        }
+    }
+
+    void ImpostorAtlas::destroy()
+    {
+        release();
+    }
+
+}
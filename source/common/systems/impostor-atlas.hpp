@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../mesh/mesh.hpp"
+#include "../material/material.hpp"
+#include "../gl/uniform-ring-buffer.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace our
+{
+
+    // A far instance drawn as an impostor. The layout matches the per-instance attributes of the impostor shader.
+    struct ImpostorInstance
+    {
+        glm::vec4 centerSize; // xyz: the world position of the center of the quad, w: the half size of the quad
+        glm::vec4 cell;       // The rectangle of the baked view in the atlas (xy: min corner, zw: size) in texture coordinates
+    };
+
+    // An impostor replaces a far mesh by a camera-facing quad textured with a picture of the mesh.
+    // At load time, each (mesh, material) pair is rendered from "angles" directions around its up axis into a row of the atlas
+    // (one cell per direction). At runtime, each far instance picks the cell whose direction is the closest to the direction of the camera
+    // (in the local space of the instance) and all the instances are drawn as instanced quads in a single draw call.
+    // The lighting is baked with the lights at load time, so impostors should only be used where they cover a few pixels.
+    class ImpostorAtlas
+    {
+    public:
+        struct Settings
+        {
+            bool enabled = false;
+            // The number of views around the up axis and the size of each view in the atlas (in pixels)
+            int angles = 8;
+            int cellSize = 128;
+            // The angle (in radians) above the horizon from which the views are taken
+            float elevation = glm::radians(15.0f);
+            // An instance becomes an impostor once its bounding sphere covers less than this fraction of the screen height
+            float threshold = 0.03f;
+            // Meshes with fewer triangles are cheap enough to draw as is, so they don't get an impostor
+            GLsizei minTriangles = 128;
+        } settings;
+
+        // Draws the mesh with the material (with an identity model matrix) using the given view projection matrix and eye position.
+        // The framebuffer and the viewport of the cell are already set when it is called.
+        using DrawFunction = std::function<void(Mesh *, Material *, const glm::mat4 &VP, const glm::vec3 &eye)>;
+
+    private:
+        // The quad is slightly larger than the bounding sphere so that the views don't touch the edges of their cells
+        // (otherwise, the mip levels would blend neighbouring views together)
+        static constexpr float PADDING = 1.1f;
+
+        struct Entry
+        {
+            Mesh *mesh;
+            Material *material;
+        };
+        // The entry at index i is baked in the row i of the atlas
+        std::vector<Entry> entries;
+        std::map<std::pair<Mesh *, Material *>, int> lookup;
+
+        Texture2D *atlas = nullptr;
+        Sampler *sampler = nullptr;
+        ShaderProgram *shader = nullptr;
+        PipelineState pipelineState;
+        GLuint quadVertexArray = 0, quadBuffer = 0;
+
+        void release();
+
+    public:
+        // Reads the settings from the renderer configuration:
+        // "impostors": {"angles": 8, "cellSize": 128, "elevation": degrees, "threshold": 0.03, "minTriangles": 128}
+        void deserialize(const nlohmann::json &config);
+
+        // Returns whether the pair is worth an impostor (opaque and detailed enough)
+        bool isCandidate(Mesh *mesh, Material *material) const;
+
+        // Renders every pair into the atlas using the draw function. Returns false if the atlas couldn't be created.
+        bool bake(const std::vector<std::pair<Mesh *, Material *>> &pairs, const DrawFunction &draw);
+
+        // Returns the impostor of a pair or -1 if it doesn't have one. This only reads the baked data, so it can be called from any thread.
+        int find(Mesh *mesh, Material *material) const
+        {
+            auto it = lookup.find({mesh, material});
+            return it == lookup.end() ? -1 : it->second;
+        }
+
+        // Computes the instance that replaces the impostor's mesh at the given transform when seen from the given position
+        ImpostorInstance makeInstance(int impostor, const glm::mat4 &localToWorld, const glm::vec3 &cameraPosition) const;
+
+        // Draws all the instances in a single instanced draw call. The instances are streamed through the ring buffer.
+        void draw(const std::vector<ImpostorInstance> &instances, const glm::mat4 &VP, const glm::vec3 &cameraPosition, UniformRingBuffer &ring);
+
+        // Deletes the atlas and the objects used to draw it
+        void destroy();
+
+        size_t getImpostorCount() const { return entries.size(); }
+    };
+
+}
@@ -2,6 +2,7 @@
 
 #include "../ecs/world.hpp"
 #include "../components/movement.hpp"
+#include "../profiling/cpu-profiler.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
@@ -21,6 +22,7 @@ namespace our
         // This should be called every frame to update all entities containing a MovementComponent.
         void update(World *world, float deltaTime)
         {
+            PROFILE_ZONE("MovementSystem::update");
 
             // For each entity in the world
             for (auto entity : world->getEntities())
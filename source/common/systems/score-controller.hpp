@@ -2,6 +2,7 @@
 
 #include "../ecs/world.hpp"
 #include "../components/score.hpp"
+#include "../profiling/cpu-profiler.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
@@ -26,6 +27,7 @@ namespace our
 
         // This should be called every frame to update all entities containing a MovementComponent. 
         void update(World* world, float deltaTime) {
+            PROFILE_ZONE("ScoreControllerSystem::update");
 
             // For each entity in the world
             for(auto entity : world->getEntities()){
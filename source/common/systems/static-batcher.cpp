@@ -0,0 +1,133 @@
+#include "static-batcher.hpp"
+#include "../components/movement.hpp"
+#include "../components/collision.hpp"
+#include "../components/free-camera-controller.hpp"
+#include "../profiling/cpu-profiler.hpp"
+
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace our
+{
+
+    void StaticBatcher::deserialize(const nlohmann::json &config)
+    {
+        if (!config.is_object())
+            return;
+        enabled = config.value("enabled", true);
+        chunkSize = glm::max(config.value("chunkSize", chunkSize), 1.0f);
+        maxVertices = glm::max(config.value("maxVertices", maxVertices), (size_t)1024);
+    }
+
+    bool StaticBatcher::isStatic(MeshRendererComponent *meshRenderer)
+    {
+        if (meshRenderer->staticHint)
+            return *meshRenderer->staticHint;
+        // The transform of an entity depends on its ancestors, so the whole chain has to be static
+        for (Entity *entity = meshRenderer->getOwner(); entity; entity = entity->parent)
+        {
+            if (entity->getComponent<MovementComponent>() || entity->getComponent<FreeCameraControllerComponent>() ||
+                entity->getComponent<CollisionComponent>())
+                return false;
+        }
+        return true;
+    }
+
+    void StaticBatcher::build(World *world)
+    {
+        destroy();
+        if (!enabled)
+            return;
+        PROFILE_ZONE("StaticBatcher::build");
+
+        // Group the static mesh renderers by material and by chunk (the chunk of a mesh is the one that holds its center)
+        using GroupKey = std::tuple<Material *, int, int, int>;
+        std::map<GroupKey, std::vector<std::pair<MeshRendererComponent *, glm::mat4>>> groups;
+        for (Entity *entity : world->getEntities())
+        {
+            auto meshRenderer = entity->getComponent<MeshRendererComponent>();
+            if (!meshRenderer)
+                continue;
+            // The marks of a previous build are cleared since the batches are rebuilt from scratch
+            meshRenderer->batched = false;
+            if (!isStatic(meshRenderer))
+                continue;
+            glm::mat4 localToWorld = entity->getLocalToWorldMatrix();
+            glm::vec3 center = localToWorld * glm::vec4(meshRenderer->mesh->getBoundingCenter(), 1.0f);
+            glm::ivec3 cell = glm::floor(center / chunkSize);
+            groups[{meshRenderer->material, cell.x, cell.y, cell.z}].push_back({meshRenderer, localToWorld});
+        }
+
+        // The meshes don't keep their data on the RAM, so each source mesh is read back from the GPU once
+        std::unordered_map<Mesh *, std::pair<std::vector<Vertex>, std::vector<unsigned int>>> sources;
+        size_t merged = 0;
+        for (auto &[key, members] : groups)
+        {
+            Material *material = std::get<0>(key);
+            std::vector<Vertex> vertices;
+            std::vector<unsigned int> elements;
+            std::vector<MeshRendererComponent *> batched;
+            auto flush = [&]()
+            {
+                // Merging a single mesh saves nothing and would lose its levels of detail & impostor, so it is left as is
+                if (batched.size() >= 2)
+                {
+                    batches.push_back({new Mesh(vertices, elements), material, batched.size()});
+                    for (auto meshRenderer : batched)
+                        meshRenderer->batched = true;
+                    merged += batched.size();
+                }
+                vertices.clear();
+                elements.clear();
+                batched.clear();
+            };
+
+            for (auto &[meshRenderer, localToWorld] : members)
+            {
+                auto source = sources.find(meshRenderer->mesh);
+                if (source == sources.end())
+                {
+                    source = sources.emplace(meshRenderer->mesh, std::pair<std::vector<Vertex>, std::vector<unsigned int>>()).first;
+                    meshRenderer->mesh->readBack(source->second.first, source->second.second);
+                }
+                const auto &[sourceVertices, sourceElements] = source->second;
+                if (!vertices.empty() && vertices.size() + sourceVertices.size() > maxVertices)
+                    flush();
+
+                // The normals are transformed by the inverse transpose (like in the lit shaders) so that non-uniform scales keep them perpendicular
+                glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(localToWorld)));
+                unsigned int base = (unsigned int)vertices.size();
+                for (Vertex vertex : sourceVertices)
+                {
+                    vertex.position = localToWorld * glm::vec4(vertex.position, 1.0f);
+                    glm::vec3 normal = normalMatrix * vertex.normal;
+                    float length = glm::length(normal);
+                    vertex.normal = length > 0.0f ? normal / length : normal;
+                    vertices.push_back(vertex);
+                }
+                // A mirroring transform flips the winding of the triangles, so we flip it back to keep the same front faces
+                bool mirrored = glm::determinant(glm::mat3(localToWorld)) < 0.0f;
+                for (size_t index = 0; index + 2 < sourceElements.size(); index += 3)
+                {
+                    elements.push_back(base + sourceElements[index]);
+                    elements.push_back(base + sourceElements[index + (mirrored ? 2 : 1)]);
+                    elements.push_back(base + sourceElements[index + (mirrored ? 1 : 2)]);
+                }
+                batched.push_back(meshRenderer);
+            }
+            flush();
+        }
+        if (!batches.empty())
+            std::cout << "Merged " << merged << " static meshes into " << batches.size() << " batches" << std::endl;
+    }
+
+    void StaticBatcher::destroy()
+    {
+        for (auto &batch : batches)
+            delete batch.mesh;
+        batches.clear();
+    }
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../ecs/world.hpp"
+#include "../components/mesh-renderer.hpp"
+
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+
+#include <vector>
+
+namespace our
+{
+
+    // Most of the scenery never moves, but drawing each piece by itself costs a draw call (and a matrix upload) per entity.
+    // The static batcher merges the meshes of the static entities at load time: the vertices are transformed to world space once
+    // and the meshes that share a material are concatenated into a single mesh. To keep the batches cullable, the world is split into
+    // a grid of chunks and each batch only holds the meshes whose center lies in one chunk.
+    class StaticBatcher
+    {
+    public:
+        // A merged mesh (in world space) and the material it is drawn with
+        struct Batch
+        {
+            Mesh *mesh;
+            Material *material;
+            // How many mesh renderers were merged into this batch
+            size_t sourceCount;
+        };
+
+        bool enabled = false;
+        // The size of a chunk of the grid in world units
+        float chunkSize = 50.0f;
+        // A batch is split once it reaches this many vertices so that a single batch doesn't get too large to cull
+        size_t maxVertices = 1 << 16;
+
+    private:
+        std::vector<Batch> batches;
+
+    public:
+        // Reads the settings from the renderer configuration: "staticBatching": {"chunkSize": 50, "maxVertices": 65536}
+        void deserialize(const nlohmann::json &config);
+
+        // Returns whether the mesh renderer can be merged into a static batch. If the component doesn't say it explicitly, it is static
+        // unless its entity (or one of its ancestors) moves (movement, camera controller) or collides (collisions may remove entities).
+        static bool isStatic(MeshRendererComponent *meshRenderer);
+
+        // Merges the static mesh renderers of the world into batches (replacing the previous batches) and marks them as batched
+        void build(World *world);
+
+        // Deletes the batches (the world may already be cleared at this point, so the mesh renderers are left as they are)
+        void destroy();
+
+        const std::vector<Batch> &getBatches() const { return batches; }
+    };
+
+}
@@ -0,0 +1,296 @@
+#include "frame-recorder.hpp"
+#include "../gl/state-cache.hpp"
+#include "../profiling/cpu-profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace our {
+
+    void FrameRecorder::deserialize(const nlohmann::json& config){
+        if(!config.is_object()) return;
+        settings.output = config.value("output", settings.output);
+        settings.every = std::max(config.value("every", settings.every), 1);
+        settings.timeStep = std::max(config.value("timeStep", settings.timeStep), 0.0);
+        settings.frameRate = std::max(config.value("frameRate", settings.frameRate), 1);
+        settings.buffers = std::max(config.value("buffers", settings.buffers), 1);
+        settings.encoders = std::max(config.value("encoders", settings.encoders), 1);
+        settings.maxQueuedFrames = std::max(config.value("maxQueuedFrames", settings.maxQueuedFrames), 1);
+    }
+
+    bool FrameRecorder::start(glm::ivec2 size){
+        if(recording) return true;
+        this->size = size;
+        std::filesystem::path output(settings.output);
+        y4m = output.extension() == ".y4m";
+
+        std::error_code ec;
+        std::filesystem::create_directories(y4m ? output.parent_path() : output, ec);
+        if(ec){
+            std::cerr << "Failed to create the directory of the recording: " << settings.output << std::endl;
+            return false;
+        }
+        if(y4m){
+            stream = std::fopen(settings.output.c_str(), "wb");
+            if(!stream){
+                std::cerr << "Couldn't open file: " << settings.output << std::endl;
+                return false;
+            }
+            // With a fixed time step, a recorded frame lasts "every" time steps of the game (in microseconds to keep it an integer ratio)
+            int numerator = settings.frameRate, denominator = 1;
+            if(settings.timeStep > 0){
+                numerator = 1000000;
+                denominator = std::max((int)std::lround(settings.timeStep * settings.every * 1000000.0), 1);
+            }
+            // C420jpeg is full range YCbCr (like JPEG) with the chroma at the center of each 2x2 block of pixels
+            std::fprintf(stream, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420jpeg\n", size.x, size.y, numerator, denominator);
+        }
+
+        ring.resize(settings.buffers);
+        for(auto& slot : ring){
+            glGenBuffers(1, &slot.buffer);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size.x * size.y * 3, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        oldest = inFlight = 0;
+
+        recording = true;
+        for(int index = 0; index < settings.encoders; ++index)
+            encoders.emplace_back(&FrameRecorder::encoderLoop, this, (unsigned)index);
+        std::cout << "Recording to: " << settings.output << std::endl;
+        return true;
+    }
+
+    void FrameRecorder::captureFrame(int frame){
+        if(!recording || frame % settings.every != 0) return;
+        PROFILE_ZONE("FrameRecorder::captureFrame");
+
+        bool encoderFailed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            encoderFailed = failed;
+        }
+        struct {
+            int x = 0, y = 0, w = 0, h = 0;
+        } viewport;
+        glGetIntegerv(GL_VIEWPORT, (GLint*)&viewport);
+        if(encoderFailed || viewport.w != size.x || viewport.h != size.y){
+            std::cerr << "ERROR: The recording stopped since " << (encoderFailed ? "a frame couldn't be written" : "the size of the frames changed") << std::endl;
+            stop();
+            return;
+        }
+
+        // If every buffer of the ring is in flight, we have to wait for the oldest one (this is the back-pressure)
+        if(inFlight == ring.size()) finishOldest(true);
+
+        Slot& slot = ring[(oldest + inFlight) % ring.size()];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        // With a pixel pack buffer bound, the last parameter is an offset in the buffer and the copy is done by the GPU
+        glReadPixels(viewport.x, viewport.y, viewport.w, viewport.h, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.index = recordedFrames++;
+        ++inFlight;
+    }
+
+    void FrameRecorder::update(){
+        if(!recording) return;
+        while(inFlight > 0 && hasFreeImage() && finishOldest(false));
+    }
+
+    bool FrameRecorder::hasFreeImage(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return !freeImages.empty() || createdImages < settings.maxQueuedFrames;
+    }
+
+    bool FrameRecorder::finishOldest(bool wait){
+        using clock = std::chrono::steady_clock;
+        Slot& slot = ring[oldest];
+
+        // A timeout of 0 only checks the fence. The flush makes sure the fence is sent to the GPU (so it is signaled eventually).
+        GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if(result == GL_TIMEOUT_EXPIRED){
+            if(!wait) return false;
+            auto start = clock::now();
+            do {
+                result = glClientWaitSync(slot.fence, 0, 1000000); // 1 ms
+            } while(result == GL_TIMEOUT_EXPIRED);
+            ++gpuStalls;
+            stallTime += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        }
+
+        // Then we need a frame buffer to copy the pixels into. If all of them wait for the encoders, we wait too.
+        Image image;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if(freeImages.empty() && createdImages >= settings.maxQueuedFrames){
+                if(!wait) return false;
+                auto start = clock::now();
+                space.wait(lock, [this]{ return !freeImages.empty(); });
+                ++encoderStalls;
+                stallTime += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            }
+            if(!freeImages.empty()){
+                image = std::move(freeImages.back());
+                freeImages.pop_back();
+            } else {
+                ++createdImages;
+            }
+        }
+
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        image.size = size;
+        image.components = 3;
+        image.pixels.resize((size_t)size.x * size.y * 3);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        if(void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)image.pixels.size(), GL_MAP_READ_BIT)){
+            std::memcpy(image.pixels.data(), data, image.pixels.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            // The frame is still written (black) so that the sequence has no holes, but the failure is reported
+            std::cerr << "ERROR: Failed to map the pixels of the recorded frame " << slot.index << std::endl;
+            std::fill(image.pixels.begin(), image.pixels.end(), 0);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back({slot.index, std::move(image)});
+        }
+        wake.notify_one();
+        oldest = (oldest + 1) % ring.size();
+        --inFlight;
+        return true;
+    }
+
+    void FrameRecorder::encoderLoop(unsigned index){
+        profiler::setThreadName("recorder-encoder-" + std::to_string(index));
+        // The YCbCr planes of a Y4M frame (kept between frames to avoid reallocating them)
+        std::vector<std::uint8_t> planes;
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true){
+            wake.wait(lock, [this]{ return stopping || !queue.empty(); });
+            if(queue.empty()) return; // Stopping (the queue is always drained first)
+            Frame frame = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            encode(frame, planes);
+            lock.lock();
+            freeImages.push_back(std::move(frame.image));
+            space.notify_one();
+        }
+    }
+
+    void FrameRecorder::encode(Frame& frame, std::vector<std::uint8_t>& planes){
+        PROFILE_ZONE("FrameRecorder::encode");
+        if(!y4m){
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame-%06d.png", frame.index);
+            auto path = (std::filesystem::path(settings.output) / name).string();
+            if(!write_png(path, frame.image)){
+                std::cerr << "Failed to save a recorded frame to: " << path << std::endl;
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+            }
+            return;
+        }
+
+        // Convert to full range YCbCr (BT.601 coefficients in 8-bit fixed point) with the rows from the top to the bottom.
+        // The chroma is the conversion of the average color of each 2x2 block.
+        const int width = size.x, height = size.y;
+        const int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+        planes.resize((size_t)width * height + 2 * (size_t)chromaWidth * chromaHeight);
+        std::uint8_t* luma = planes.data();
+        std::uint8_t* blue = luma + (size_t)width * height;
+        std::uint8_t* red = blue + (size_t)chromaWidth * chromaHeight;
+        const std::uint8_t* pixels = frame.image.pixels.data();
+        auto row = [&](int y){ return pixels + (size_t)(height - 1 - y) * width * 3; };
+        for(int y = 0; y < height; ++y){
+            const std::uint8_t* source = row(y);
+            std::uint8_t* destination = luma + (size_t)y * width;
+            for(int x = 0; x < width; ++x, source += 3)
+                destination[x] = (std::uint8_t)((77 * source[0] + 150 * source[1] + 29 * source[2] + 128) >> 8);
+        }
+        for(int y = 0; y < chromaHeight; ++y){
+            const std::uint8_t* top = row(2 * y);
+            const std::uint8_t* bottom = row(std::min(2 * y + 1, height - 1));
+            for(int x = 0; x < chromaWidth; ++x){
+                int left = 2 * x * 3, right = std::min(2 * x + 1, width - 1) * 3;
+                int r = (top[left] + top[right] + bottom[left] + bottom[right] + 2) / 4;
+                int g = (top[left + 1] + top[right + 1] + bottom[left + 1] + bottom[right + 1] + 2) / 4;
+                int b = (top[left + 2] + top[right + 2] + bottom[left + 2] + bottom[right + 2] + 2) / 4;
+                blue[(size_t)y * chromaWidth + x] = (std::uint8_t)std::clamp(128 + ((-43 * r - 85 * g + 128 * b + 128) >> 8), 0, 255);
+                red[(size_t)y * chromaWidth + x] = (std::uint8_t)std::clamp(128 + ((128 * r - 107 * g - 21 * b + 128) >> 8), 0, 255);
+            }
+        }
+
+        // The encoders may finish out of order, so each one waits for its turn to write
+        std::unique_lock<std::mutex> lock(streamMutex);
+        written.wait(lock, [&]{ return nextToWrite == frame.index; });
+        bool success = std::fwrite("FRAME\n", 1, 6, stream) == 6 && std::fwrite(planes.data(), 1, planes.size(), stream) == planes.size();
+        ++nextToWrite;
+        lock.unlock();
+        written.notify_all();
+        if(!success){
+            std::cerr << "Failed to write the recorded frame " << frame.index << " to: " << settings.output << std::endl;
+            std::lock_guard<std::mutex> failureLock(mutex);
+            failed = true;
+        }
+    }
+
+    void FrameRecorder::stop(){
+        if(!recording) return;
+        PROFILE_ZONE("FrameRecorder::stop");
+        // The frames still in flight are read back too. The waits are not counted as stalls since the recording is over.
+        int savedGPUStalls = gpuStalls, savedEncoderStalls = encoderStalls;
+        double savedStallTime = stallTime;
+        while(inFlight > 0) finishOldest(true);
+        gpuStalls = savedGPUStalls;
+        encoderStalls = savedEncoderStalls;
+        stallTime = savedStallTime;
+
+        // The encoders drain the queue before they stop
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(auto& encoder : encoders) encoder.join();
+        encoders.clear();
+
+        for(auto& slot : ring){
+            GLStateCache::current().onBufferDeleted(slot.buffer);
+            glDeleteBuffers(1, &slot.buffer);
+        }
+        ring.clear();
+        if(stream){
+            std::fclose(stream);
+            stream = nullptr;
+        }
+
+        std::cout << "Recorded " << recordedFrames << " frames to: " << settings.output << std::endl;
+        if(gpuStalls + encoderStalls > 0){
+            std::cout << "WARNING: The recording slowed the application down: it waited " << gpuStalls << " times for the GPU and "
+                      << encoderStalls << " times for the encoders (" << stallTime << " ms in total)."
+                      << " More buffers, queued frames or encoders may help." << std::endl;
+        }
+
+        // Ready for another recording
+        recording = false;
+        queue.clear();
+        freeImages.clear();
+        createdImages = 0;
+        stopping = failed = false;
+        nextToWrite = recordedFrames = 0;
+        gpuStalls = encoderStalls = 0;
+        stallTime = 0;
+    }
+
+}
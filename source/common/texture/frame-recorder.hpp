@@ -0,0 +1,108 @@
+#pragma once
+
+#include "screenshot.hpp"
+
+#include <glad/gl.h>
+#include <json/json.hpp>
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace our {
+
+    // Records the frames of the application as a PNG sequence (a directory of "frame-000000.png", ...) or as a raw Y4M video
+    // (if the output ends with ".y4m"), so gameplay can be recorded without an external screen recorder distorting the performance.
+    // It works like "ScreenshotCapture" on a bigger scale: every recorded frame is read into one of a ring of pixel pack buffers
+    // (the copy happens on the GPU) and a few frames later, once its fence is signaled, the pixels are copied into one of a
+    // bounded set of frame buffers and handed to a pool of encoder threads. The memory is bounded: when all the pixel pack
+    // buffers are in flight or all the frame buffers wait for an encoder, the main thread waits (back-pressure) instead of
+    // dropping frames, and these waits are counted & reported so a recording that slowed the game down is never silent.
+    // The Y4M frames are converted to YCbCr 4:2:0 in parallel, then written in order by whichever encoder converted them.
+    class FrameRecorder {
+    public:
+        struct Settings {
+            std::string output = "recordings/recording";
+            int every = 1;              // Only every Nth frame is recorded
+            // The delta time (in seconds) given to the states while recording. If it is 0, the real frame time is used.
+            // With a fixed time step, the recording plays at the speed of the game whatever the speed of the recording.
+            double timeStep = 0.0;
+            // The frame rate written in the Y4M header when there is no fixed time step
+            int frameRate = 60;
+            int buffers = 3;            // The pixel pack buffers in the ring (how many frames the GPU may be ahead of the encoders)
+            int encoders = 2;           // The encoder threads
+            int maxQueuedFrames = 8;    // The frame buffers in memory (read back but not encoded yet)
+        } settings;
+
+        // Reads the settings: {"output", "every", "timeStep", "frameRate", "buffers", "encoders", "maxQueuedFrames"}
+        void deserialize(const nlohmann::json& config);
+
+    private:
+        // A pixel pack buffer of the ring and the frame it holds (if any)
+        struct Slot {
+            GLuint buffer = 0;
+            GLsync fence = nullptr;
+            int index = -1;     // The index of the frame in the recording
+        };
+        std::vector<Slot> ring;
+        size_t oldest = 0, inFlight = 0;
+
+        // A frame that was read back and waits for (or is in) an encoder
+        struct Frame {
+            int index = 0;
+            Image image;
+        };
+
+        bool recording = false, y4m = false;
+        glm::ivec2 size = {0, 0};
+        int recordedFrames = 0;
+
+        std::vector<std::thread> encoders;
+        std::mutex mutex;
+        std::condition_variable wake, space;
+        std::deque<Frame> queue;
+        // The frame buffers that are free to receive pixels. They are created as needed, up to "maxQueuedFrames".
+        std::vector<Image> freeImages;
+        int createdImages = 0;
+        bool stopping = false, failed = false;
+        // The Y4M stream and the index of the next frame to write into it (the encoders may finish out of order)
+        std::FILE* stream = nullptr;
+        std::mutex streamMutex;
+        std::condition_variable written;
+        int nextToWrite = 0;
+
+        // How often and how long the main thread waited for the GPU or the encoders
+        int gpuStalls = 0, encoderStalls = 0;
+        double stallTime = 0; // in milliseconds
+
+        void encoderLoop(unsigned index);
+        void encode(Frame& frame, std::vector<std::uint8_t>& planes);
+        // Returns true if a frame buffer is free (or can be created) so the oldest slot can be read back without waiting
+        bool hasFreeImage();
+        // Reads back the oldest slot. If "wait" is false, this does nothing and returns false when the slot isn't ready.
+        bool finishOldest(bool wait);
+
+    public:
+        FrameRecorder() = default;
+
+        // Opens the output and creates the buffers & the encoders for frames of the given size. Returns false if it failed.
+        bool start(glm::ivec2 size);
+        // Records the current frame (of the bound read framebuffer) if it is one of the recorded frames (see "every")
+        void captureFrame(int frame);
+        // Hands the frames the GPU finished reading over to the encoders. This never waits.
+        void update();
+        // Waits for every frame to be written, then deletes the buffers (the OpenGL context must still exist), closes the
+        // output and prints a report of the recording.
+        void stop();
+
+        bool isRecording() const { return recording; }
+
+        FrameRecorder(const FrameRecorder&) = delete;
+        FrameRecorder& operator=(const FrameRecorder&) = delete;
+    };
+
+}
@@ -0,0 +1,53 @@
+#include "image-compare.hpp"
+
+#include <stb/stb_image.h>
+
+#include <cstdlib>
+#include <iostream>
+
+bool our::load_image(const std::string& filename, Image& image) {
+    // The screenshots are stored from the bottom to the top, so the file is flipped while loading
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, channels;
+    // The alpha is dropped (if any) since the screenshots of the tests are RGB
+    unsigned char* pixels = stbi_load(filename.c_str(), &width, &height, &channels, 3);
+    if(pixels == nullptr){
+        std::cerr << "Failed to load image: " << filename << std::endl;
+        return false;
+    }
+    image.size = {width, height};
+    image.components = 3;
+    image.pixels.assign(pixels, pixels + (size_t)width * height * 3);
+    stbi_image_free(pixels);
+    return true;
+}
+
+our::ImageComparison our::compare_images(const Image& expected, const Image& actual, float tolerance) {
+    ImageComparison comparison;
+    comparison.sizeMatches = expected.size == actual.size;
+    if(!comparison.sizeMatches) return comparison;
+
+    comparison.errors.size = expected.size;
+    comparison.errors.components = 3;
+    comparison.errors.pixels.assign((size_t)expected.size.x * expected.size.y * 3, 0);
+    // The tolerance is compared to the error in [0, 255], so it is scaled once here instead of once per channel
+    float scaled_tolerance = tolerance * 255.0f;
+    const std::uint8_t* expected_pixel = expected.pixels.data();
+    const std::uint8_t* actual_pixel = actual.pixels.data();
+    std::uint8_t* error_pixel = comparison.errors.pixels.data();
+    for(int index = 0; index < expected.size.x * expected.size.y; ++index){
+        bool different = false;
+        for(int channel = 0; channel < 3; ++channel){
+            int error = std::abs((int)expected_pixel[channel] - (int)actual_pixel[channel]);
+            if((float)error > scaled_tolerance){
+                different = true;
+                error_pixel[channel] = (std::uint8_t)(128 + error / 2);
+            }
+        }
+        if(different) ++comparison.differentPixels;
+        expected_pixel += expected.components;
+        actual_pixel += actual.components;
+        error_pixel += 3;
+    }
+    return comparison;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "screenshot.hpp"
+
+#include <string>
+
+namespace our {
+
+    // The result of comparing an image to the expected one
+    struct ImageComparison {
+        bool sizeMatches = false;
+        int differentPixels = 0;    // The pixels where the error of at least one channel is above the tolerance
+        Image errors;               // The error of each channel (see "compare_images")
+    };
+
+    // Reads an image file (e.g. an expected screenshot) as RGB with the rows from the bottom to the top (like "read_pixels")
+    // Returns false (after printing the reason) if the file couldn't be read.
+    bool load_image(const std::string& filename, Image& image);
+
+    // Compares the RGB channels of two images pixel by pixel, the same way the "imgcmp" tool used by the test scripts does:
+    // if the error of any channel of a pixel is above the tolerance (in [0, 1]), the pixel is different.
+    // The images match if the count of different pixels is at most the threshold.
+    // In the error image, the channels within the tolerance are 0 and the others are 128 plus half their error.
+    ImageComparison compare_images(const Image& expected, const Image& actual, float tolerance);
+
+    inline bool images_match(const ImageComparison& comparison, int threshold){
+        return comparison.sizeMatches && comparison.differentPixels <= threshold;
+    }
+
+}
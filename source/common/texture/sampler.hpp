@@ -4,6 +4,8 @@
 #include <json/json.hpp>
 #include <glm/vec4.hpp>
 
+#include "../gl/state-cache.hpp"
+
 namespace our
 {
 
@@ -27,6 +29,7 @@ namespace our
         {
             // TODO: (Req 6) Complete this function
             // delete the created sampler after we're done
+            GLStateCache::current().onSamplerDeleted(name);
             glDeleteSamplers(1, &name);
         }
 
@@ -36,7 +39,7 @@ namespace our
             // TODO: (Req 6) Complete this function
             // bind the sampler to the given texture unit
             // this is done to sample the texture at different coordiantes 
-            glBindSampler(textureUnit, name);
+            GLStateCache::current().bindSampler(textureUnit, name);
         }
 
         // This static method ensures that no sampler is bound to the given texture unit
@@ -44,7 +47,7 @@ namespace our
         {
             // TODO: (Req 6) Complete this function
             // unbind the sampler from the texture unit when done 
-            glBindSampler(textureUnit, 0);
+            GLStateCache::current().bindSampler(textureUnit, 0);
         }
 
         // This function sets a sampler parameter where the value is of type "GLint"
@@ -0,0 +1,156 @@
+#include "screenshot-capture.hpp"
+#include "../gl/state-cache.hpp"
+#include "../profiling/cpu-profiler.hpp"
+
+#include <cstring>
+#include <iostream>
+
+namespace our {
+
+    ScreenshotCapture::~ScreenshotCapture(){
+        if(!encoder.joinable()) return;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [this]{ return queue.empty() && !encoding; });
+            stopping = true;
+        }
+        wake.notify_one();
+        encoder.join();
+    }
+
+    void ScreenshotCapture::encoderLoop(){
+        profiler::setThreadName("screenshot-encoder");
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true){
+            wake.wait(lock, [this]{ return stopping || !queue.empty(); });
+            if(queue.empty()) return; // Stopping (the destructor waits for the queue to be empty first)
+            auto [path, image] = std::move(queue.front());
+            queue.pop_front();
+            encoding = true;
+            // The image is written without the lock so the main thread can keep queuing captures meanwhile
+            lock.unlock();
+            {
+                PROFILE_ZONE("Screenshot::encode");
+                if(write_png(path, image))
+                    std::cout << "Screenshot saved to: " << path << std::endl;
+                else
+                    std::cerr << "Failed to save a screenshot to: " << path << std::endl;
+            }
+            lock.lock();
+            encoding = false;
+            idle.notify_all();
+        }
+    }
+
+    void ScreenshotCapture::capture(const std::string& path, bool include_alpha){
+        PROFILE_ZONE("Screenshot::capture");
+        if(!encoder.joinable()) encoder = std::thread(&ScreenshotCapture::encoderLoop, this);
+
+        // Read the current viewport parameters
+        struct {
+            int x = 0, y = 0, w = 0, h = 0;
+        } viewport;
+        glGetIntegerv(GL_VIEWPORT, (GLint*)&viewport);
+
+        Readback readback;
+        readback.path = path;
+        readback.size = {viewport.w, viewport.h};
+        readback.components = include_alpha ? 4 : 3;
+        if(freeBuffers.empty()){
+            glGenBuffers(1, &readback.buffer);
+        } else {
+            readback.buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+        }
+        // The pixel pack buffer isn't shadowed by the state cache, so it is bound directly and unbound right after
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        // The storage is reallocated every time since the captures may have different sizes (this also orphans the old content)
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)readback.components * viewport.w * viewport.h, nullptr, GL_STREAM_READ);
+        // The same packing as "read_pixels", so the rows are tightly packed
+        glPixelStorei(GL_PACK_ALIGNMENT, include_alpha ? 4 : 1);
+        // With a pixel pack buffer bound, the last parameter is an offset in the buffer and the copy is done by the GPU
+        glReadPixels(viewport.x, viewport.y, viewport.w, viewport.h, include_alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readbacks.push_back(std::move(readback));
+    }
+
+    void ScreenshotCapture::finish(Readback& readback){
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+
+        Image image;
+        image.size = readback.size;
+        image.components = readback.components;
+        image.pixels.resize((size_t)readback.components * readback.size.x * readback.size.y);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        if(void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)image.pixels.size(), GL_MAP_READ_BIT)){
+            std::memcpy(image.pixels.data(), data, image.pixels.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            std::cerr << "Failed to map the pixels of the screenshot: " << readback.path << std::endl;
+            image.pixels.clear();
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        freeBuffers.push_back(readback.buffer);
+        readback.buffer = 0;
+        if(image.pixels.empty()) return;
+
+        if(onRead) onRead(readback.path, image);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.emplace_back(std::move(readback.path), std::move(image));
+        }
+        wake.notify_one();
+    }
+
+    void ScreenshotCapture::update(){
+        if(readbacks.empty()) return;
+        PROFILE_ZONE("Screenshot::update");
+        // The readbacks finish in order, so we stop at the first one that isn't done
+        size_t finished = 0;
+        for(auto& readback : readbacks){
+            // A timeout of 0 only checks the fence. The flush makes sure the fence is sent to the GPU (so it is signaled eventually).
+            GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) break;
+            finish(readback);
+            ++finished;
+        }
+        readbacks.erase(readbacks.begin(), readbacks.begin() + finished);
+    }
+
+    void ScreenshotCapture::flush(){
+        for(auto& readback : readbacks){
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            GLenum result;
+            do {
+                result = glClientWaitSync(readback.fence, flags, 1000000); // 1 ms
+                flags = 0;
+            } while(result == GL_TIMEOUT_EXPIRED);
+            finish(readback);
+        }
+        readbacks.clear();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]{ return queue.empty() && !encoding; });
+    }
+
+    void ScreenshotCapture::destroy(){
+        for(auto& readback : readbacks){
+            glDeleteSync(readback.fence);
+            freeBuffers.push_back(readback.buffer);
+        }
+        readbacks.clear();
+        for(GLuint buffer : freeBuffers){
+            GLStateCache::current().onBufferDeleted(buffer);
+        }
+        if(!freeBuffers.empty()) glDeleteBuffers((GLsizei)freeBuffers.size(), freeBuffers.data());
+        freeBuffers.clear();
+    }
+
+    size_t ScreenshotCapture::getPendingCount(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return readbacks.size() + queue.size() + (encoding ? 1 : 0);
+    }
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "screenshot.hpp"
+
+#include <glad/gl.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace our {
+
+    // Takes screenshots without stalling the frame. Reading the framebuffer into memory with glReadPixels waits for the GPU to
+    // finish the frame, then encoding the PNG (zlib compression) takes longer than a frame, so "screenshot_png" causes a hitch.
+    // Instead, "capture" reads the pixels into a pixel pack buffer (the copy happens on the GPU, glReadPixels returns immediately)
+    // and places a fence after it. "update" (called once per frame) checks the fences without waiting: once the GPU is done
+    // (usually a frame or two later), the buffer is mapped, its pixels are copied out and handed to a worker thread that
+    // writes the PNG (flipping the rows on the way). The render loop never blocks on a capture.
+    class ScreenshotCapture {
+    public:
+        // Called on the main thread with the pixels of a capture once they are read back (before the file is written)
+        using ReadCallback = std::function<void(const std::string& path, const Image& image)>;
+
+    private:
+        // A capture whose pixels are still being copied by the GPU
+        struct Readback {
+            std::string path;
+            GLuint buffer = 0;
+            GLsync fence = nullptr;
+            glm::ivec2 size = {0, 0};
+            int components = 0;
+        };
+        std::vector<Readback> readbacks;
+        // The buffers of the finished readbacks, kept to be reused by the next captures
+        std::vector<GLuint> freeBuffers;
+        ReadCallback onRead;
+
+        // The PNG encoder thread and its queue of images to write (started by the first capture)
+        std::thread encoder;
+        std::mutex mutex;
+        std::condition_variable wake, idle;
+        std::deque<std::pair<std::string, Image>> queue;
+        bool encoding = false, stopping = false;
+
+        void encoderLoop();
+        // Maps the buffer of a finished readback, copies its pixels out and queues them for encoding
+        void finish(Readback& readback);
+
+    public:
+        ScreenshotCapture() = default;
+        // Waits for the queued images to be written then stops the encoder
+        ~ScreenshotCapture();
+
+        // Starts reading the current viewport of the bound read framebuffer. The file is written a few frames later.
+        void capture(const std::string& path, bool include_alpha = false);
+        // Hands the finished readbacks over to the encoder. This never waits for the GPU.
+        void update();
+        // Waits until every capture is read back and written (e.g. before exiting or when the files are needed right away)
+        void flush();
+        // Deletes the buffers (this must be called while the OpenGL context still exists, after "flush")
+        void destroy();
+
+        void setReadCallback(ReadCallback callback){ onRead = std::move(callback); }
+        // The captures that were requested but not written yet
+        size_t getPendingCount();
+
+        ScreenshotCapture(const ScreenshotCapture&) = delete;
+        ScreenshotCapture& operator=(const ScreenshotCapture&) = delete;
+    };
+
+}
@@ -5,10 +5,9 @@
 
 #include <glad/gl.h>
 
-#include <vector>
 #include <filesystem>
 
-bool our::screenshot_png(const std::string& filename, bool include_alpha) {
+void our::read_pixels(Image& image, bool include_alpha) {
 
     // Read the current viewport parameters
     struct {
@@ -17,10 +16,11 @@ bool our::screenshot_png(const std::string& filename, bool include_alpha) {
     glGetIntegerv(GL_VIEWPORT, (GLint*)&viewport);
 
     // If alpha is included, we have 4 components (RGBA). Otherwise, we only have 3 (RGB).
-    uint8_t components = include_alpha ? 4 : 3;
+    image.size = {viewport.w, viewport.h};
+    image.components = include_alpha ? 4 : 3;
 
     // Allocate memory to store image
-    std::vector<uint8_t> data(components * viewport.w * viewport.h);
+    image.pixels.resize(image.components * viewport.w * viewport.h);
 
     // If alpha is included, each pixel will use 4 bytes so the row would always be divisible by 4.
     // Otherwise, we can only be sure it is divisible by 1 (because everything is divisible by 1).
@@ -28,16 +28,27 @@ bool our::screenshot_png(const std::string& filename, bool include_alpha) {
     // Pick a format for reading pixels from framebuffer
     GLenum format = include_alpha ? GL_RGBA : GL_RGB;
     // Read Pixels from framebuffer
-    glReadPixels(viewport.x, viewport.y, viewport.w, viewport.h, format, GL_UNSIGNED_BYTE, data.data());
+    glReadPixels(viewport.x, viewport.y, viewport.w, viewport.h, format, GL_UNSIGNED_BYTE, image.pixels.data());
+}
 
-    // Since texture row in OpenGL start from bottom and goes up, we need to flip since image formats start from top to bottom.
-    stbi_flip_vertically_on_write(true);
+bool our::write_png(const std::string& filename, const Image& image) {
 
     // Make sure the directory in which we want to save screenshot exists. If not, create it.
     std::error_code ec;
     std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), ec);
     if(ec) return false;
 
+    // Since texture row in OpenGL start from bottom and goes up, we need to flip since image formats start from top to bottom.
+    // Instead of "stbi_flip_vertically_on_write" (a global flag, so it isn't safe when images are written from many threads),
+    // the rows are given from the last one with a negative stride.
+    int stride = image.size.x * image.components;
+    const std::uint8_t* last_row = image.pixels.data() + (size_t)stride * (image.size.y - 1);
     // Save image and return whether it succeeded or not
-    return stbi_write_png(filename.c_str(), viewport.w, viewport.h, components, data.data(), 0);
+    return stbi_write_png(filename.c_str(), image.size.x, image.size.y, image.components, last_row, -stride);
+}
+
+bool our::screenshot_png(const std::string& filename, bool include_alpha) {
+    Image image;
+    read_pixels(image, include_alpha);
+    return write_png(filename, image);
 }
@@ -1,10 +1,26 @@
 #ifndef GFX_LAB_SCREENSHOT_H
 #define GFX_LAB_SCREENSHOT_H
 
+#include <glm/vec2.hpp>
+
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace our {
 
+    // The pixels of an image in memory, 8 bits per channel. The rows are stored from the bottom to the top (as OpenGL reads them).
+    struct Image {
+        glm::ivec2 size = {0, 0};
+        int components = 0; // 3 for RGB, 4 for RGBA
+        std::vector<std::uint8_t> pixels;
+    };
+
+    // Reads the pixels of the current viewport from the bound read framebuffer
+    void read_pixels(Image& image, bool include_alpha = false);
+    // Writes the image to a png file (creating its directory if needed). Returns false if it failed.
+    bool write_png(const std::string& filename, const Image& image);
+
     bool screenshot_png(const std::string& filename, bool include_alpha = false);
 
 }
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include "../gl/state-cache.hpp"
+
+namespace our {
+
+    // This class defines an OpenGL texture which will be used as a GL_TEXTURE_2D_ARRAY
+    // All the layers of an array share the same size and format, so images with a matching size can be packed into one array
+    // and many materials can sample from it without binding a different texture per draw
+    class TextureArray {
+        // The OpenGL object name of this texture
+        GLuint name = 0;
+        // The size of each layer and the number of layers
+        glm::ivec2 size = {0, 0};
+        GLsizei layerCount = 0;
+        GLenum format = GL_RGBA8;
+    public:
+        // This constructor creates an OpenGL texture and allocates the storage of all its layers
+        TextureArray(glm::ivec2 size, GLsizei layerCount, GLsizei levels, GLenum format = GL_RGBA8)
+            : size(size), layerCount(layerCount), format(format) {
+            glGenTextures(1, &name);
+            bind();
+            glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, format, size.x, size.y, layerCount);
+        }
+
+        // This deconstructor deletes the underlying OpenGL texture
+        ~TextureArray() {
+            GLStateCache::current().onTextureDeleted(name);
+            glDeleteTextures(1, &name);
+        }
+
+        // Get the internal OpenGL name of the texture
+        GLuint getOpenGLName() const { return name; }
+        glm::ivec2 getSize() const { return size; }
+        GLsizei getLayerCount() const { return layerCount; }
+        GLenum getFormat() const { return format; }
+
+        // This method binds this texture to GL_TEXTURE_2D_ARRAY of the currently active texture unit
+        void bind() const {
+            GLStateCache::current().bindTexture(GL_TEXTURE_2D_ARRAY, name);
+        }
+
+        // This method binds this texture to GL_TEXTURE_2D_ARRAY of the given texture unit
+        // Nothing is sent to OpenGL if the texture is already bound to that unit
+        void bind(GLuint textureUnit) const {
+            GLStateCache::current().bindTexture(textureUnit, GL_TEXTURE_2D_ARRAY, name);
+        }
+
+        TextureArray(const TextureArray&) = delete;
+        TextureArray& operator=(const TextureArray&) = delete;
+    };
+
+    // A texture layer is how a material refers to an image:
+    // - If "array" is not null, the image is the layer "layer" in the texture array "array".
+    // - Otherwise, the image holds a single color so it was never uploaded and "color" is used instead.
+    struct TextureLayer {
+        TextureArray* array = nullptr;
+        GLint layer = -1;
+        glm::vec4 color = {0.0f, 0.0f, 0.0f, 1.0f};
+
+        bool isConstant() const { return array == nullptr; }
+    };
+
+}
@@ -1,9 +1,15 @@
 #include "texture-utils.hpp"
+#include "../profiling/cpu-profiler.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+#include <glm/glm.hpp>
+
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <utility>
 
 our::Texture2D *our::texture_utils::empty(GLenum format, glm::ivec2 size)
 {
@@ -19,6 +25,7 @@ our::Texture2D *our::texture_utils::empty(GLenum format, glm::ivec2 size)
 
 our::Texture2D *our::texture_utils::loadImage(const std::string &filename, bool generate_mipmap)
 {
+    PROFILE_ZONE("texture_utils::loadImage");
     glm::ivec2 size;
     int channels;
     // Since OpenGL puts the texture origin at the bottom left while images typically has the origin at the top left,
@@ -58,4 +65,86 @@ our::Texture2D *our::texture_utils::loadImage(const std::string &filename, bool
         glGenerateMipmap(GL_TEXTURE_2D); // Generate mipmaps for the target texture
     stbi_image_free(pixels); // Free image data after uploading to GPU
     return texture;
-}
\ No newline at end of file
+}
+
+// Checks if all the pixels in an RGBA8 image are (nearly) the same color. If so, the color is returned in "color".
+// A small tolerance is allowed since solid colors saved as JPEG may not decode to exactly the same value everywhere.
+static bool isSolidColor(const unsigned char *pixels, glm::ivec2 size, glm::vec4 &color)
+{
+    constexpr int tolerance = 2;
+    size_t pixelCount = (size_t)size.x * size.y;
+    for (size_t pixel = 1; pixel < pixelCount; ++pixel)
+        for (int channel = 0; channel < 4; ++channel)
+            if (std::abs((int)pixels[4 * pixel + channel] - (int)pixels[channel]) > tolerance)
+                return false;
+    color = glm::vec4(pixels[0], pixels[1], pixels[2], pixels[3]) / 255.0f;
+    return true;
+}
+
+std::unordered_map<std::string, our::TextureLayer *> our::texture_utils::loadImagesIntoArrays(
+    const std::unordered_map<std::string, std::string> &files, std::vector<TextureArray *> &arrays, bool generate_mipmap)
+{
+    PROFILE_ZONE("texture_utils::loadImagesIntoArrays");
+    std::unordered_map<std::string, TextureLayer *> layers;
+
+    // First, we read the image headers (without decoding the pixels) to group the images by size
+    // An ordered map is used so that the arrays are created in the same order every time
+    std::map<std::pair<int, int>, std::vector<std::pair<std::string, std::string>>> groups;
+    for (const auto &[name, path] : files)
+    {
+        glm::ivec2 size;
+        int channels;
+        if (!stbi_info(path.c_str(), &size.x, &size.y, &channels))
+        {
+            std::cerr << "Failed to load image: " << path << std::endl;
+            continue;
+        }
+        groups[{size.x, size.y}].push_back({name, path});
+    }
+
+    stbi_set_flip_vertically_on_load(true);
+    for (const auto &[key, group] : groups)
+    {
+        glm::ivec2 size = {key.first, key.second};
+
+        // Decode the images of this group. Solid colors become constants so they don't take a layer.
+        std::vector<std::pair<std::string, unsigned char *>> images;
+        for (const auto &[name, path] : group)
+        {
+            glm::ivec2 imageSize;
+            int channels;
+            unsigned char *pixels = stbi_load(path.c_str(), &imageSize.x, &imageSize.y, &channels, 4);
+            if (pixels == nullptr)
+            {
+                std::cerr << "Failed to load image: " << path << std::endl;
+                continue;
+            }
+            glm::vec4 color;
+            if (isSolidColor(pixels, imageSize, color))
+            {
+                layers[name] = new TextureLayer{nullptr, -1, color};
+                stbi_image_free(pixels);
+            }
+            else
+            {
+                images.push_back({name, pixels});
+            }
+        }
+        if (images.empty())
+            continue;
+
+        // Then allocate one array for all the remaining images and upload each of them to a layer
+        GLsizei levels = generate_mipmap ? (GLsizei)glm::floor(glm::log2((float)glm::max(size.x, size.y))) + 1 : 1;
+        auto *array = new TextureArray(size, (GLsizei)images.size(), levels);
+        for (GLint layer = 0; layer < (GLint)images.size(); ++layer)
+        {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size.x, size.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, images[layer].second);
+            stbi_image_free(images[layer].second);
+            layers[images[layer].first] = new TextureLayer{array, layer, glm::vec4(1.0f)};
+        }
+        if (generate_mipmap)
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        arrays.push_back(array);
+    }
+    return layers;
+}
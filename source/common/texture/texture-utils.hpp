@@ -1,7 +1,10 @@
 #pragma once
 
 #include "texture2d.hpp"
+#include "texture-array.hpp"
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/gl.h>
 #include <glm/vec2.hpp>
@@ -11,4 +14,9 @@ namespace our::texture_utils {
     Texture2D* empty(GLenum format, glm::ivec2 size);
     // This function loads an image and sends its data to the given Texture2D 
     Texture2D* loadImage(const std::string& filename, bool generate_mipmap = true);
+    // This function loads a set of images (given as {name: path}) into texture arrays where each array holds all the images that share the same size.
+    // Images that hold a single color are not uploaded at all, they are returned as constant colors instead.
+    // The created arrays are appended to "arrays". The caller owns the arrays and the returned layers.
+    std::unordered_map<std::string, TextureLayer*> loadImagesIntoArrays(const std::unordered_map<std::string, std::string>& files,
+                                                                       std::vector<TextureArray*>& arrays, bool generate_mipmap = true);
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <glad/gl.h>
 
+#include "../gl/state-cache.hpp"
+
 namespace our {
 
     // This class defined an OpenGL texture which will be used as a GL_TEXTURE_2D
@@ -22,6 +24,7 @@ namespace our {
         ~Texture2D() { 
             //TODO: (Req 5) Complete this function
             //Deletes the 1 texture created with name stored in "name" variable given here in the class
+            GLStateCache::current().onTextureDeleted(name);
             glDeleteTextures(1, &name);
         }
 
@@ -34,14 +37,20 @@ namespace our {
         void bind() const {
             //TODO: (Req 5) Complete this function
             //Here we create or use the texture created with "name" as a  2D texture
-            glBindTexture(GL_TEXTURE_2D, name);
+            GLStateCache::current().bindTexture(GL_TEXTURE_2D, name);
+        }
+
+        // This method binds this texture to GL_TEXTURE_2D of the given texture unit
+        // Nothing is sent to OpenGL if the texture is already bound to that unit
+        void bind(GLuint textureUnit) const {
+            GLStateCache::current().bindTexture(textureUnit, GL_TEXTURE_2D, name);
         }
 
         // This static method ensures that no texture is bound to GL_TEXTURE_2D
         static void unbind(){
             //TODO: (Req 5) Complete this function
             //Here we unbind or remove all 2D textures
-            glBindTexture(GL_TEXTURE_2D, 0);
+            GLStateCache::current().bindTexture(GL_TEXTURE_2D, 0);
         }
 
         Texture2D(const Texture2D&) = delete;
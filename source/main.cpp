@@ -1,5 +1,6 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <flags/flags.h>
 #include <json/json.hpp>
 
@@ -19,6 +20,7 @@
 #include "states/light-test-state.hpp"
 #include "states/end-state.hpp"
 #include "states/lost-state.hpp"
+#include "states/synthetic-state.hpp"
 
 int main(int argc, char** argv) {
     
@@ -30,6 +32,43 @@ int main(int argc, char** argv) {
     // This is useful for testing multiple configurations in a batch
     // Default: 0 where the application runs indefinitely until manually closed
     int run_for_frames = args.get<int>("f", 0);
+    // trace is the path of a Chrome trace (chrome://tracing) of the CPU profiler zones
+    // trace-frames is the range of frames to include in the trace as "first:last" (frame 0 includes the startup)
+    // Default: no trace. If only the path is given, the first 300 frames are traced.
+    std::string trace_path = args.get<std::string>("trace", "");
+    std::string trace_frames = args.get<std::string>("trace-frames", "0:299");
+    // headless runs without a window (and without a display): the frames are rendered offscreen, screenshots still work
+    // This is meant for running the tests & benchmarks on machines without a display (combine it with -f to stop after some frames)
+    bool headless = args.get<bool>("headless", false);
+    // gl picks the OpenGL backend: "driver" (default) or "null" which renders nothing and only validates & counts the OpenGL calls
+    // The null backend needs no GPU nor display, so it is used to measure the CPU side of the engine (it implies running without a window)
+    std::string gl_backend = args.get<std::string>("gl", "driver");
+    // bench runs the config as a benchmark: a warmup then a fixed number of measured frames with a fixed time step (and an optional
+    // scripted camera path), then a JSON report of the frame times is written. The settings are in "benchmark" in the config.
+    // bench-report overrides the path of the report. Use it with --headless or --gl=null to benchmark without a display.
+    bool bench = args.get<bool>("bench", false);
+    std::string bench_report = args.get<std::string>("bench-report", "");
+    // record writes the frames to a PNG sequence (if the path is a directory) or a raw Y4M video (if the path ends with .y4m)
+    // The other settings (e.g. record every Nth frame, a fixed time step, the encoder threads) are in "recording" in the config
+    std::string record_path = args.get<std::string>("record", "");
+    // shader-cache keeps the linked shader programs as driver binaries in the given directory (e.g. --shader-cache=cache/shaders),
+    // so the next runs load them instead of compiling the shaders. It can also be enabled by "shaderCache" in the config.
+    std::string shader_cache = args.get<std::string>("shader-cache", "");
+    // synthetic changes the settings of the scene generator used by the "synthetic" state as a list of key=value separated by commas
+    // (e.g. --synthetic=entities=100000,depth=3). Together with --bench, it is how the scaling curves of the engine are measured.
+    // generate writes the generated scene (assets & world) as a config at the given path then exits without running anything.
+    // The rest of the config (e.g. the renderer & the benchmark settings) is copied from the config given with -c.
+    std::string synthetic = args.get<std::string>("synthetic", "");
+    std::string generate_path = args.get<std::string>("generate", "");
+    // batch runs all the configs listed in the given batch file in one process (reusing one context), then compares the screenshots
+    // they requested to the expected ones (see "Application::runBatch"). The exit code is the number of mismatches.
+    // batch-groups only runs the groups of the batch with the given names separated by commas (e.g. --batch-groups=mesh-test,sky-test)
+    // Combine it with --headless to run the tests without a display. -c and -f are ignored since the batch lists the configs & frames.
+    std::string batch_path = args.get<std::string>("batch", "");
+    std::string batch_groups = args.get<std::string>("batch-groups", "");
+
+    // In batch mode, the config is the batch file instead of an application config
+    if(!batch_path.empty()) config_path = batch_path;
 
     // Open the config file and exit if failed
     std::ifstream file_in(config_path);
@@ -41,8 +80,32 @@ int main(int argc, char** argv) {
     nlohmann::json app_config = nlohmann::json::parse(file_in, nullptr, true, true);
     file_in.close();
 
+    if(batch_path.empty() && (!synthetic.empty() || !generate_path.empty())){
+        our::SceneGenerator generator;
+        if(app_config.contains("scene") && app_config["scene"].contains("generator"))
+            generator.deserialize(app_config["scene"]["generator"]);
+        if(!generator.parse(synthetic)) return -1;
+        app_config["scene"]["generator"] = generator.serialize();
+        if(!generate_path.empty()){
+            generator.generate();
+            if(!generator.writeConfig(generate_path, app_config)) return -1;
+            std::cout << "Wrote a synthetic scene of " << generator.getNodes().size() << " entities to " << generate_path << std::endl;
+            return 0;
+        }
+    }
+
     // Create the application
     our::Application app(app_config);
+    app.setHeadless(headless);
+    if(gl_backend == "null"){
+        app.setGLBackend(our::GLBackend::Null);
+    } else if(gl_backend != "driver"){
+        std::cerr << "Unknown OpenGL backend (expected driver or null): " << gl_backend << std::endl;
+        return -1;
+    }
+    if(bench) app.enableBenchmark(bench_report);
+    if(!record_path.empty()) app.enableRecording(record_path);
+    if(!shader_cache.empty()) app.enableShaderCache(shader_cache);
     
     // Register all the states of the project in the application
     app.registerState<Menustate>("menu");
@@ -59,8 +122,33 @@ int main(int argc, char** argv) {
     app.registerState<Lightstate>("light-test");
     app.registerState<EndState>("end");
     app.registerState<LostState>("lost");
+    app.registerState<SyntheticState>("synthetic");
+
+    if(!batch_path.empty()){
+        std::vector<std::string> groups;
+        std::istringstream names(batch_groups);
+        for(std::string name; std::getline(names, name, ',');)
+            if(!name.empty()) groups.push_back(name);
+        return app.runBatch(app_config, groups);
+    }
+
+    // If a trace was requested, parse its range of frames
+    if(!trace_path.empty()){
+        int first_frame = 0, last_frame = 299;
+        char separator;
+        std::istringstream range(trace_frames);
+        if(!(range >> first_frame >> separator >> last_frame) || separator != ':' || first_frame > last_frame){
+            std::cerr << "Invalid trace frame range (expected first:last): " << trace_frames << std::endl;
+            return -1;
+        }
+        app.captureTrace(trace_path, first_frame, last_frame);
+    }
+
     // Then choose the state to run based on the option "start-scene" in the config
-    if(app_config.contains(std::string{"start-scene"})){
+    // A benchmark can pick another scene (e.g. to skip the menu and benchmark the game itself)
+    if(bench && app_config.contains("benchmark") && app_config["benchmark"].contains("scene")){
+        app.changeState(app_config["benchmark"]["scene"].get<std::string>());
+    } else if(app_config.contains(std::string{"start-scene"})){
         app.changeState(app_config["start-scene"].get<std::string>());
     }
 
@@ -39,6 +39,7 @@ class Lightstate: public our::State {
     }
 
     void onDestroy() override {
+        renderer.destroy();
         world.clear();
         our::clearAllAssets();
     }
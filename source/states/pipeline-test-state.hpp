@@ -68,15 +68,15 @@ class PipelineTestState: public our::State {
         }
         // We also read the clear color and depth since we may want to change it
         glm::vec4 clearColor = config.value("clearColor", glm::vec4(0, 0, 0, 0));
-        glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
-        glClearDepth(config.value("clearDepth", 1.0f));
+        our::GLStateCache::current().setClearColor(clearColor);
+        our::GLStateCache::current().setClearDepth(config.value("clearDepth", 1.0f));
     }
 
     void onDraw(double deltaTime) override {
         // We make sure the color and depth masks are true (just in case the pipeline set any of them to false)
         // to make sure that glClear works correctly
-        glColorMask(true, true, true, true);
-        glDepthMask(true);
+        our::GLStateCache::current().setColorMask(glm::bvec4(true, true, true, true));
+        our::GLStateCache::current().setDepthMask(true);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shader->use();
         // Before drawing, we setup the pipeline state
@@ -8,7 +8,13 @@
 #include <systems/movement.hpp>
 #include <systems/collision.hpp>
 #include <asset-loader.hpp>
+#include <profiling/performance-hud.hpp>
+#include <profiling/cpu-profiler.hpp>
+#include <profiling/benchmark.hpp>
+#include <jobs/worker-thread.hpp>
 #include <imgui.h>
+#include <chrono>
+#include <memory>
 #include <string>
 
 // This state shows how to use the ECS framework and deserialization.
@@ -26,6 +32,32 @@ class Playstate : public our::State
     // variable to wait for a certain time if the object collided before disabling the postprocess effect
     int waitFor = 0;
 
+    // The performance overlay (toggled with F2)
+    our::PerformanceHUD performanceHUD;
+
+    // In pipelined mode ("pipelined": true in the scene config), the simulation of a frame runs on a separate thread
+    // and produces a frame packet while the main thread (which owns the OpenGL context and polls the GLFW events)
+    // draws the packet of the previous frame. This way, a frame costs max(simulation, rendering) instead of their sum
+    // at the cost of one frame of latency. Two packets are used: one is being built while the other is being drawn.
+    // The first packet is built while the state is initialized, so the first frame already draws the initial world.
+    // Because of the latency, the frame N shows the world after N updates instead of N + 1, so the screenshots & recordings
+    // of a pipelined run are one update behind those of a normal run.
+    std::unique_ptr<our::WorkerThread> simulationThread;
+    our::FramePacket packets[2];
+    int builtPacket = 0;
+    // The CPU time of the simulation on its thread (it is recorded in the HUD once the thread is done)
+    float simulationTime = 0;
+
+    // Runs the systems that update the world logic except the camera controller (which locks the mouse through GLFW
+    // so it must stay on the main thread). Returns true if the collision system detected a collision.
+    bool simulate(double deltaTime)
+    {
+        movementSystem.update(&world, (float)deltaTime);
+        bool collided = collisionSystem.update(&world);
+        world.deleteMarkedEntities();
+        return collided;
+    }
+
     void onInitialize() override
     {
         // First of all, we get the scene configuration from the app config
@@ -46,17 +78,95 @@ class Playstate : public our::State
         // Then we initialize the renderer
         auto size = getApp()->getFrameBufferSize();
         renderer.initialize(size, config["renderer"]);
+        // The impostors are pictures of the meshes of the world, so they can only be baked once the world is loaded
+        renderer.bakeImpostors(&world);
+        renderer.buildStaticBatches(&world);
+        if (config.value("pipelined", false))
+        {
+            simulationThread = std::make_unique<our::WorkerThread>("simulation");
+            // The first frame draws the packet of the previous frame, so that packet is built from the initial world here
+            // (a default packet has no camera, so nothing would be drawn, not even the clear of the backbuffer)
+            renderer.buildPacket(&world, packets[1 - builtPacket]);
+        }
+        // The HUD settings (e.g. the hitch threshold) are in the app config since they are not specific to a scene
+        if (getApp()->getConfig().contains("performanceHud"))
+            performanceHUD.deserialize(getApp()->getConfig()["performanceHud"]);
     }
 
-    void onDraw(double deltaTime) override
+    // In benchmark mode, the camera follows the benchmark's path (if it has one) instead of the user input
+    void updateCamera(double deltaTime)
     {
-        // Here, we just run a bunch of systems to control the world logic
-        movementSystem.update(&world, (float)deltaTime);
-        cameraController.update(&world, (float)deltaTime, &renderer);
-        bool collided = collisionSystem.update(&world);
+        our::Benchmark *benchmark = getApp()->getBenchmark();
+        if (benchmark && benchmark->hasCameraPath())
+            benchmark->moveCamera(&world);
+        else
+            cameraController.update(&world, (float)deltaTime, &renderer);
+    }
 
-        // And finally we use the renderer system to draw the scene
-        world.deleteMarkedEntities();
+    void onDraw(double deltaTime) override
+    {
+        performanceHUD.beginFrame(deltaTime);
+        bool collided;
+        if (simulationThread)
+        {
+            // The camera controller runs first on the main thread, then the world is handed over to the simulation thread
+            {
+                our::PerformanceHUD::ScopedTimer timer(performanceHUD, "FreeCameraControllerSystem");
+                updateCamera(deltaTime);
+            }
+            our::FramePacket &next = packets[builtPacket];
+            const our::FramePacket &previous = packets[1 - builtPacket];
+            simulationThread->start([this, deltaTime, &next, &collided]()
+                                    {
+                PROFILE_ZONE("Playstate::simulate");
+                auto start = std::chrono::steady_clock::now();
+                collided = simulate(deltaTime);
+                renderer.buildPacket(&world, next);
+                simulationTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count(); });
+
+            // Meanwhile, we draw the packet built in the previous frame
+            renderer.updateDynamicResolution(deltaTime);
+            {
+                our::PerformanceHUD::ScopedTimer timer(performanceHUD, "ForwardRenderer::submit");
+                renderer.submit(previous);
+            }
+            {
+                our::PerformanceHUD::ScopedTimer timer(performanceHUD, "Wait for simulation");
+                simulationThread->wait();
+            }
+            performanceHUD.recordSystem("Simulation (thread)", simulationTime);
+            builtPacket = 1 - builtPacket;
+        }
+        else
+        {
+            // Here, we just run a bunch of systems to control the world logic (each of them is timed for the performance HUD)
+            {
+                our::PerformanceHUD::ScopedTimer timer(performanceHUD, "MovementSystem");
+                movementSystem.update(&world, (float)deltaTime);
+            }
+            {
+                our::PerformanceHUD::ScopedTimer timer(performanceHUD, "FreeCameraControllerSystem");
+                updateCamera(deltaTime);
+            }
+            {
+                our::PerformanceHUD::ScopedTimer timer(performanceHUD, "CollisionSystem");
+                collided = collisionSystem.update(&world);
+            }
+
+            // And finally we use the renderer system to draw the scene
+            world.deleteMarkedEntities();
+
+            // Let the renderer adapt its resolution to the frame time (if dynamic resolution is enabled in the config)
+            renderer.updateDynamicResolution(deltaTime);
+            {
+                our::PerformanceHUD::ScopedTimer timer(performanceHUD, "ForwardRenderer");
+                renderer.render(&world);
+            }
+        }
+        performanceHUD.endFrame(&world, &renderer);
+        // The benchmark report gets the same per-system times and counters as the HUD
+        if (our::Benchmark *benchmark = getApp()->getBenchmark())
+            benchmark->recordFrame(performanceHUD.getLastFrame());
 
         // Check if the update function of the collision component
         if(collided == true)
@@ -79,8 +189,6 @@ class Playstate : public our::State
             waitFor++; 
         }
 
-        renderer.render(&world);
-
         // Get a reference to the keyboard object
         auto &keyboard = getApp()->getKeyboard();
 
@@ -89,6 +197,10 @@ class Playstate : public our::State
             // If the escape  key is pressed in this frame, go to the play state
             getApp()->changeState("menu");
         }
+        if (keyboard.justPressed(GLFW_KEY_F2))
+        {
+            performanceHUD.visible = !performanceHUD.visible;
+        }
     }
 
 
@@ -112,10 +224,15 @@ class Playstate : public our::State
         ImGui::TextColored(ImVec4(1.0f, 1.0, 1.0f, 1.0f), lives_screen.c_str());
         // end gui
         ImGui::End();
+
+        // Show the frame statistics (only drawn if visible)
+        performanceHUD.draw(&renderer);
     }
 
     void onDestroy() override
     {
+        // The simulation thread must be stopped before the world is cleared
+        simulationThread.reset();
         // Don't forget to destroy the renderer
         renderer.destroy();
         // On exit, we call exit for the camera controller system to make sure that the mouse is unlocked
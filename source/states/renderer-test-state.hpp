@@ -28,6 +28,8 @@ class RendererTestState: public our::State {
 
         glm::ivec2 size = getApp()->getFrameBufferSize();
         renderer.initialize(size, config["renderer"]);
+        // The game only applies its postprocess effects on events, but a test always applies the first one it configures
+        renderer.postprocessEffect = config["renderer"].contains("postprocess");
     }
 
     void onDraw(double deltaTime) override {
@@ -36,6 +38,7 @@ class RendererTestState: public our::State {
     }
 
     void onDestroy() override {
+        renderer.destroy();
         world.clear();
         our::clearAllAssets();
     }
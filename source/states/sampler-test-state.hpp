@@ -52,8 +52,7 @@ class SamplerTestState: public our::State {
         glClear(GL_COLOR_BUFFER_BIT);
         shader->use();
         // Here we set the active texture unit to 0 then bind the texture to it
-        glActiveTexture(GL_TEXTURE0);
-        texture->bind();
+        texture->bind(0);
         // Then we bind the sampler to unit 0
         sampler->bind(0);
         // Then we send 0 (the index of the texture unit we used above) to the "tex" uniform
@@ -46,7 +46,7 @@ class ShaderTestState: public our::State {
         glGenVertexArrays(1, &vertex_array);
 
         // We set the clear color to be black
-        glClearColor(0.0, 0.0, 0.0, 1.0);
+        our::GLStateCache::current().setClearColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
     }
 
     void onDraw(double deltaTime) override {
@@ -54,12 +54,13 @@ class ShaderTestState: public our::State {
         glClear(GL_COLOR_BUFFER_BIT);
         // Use the shader then draw the mesh
         shader->use();
-        glBindVertexArray(vertex_array);
+        our::GLStateCache::current().bindVertexArray(vertex_array);
         glDrawArrays(GL_TRIANGLES, 0, 3);
     }
 
     void onDestroy() override {
         delete shader;
+        our::GLStateCache::current().onVertexArrayDeleted(vertex_array);
         glDeleteVertexArrays(1, &vertex_array);
     }
 };
\ No newline at end of file
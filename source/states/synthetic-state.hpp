@@ -0,0 +1,114 @@
+#pragma once
+
+#include <application.hpp>
+
+#include <ecs/world.hpp>
+#include <systems/forward-renderer.hpp>
+#include <systems/free-camera-controller.hpp>
+#include <systems/movement.hpp>
+#include <asset-loader.hpp>
+#include <profiling/performance-hud.hpp>
+#include <profiling/benchmark.hpp>
+#include <profiling/scene-generator.hpp>
+#include <chrono>
+#include <iostream>
+
+// This state shows a synthetic scene to measure how the engine scales with the size of the scene (see "SceneGenerator").
+// The scene is generated from the settings in "generator" in the scene config, unless the config has a "world" (e.g. a scene
+// written by "--generate") in which case it is loaded like any other scene. There is no game logic: the spinning entities move,
+// the camera is free (or follows the benchmark path) and the renderer draws everything. The performance HUD is toggled with F2.
+class SyntheticState : public our::State
+{
+
+    our::World world;
+    our::ForwardRenderer renderer;
+    our::FreeCameraControllerSystem cameraController;
+    our::MovementSystem movementSystem;
+    our::PerformanceHUD performanceHUD;
+
+    void onInitialize() override
+    {
+        auto &config = getApp()->getConfig()["scene"];
+        our::SceneGenerator generator;
+        if (config.contains("generator"))
+            generator.deserialize(config["generator"]);
+
+        auto start = std::chrono::steady_clock::now();
+        if (config.contains("world"))
+        {
+            if (config.contains("assets"))
+                our::deserializeAllAssets(config["assets"]);
+            world.deserialize(config["world"]);
+        }
+        else
+        {
+            generator.generate();
+            our::deserializeAllAssets(generator.getAssets());
+            generator.populate(&world);
+        }
+        float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Synthetic scene: " << world.getEntities().size() << " entities created in " << milliseconds << " ms" << std::endl;
+
+        cameraController.enter(getApp());
+        auto size = getApp()->getFrameBufferSize();
+        renderer.initialize(size, config["renderer"]);
+        renderer.bakeImpostors(&world);
+        renderer.buildStaticBatches(&world);
+        if (getApp()->getConfig().contains("performanceHud"))
+            performanceHUD.deserialize(getApp()->getConfig()["performanceHud"]);
+
+        // The report describes the scene so that the runs of a scaling test can be told apart
+        if (our::Benchmark *benchmark = getApp()->getBenchmark())
+        {
+            benchmark->setDefaultCameraPath(generator.getCameraPath());
+            nlohmann::json description = generator.serialize();
+            description["worldEntities"] = world.getEntities().size();
+            description["loadTime"] = milliseconds;
+            benchmark->setSceneDescription(description);
+        }
+    }
+
+    void onDraw(double deltaTime) override
+    {
+        performanceHUD.beginFrame(deltaTime);
+        {
+            our::PerformanceHUD::ScopedTimer timer(performanceHUD, "MovementSystem");
+            movementSystem.update(&world, (float)deltaTime);
+        }
+        {
+            our::PerformanceHUD::ScopedTimer timer(performanceHUD, "FreeCameraControllerSystem");
+            our::Benchmark *benchmark = getApp()->getBenchmark();
+            if (benchmark && benchmark->hasCameraPath())
+                benchmark->moveCamera(&world);
+            else
+                cameraController.update(&world, (float)deltaTime, &renderer);
+        }
+        renderer.updateDynamicResolution(deltaTime);
+        {
+            our::PerformanceHUD::ScopedTimer timer(performanceHUD, "ForwardRenderer");
+            renderer.render(&world);
+        }
+        performanceHUD.endFrame(&world, &renderer);
+        if (our::Benchmark *benchmark = getApp()->getBenchmark())
+            benchmark->recordFrame(performanceHUD.getLastFrame());
+
+        auto &keyboard = getApp()->getKeyboard();
+        if (keyboard.justPressed(GLFW_KEY_ESCAPE))
+            getApp()->close();
+        if (keyboard.justPressed(GLFW_KEY_F2))
+            performanceHUD.visible = !performanceHUD.visible;
+    }
+
+    void onImmediateGui() override
+    {
+        performanceHUD.draw(&renderer);
+    }
+
+    void onDestroy() override
+    {
+        renderer.destroy();
+        cameraController.exit();
+        world.clear();
+        our::clearAllAssets();
+    }
+};